@@ -2,6 +2,21 @@
 
 #include <SFML/Graphics.hpp>
 #include <vector>
+#include "../src/math/Rot2.hpp"
+#include "../src/math/Fixed.hpp"
+#include "../src/gait/GaitScheduler.hpp"
+#include "../src/gait/Cpg.hpp"
+#include "../src/gait/Locomotion.hpp"
+#include "../src/anim/GaitClip.hpp"
+#include "../src/morph/Kernels.hpp"
+#include "../src/morph/BodyMask.hpp"
+#include "../src/pose/PoseBuffer.hpp"
+#include "../src/lod/SimLod.hpp"
+#include "../src/physics/Xpbd.hpp"
+#include "../src/physics/Articulated.hpp"
+#include "../src/physics/Occupancy.hpp"
+#include "../src/spine/PathHistory.hpp"
+#include "../src/terrain/Heightfield.hpp"
 
 // Joint limits (radians) shared across modules.
 // These are enforced by the IK solver and gait code. Values are in radians.
@@ -17,8 +32,13 @@ inline constexpr float kHipPitchMin = -1.25f;
 inline constexpr float kHipPitchMax =  0.15f;
 inline constexpr float kKneeMin     = -2.00f;
 inline constexpr float kKneeMax     = -0.05f;
+// Ankle (foot link relative to the knee link); only bent by the n-link chain solver.
+inline constexpr float kAnkleMin    = -0.90f;
+inline constexpr float kAnkleMax    =  0.50f;
 // Hip yaw (horizontal plane) limit: allow up to 120° sweep total (±60°)
 inline constexpr float kHipYawMaxDelta = 1.04719755f; // pi/3 (≈ 60°)
+// Same limit as a unit rotation (cos, sin of kHipYawMaxDelta) for dot/cross checks.
+inline constexpr math::Rot2 kHipYawLimit{0.5f, 0.86602540f};
 
 // Geometry defaults shared across modules
 // Units: grid/tile units for X/Y/Z distances. These are nominal lengths used
@@ -26,43 +46,73 @@ inline constexpr float kHipYawMaxDelta = 1.04719755f; // pi/3 (≈ 60°)
 // rendering but the kinematic lengths operate in grid units.
 inline constexpr float kStanceWidth = 1.0f;   // lateral offset from spine to hip attach
 inline constexpr float kCoxaLength = 1.4f;    // distance from hip attach to hip joint
+// Body suspension: rest height above the ground plane (z=0). Low, so the body rides
+// low (belly sliding).
+inline constexpr float kBodyRestZ = 0.6f;
 
+// Gait time advance per tick: a slow idle cadence plus radians per grid unit the head moved.
+inline constexpr float kIdleGaitAdvance = 0.015f;
+inline constexpr float kGaitPerUnit = 5.55f;
+
+// Silhouette cell (unrotated rest offset from the segment), position and velocity (per
+// tick), in 16.16 fixed-point grid units (math::Fixed): the cell a voxel occupies is
+// math::fixedCell(wx), fixedCell(wy). The rest offset at the segment's heading comes
+// from the body's morph::BodyMask.
 struct Voxel {
-    float baseOx, baseOy;
-    float wx, wy;
-    float vx, vy;
-    uint8_t filled;
+    math::Fixed baseOx, baseOy;
+    math::Fixed wx, wy;
+    math::Fixed vx, vy;
 };
 
 struct Segment {
     float x, y;
     float px, py;
-    float angle;
+    // Heading as a unit direction (cos, sin); see math::Rot2.
+    math::Rot2 heading;
     sf::Color color;
+    // Silhouette box, and a voxel per filled cell only, in the layout order of the body's
+    // morph::BodyMask (empty cells have no voxel, so voxel loops need no filled test).
     int voxW, voxH;
     std::vector<Voxel> voxels;
     bool moved;
+    // Voxel sleep: ticks the voxels have been at rest, whether the soft-body pass skips
+    // them, and the segment position the sleep check last saw (moving it wakes them).
+    int restTicks;
+    bool asleep;
+    float sleepX, sleepY;
+    // Suspension: body height above the ground at this segment, from its own planted
+    // legs (smoothed over time and along the spine). Hips, spine and leg reach use it.
+    float bodyZ;
     struct Leg {
         // hipOx/hipOy : local offset of hip attachment relative to the segment
         float hipOx, hipOy;
         // side : -1 or +1 for left/right legs (helps orient coxa offset)
         int side;
 
-        // Current joint angles (radians): these are the solved output from IK
-        // - `hipAngle` : yaw (rotation around vertical axis) or primary hip angle
-        // - `kneeAngle`: pitch of the hip link (positive upward in our convention)
-        // - `footAngle`: additional pitch added at the foot/ankle joint
-        float hipAngle, kneeAngle, footAngle;
+        // Current joint state: the solved output from IK
+        // - `hipYaw`   : yaw (rotation around vertical axis) as a unit direction (cos, sin)
+        // - `kneeAngle`: pitch of the hip link in radians (positive upward in our convention)
+        // - `footAngle`: additional pitch added at the foot/ankle joint (radians)
+        math::Rot2 hipYaw;
+        float kneeAngle, footAngle;
+        // - `ankleAngle`: pitch of the foot link relative to the knee link (0 = straight)
+        float ankleAngle;
 
-        // Target angles that the IK/gait attempt to approach (used for smoothing)
-        float targetHipAngle, targetKneeAngle, targetFootAngle;
+        // Target angles that the IK/gait attempt to approach (used for smoothing).
+        // The last unsmoothed solution; the chain solver warm-starts from it.
+        math::Rot2 targetHipYaw;
+        float targetKneeAngle, targetFootAngle, targetAnkleAngle;
 
         // Gait timing parameters
         float phaseOffset; // per-leg phase offset (0..1) for metachronal waves
         float cycle;       // current normalized cycle phase (0..1)
+        // Leg-driven only: how far this leg's clock runs ahead of its metachronal slot
+        // after an early lift (see gait::updateGaitDriven); relaxes back to 0.
+        float phaseLead;
 
-        // world-space foot anchor used when the foot is planted on ground
-        float footHoldX, footHoldY;
+        // world-space foot anchor used when the foot is planted on ground; footHoldZ is
+        // the ground height there (0 on the flat plane)
+        float footHoldX, footHoldY, footHoldZ;
 
         // swingPhase: 0..1 progress through the swing motion (1 -> landing)
         float swingPhase;
@@ -70,8 +120,10 @@ struct Segment {
         // Cached positions used to prevent foot sliding while planted:
         // - swingStartX/Y : foot position at the moment the leg entered swing
         // - swingLandX/Y  : precomputed landing target for the current swing.
-        float swingStartX, swingStartY;
+        float swingStartX, swingStartY, swingStartZ;
         float swingLandX, swingLandY;
+        // Last terrain sample at this leg's landing target (see terrain::Heightfield::sampleCached).
+        terrain::SampleCache groundCache;
 
         // Link lengths in grid units (used by IK and for drawing FK)
         float hipLength, kneeLength, footLength;
@@ -79,14 +131,36 @@ struct Segment {
         // Ground interaction and pushing
         float pushStrength; // how strongly this leg pushes the body when planted
         bool onGround;      // true when foot is considered planted
+        // Ground reaction force on the body from the last gait step: pushStrength times the
+        // planted hold's offset from where the stance sweep puts the foot (zero in swing).
+        // Moves the body in leg-driven locomotion.
+        float groundForceX, groundForceY;
 
         // Coxa: short link from the body/spine out to the hip joint.
         // This is separate from `hipLength` which is the first major leg segment.
         float coxaLength;
+
+        // Lazy IK bookkeeping: inputs used by the last solve (foot hold, coxa attach,
+        // body height, yaw reference) and whether the smoothed angles have settled.
+        // While both hold, `ik::solveLegLazy` skips the leg.
+        float ikFootX, ikFootY;
+        float ikAttachX, ikAttachY;
+        float ikBodyZ;
+        math::Rot2 ikYawRef;
+        bool ikConverged;
     };
     std::vector<Leg> legs;
 };
 
+// What an idle centipede does once its pose has settled: a slow breathing bob of the
+// body, or nothing at all.
+enum class IdleMode { Breathe, Freeze };
+
+// How the spine and voxels respond to the head: the original follow lerps, voxel springs
+// and pushes; an XPBD solve (spine distance, voxel shape matching and contacts); or an
+// articulated spine steered by its head and driven by the planted legs (voxels on springs).
+enum class BodyDynamics { Springs, Xpbd, Articulated };
+
 class Centipede {
 private:
     std::vector<Segment> segments;
@@ -96,15 +170,150 @@ private:
     static constexpr float followSpeed = 0.28f;
     static constexpr float maxMovePerTry = 1.2f;
     float gaitTime;
-    float lastHeadX, lastHeadY;
+    // Head displacement since the last tick, summed from the steps the head was given (a
+    // difference of positions would carry their rounding, which grows with the distance
+    // from the origin, into the gait clock).
+    float headStepX = 0.f, headStepY = 0.f;
     // Last applied head movement delta (grid units). Used to align gait to travel direction.
     float lastMoveDx = 0.0f;
     float lastMoveDy = 0.0f;
+    // Event-driven gait: only legs that change state or are swinging are touched per tick.
+    gait::GaitScheduler gaitScheduler;
+    // Optional CPG gait: when attached, leg phases come from this body in a shared network.
+    gait::CpgNetwork *cpg = nullptr;
+    uint32_t cpgBody = 0;
+    // IK pass specialized for this centipede's leg morphology (selected at construction).
+    morph::IkPassKernel ikPassKernel = nullptr;
+    // Segment collision shape at every quantized heading (shared per silhouette).
+    const morph::BodyMask *bodyMask = nullptr;
+    // Voxel occupancy (owners from physics::Occupancy::packOwner), refilled by the head
+    // move and the voxel ejection each tick; kept to reuse its storage.
+    physics::Occupancy occupancy;
+    // Lazy IK counters for the last update() (legs solved vs. skipped as unchanged).
+    size_t ikSolvedLastTick = 0;
+    size_t ikSkippedLastTick = 0;
+    // Voxel sleep counters for the last update() (segments simulated vs. skipped).
+    size_t voxelAwakeLastTick = 0;
+    size_t voxelAsleepLastTick = 0;
+    // World-space joint positions, rebuilt once per update() after IK.
+    pose::PoseBuffer pose;
+    // Full gait + IK, or baked clip playback at the smoothed head speed.
+    anim::LegAnimation legAnimation = anim::LegAnimation::Full;
+    float animSpeed = 0.f;
+    int clipBlendTicks = 0;
+    // Simulation level of detail. `tierTick` staggers reduced-tier IK ticks across bodies;
+    // `snapLegs` makes the next IK solve land exactly (legs resuming from the ghost tier).
+    lod::SimTier simTier = lod::SimTier::Full;
+    uint32_t tierTick = 0;
+    bool snapLegs = false;
+    // Idle fast path: after a while without head movement the gait stops and swinging
+    // legs land (Settling); once the IK has settled, update() only plays the breath
+    // (Idle). Any input or tier / animation change wakes the body.
+    enum class IdleState : uint8_t { Active, Settling, Idle };
+    IdleState idleState = IdleState::Active;
+    IdleMode idleMode = IdleMode::Breathe;
+    int stillTicks = 0;
+    bool legsConverged = false;
+    float breathPhase = 0.f;
+    float breathOffset = 0.f;
+    // XPBD body: particle 0..n-1 are the segments (the head kinematic), then the
+    // voxels of every segment in order. Only used in the full tier.
+    BodyDynamics bodyDynamics = BodyDynamics::Springs;
+    physics::XpbdParams xpbdParams;
+    physics::XpbdSolver xpbd;
+    // Leg-driven locomotion: walking command (pending moves, smoothed per tick), the
+    // ground forces of the last gait step, and the foot-slip measure with its last feet.
+    gait::Locomotion locomotion = gait::Locomotion::Kinematic;
+    float pendingDriveX = 0.f, pendingDriveY = 0.f;
+    float driveX = 0.f, driveY = 0.f;
+    gait::GroundForces groundForces;
+    gait::FootSlip footSlip;
+    std::vector<float> slipFootX, slipFootY;
+    std::vector<uint8_t> slipPlanted;
+    // Suspension scratch per segment: summed ground heights and clearances of the planted
+    // holds, and the planted-leg count.
+    std::vector<float> supportGround, supportClearance, supportLegs;
+    // Articulated spine: one link per segment; moves set the head's target. Full tier only.
+    physics::ChainParams chainParams;
+    physics::ArticulatedChain chain;
+    // Head path history: followers sit at fixed arc lengths behind the head. Stale when
+    // the followers were placed by something else (XPBD, construction) and the path must
+    // be re-seeded from the spine before the next move.
+    spine::PathHistory headPath;
+    bool headPathStale = true;
+
+    void animateLegsFull(float gaitAdvance, float headMove, bool solveIk);
+    void animateLegsBaked(float gaitAdvance, float headMove);
+    void moveHead(float dx, float dy);
+    // Head move without voxel collision, for the reduced and ghost tiers.
+    void moveSpine(float dx, float dy);
+    // Voxel soft-body springs and occupancy ejection (full tier only).
+    void updateVoxels();
+    // Put every voxel back at rest on its segment (on promotion to the full tier).
+    void restVoxels();
+    void updateIdle();
+    void wakeFromIdle();
+    bool xpbdActive() const;
+    // Record the head's move on the path and place the followers on it.
+    void followHeadPath(float oldHeadX, float oldHeadY);
+    void buildXpbd();
+    void syncXpbd();
+    void stepXpbd();
+    bool chainActive() const;
+    // Leg-driven locomotion applies outside the ghost tier, with full leg animation and no
+    // articulated spine (which has its own leg forces).
+    bool legDriven() const;
+    void driveFromLegs();
+    void measureFootSlip();
+    void buildChain();
+    void stepChain();
 public:
-    Centipede(int startX, int startY, int length);
+    // Segments of the given silhouette (the 3x3 diamond by default), spaced by its width.
+    Centipede(int startX, int startY, int length, const morph::Silhouette &silhouette = morph::Silhouette::diamond(3));
     void update();
     void tryMove(float dx, float dy);
     void moveBy(float dx, float dy);
     void render(sf::RenderWindow* window, float resf);
     const std::vector<Segment>& getSegments() const;
+    // Joint positions from the last update() (read by the renderer and telemetry).
+    const pose::PoseBuffer& getPose() const;
+    // Fraction of legs whose IK was skipped last tick (0 = all solved, 1 = all skipped).
+    float getIkSkipRatio() const;
+    // Segments whose voxels were simulated / skipped as asleep last tick (both zero
+    // outside the full tier, which has no voxel soft-body, and while idle).
+    size_t getAwakeSegmentCount() const;
+    size_t getSleepingSegmentCount() const;
+    // Drive the legs from a CPG network instead of the fixed metachronal wave (nullptr
+    // switches back). The owner steps the network once per tick; detach before either
+    // the network or this centipede goes away.
+    void attachCpg(gait::CpgNetwork *network);
+    // Baked clips for distant / background centipedes; switching back to Full re-plants
+    // the feet where the clip left them. Tier changes set it (see lod::bakedLegs); set it
+    // after the tier to override.
+    void setLegAnimation(anim::LegAnimation mode);
+    anim::LegAnimation getLegAnimation() const;
+    // Level of detail, normally chosen per tick by the owner with lod::selectTier.
+    // Promotion out of the ghost tier re-plants the legs under the current spine. Also
+    // picks the leg animation for the new tier (lod::bakedLegs).
+    void setSimTier(lod::SimTier tier);
+    lod::SimTier getSimTier() const;
+    // Idle fast path (see IdleMode); `isIdle` is true once the body has settled into it.
+    void setIdleMode(IdleMode mode);
+    bool isIdle() const;
+    // Switch body dynamics; XPBD settings (substeps, iterations, compliances) apply from
+    // the next tick.
+    void setBodyDynamics(BodyDynamics mode, const physics::XpbdParams &params = physics::XpbdParams{});
+    void setBodyDynamics(BodyDynamics mode, const physics::ChainParams &params);
+    // Kinematic (moves carry the head) or leg-driven (moves set the walking command, see
+    // gait::Locomotion). Foot slip is measured either way, for the last tick.
+    void setLocomotion(gait::Locomotion mode);
+    gait::Locomotion getLocomotion() const;
+    const gait::FootSlip& getFootSlip() const;
+    BodyDynamics getBodyDynamics() const;
+    const physics::XpbdStats& getXpbdStats() const;
+    // Floating origin: the local origin moved by (shiftX, shiftY) grid units (see
+    // world::World::rebaseToward). Subtracts it from every stored position (spine,
+    // voxels, legs, path, solvers, pose) without stepping anything; O(segments + voxels
+    // + legs).
+    void rebase(float shiftX, float shiftY);
 };
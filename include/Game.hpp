@@ -2,6 +2,8 @@
 
 #include <SFML/Graphics.hpp>
 #include "Centipede.hpp"
+#include "../src/lod/SimLod.hpp"
+#include "../src/world/World.hpp"
 
 class Game {
 private:
@@ -20,8 +22,16 @@ private:
     // Right-click destination marker (grid space)
     bool hasMoveTarget;
     sf::Vector2f moveTargetGrid;
+    // Simulation level-of-detail inputs (see lod::selectTier).
+    lod::LodParams lodParams;
+    // World the centipede walks in (active while the game runs), streamed around the
+    // centipede and the camera.
+    world::World world;
     void initVar();
     void initWindow();
+    void updateSimTier(Centipede &c, float resf);
+    void streamWorld(float resf);
+    void rebaseOrigin(float resf);
 public:
     Game();
     virtual ~Game();
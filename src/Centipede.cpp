@@ -1,24 +1,40 @@
 #include "Centipede.hpp"
+#include <cassert>
 #include <cmath>
-#include <unordered_map>
 #include <cstdint>
 #include <algorithm>
+#include <bit>
 #include <SFML/Graphics.hpp>
 // Render helpers
 #include "render/Projection.hpp"
 #include "render/GridRenderer.hpp"
 // Gait controller (extracted)
 #include "gait/GaitController.hpp"
+#include "gait/Locomotion.hpp"
 #include "ik/LegIK.hpp"
 #include "render/DrawHelpers.hpp"
+#include "morph/Morphology.hpp"
+#include "math/FastMath.hpp"
+#include "terrain/Heightfield.hpp"
+#include "world/World.hpp"
 
 // static member definitions
 const int Centipede::moveDelay = 2;
 
-// Body suspension: rest height and current height above ground plane (z=0)
-// Lower rest height so the body rides low (belly sliding)
-static constexpr float kBodyRestZ = 0.6f;
-static float g_bodyZ = kBodyRestZ;
+// Suspension: per-tick easing of each segment's body height toward its support height
+// (the support heights are already limited per leg, relative to the ground under it).
+static constexpr float kBodyZSmoothing = 0.12f;
+// Segments on each side whose planted legs also carry a segment (triangle weights), and
+// the weight (in legs) of the body-wide clearance in each segment's clearance.
+static constexpr int kSuspensionRadius = 1;
+static constexpr float kSuspensionPrior = 16.f;
+
+static void easeBodyZ(Segment &seg, float targetZ) {
+    seg.bodyZ += (targetZ - seg.bodyZ) * kBodyZSmoothing;
+}
+
+// Start of each new centipede's tier tick, so reduced-tier IK ticks are spread out.
+static uint32_t g_nextTierTick = 0;
 
 // Leg attachment geometry (constants moved to include/Centipede.hpp)
 
@@ -29,46 +45,114 @@ static float g_bodyZ = kBodyRestZ;
 // - knee bend is stored in Leg::footAngle and added to hipPitch (negative = bends down).
 // joint limits moved to include/Centipede.hpp
 
+// Smoothing of the head speed used to pick clip speeds (moves arrive every other tick).
+static constexpr float kAnimSpeedSmoothing = 0.2f;
+
+// Voxel sleep: a segment whose voxels all stay this slow (grid units per tick) and this
+// close to their rest offsets for kVoxelSleepTicks ticks is skipped by the soft-body.
+static constexpr math::Fixed kVoxelSleepSpeed = math::toFixed(2e-3f);
+static constexpr math::Fixed kVoxelSleepOffset = math::toFixed(2e-2f);
+static constexpr int kVoxelSleepTicks = 30;
+
+// Voxel springs (math::Factor): follower pull and damping when its segment moves, and
+// the settle pass's centring pull, extra pull after a move and damping. The settle
+// damping is near critical for both pulls (per-tick decay ~0.84), so a segment that
+// stops rings down below the sleep thresholds within about kVoxelSleepTicks.
+static constexpr math::Factor kFollowPull = math::toFactor(0.22f);
+static constexpr math::Factor kFollowDamping = math::toFactor(0.82f);
+static constexpr math::Factor kCentrePull = math::toFactor(0.04f);
+static constexpr math::Factor kMovedPull = math::toFactor(0.12f);
+static constexpr math::Factor kVoxelDamping = math::toFactor(0.70f);
+
+static void wakeVoxels(Segment &seg) {
+    seg.asleep = false;
+    seg.restTicks = 0;
+}
+
+// Idle fast path: ticks without head movement before the gait stops and the legs settle,
+// and the breathing bob played once idle (amplitude in grid units, rate in radians per tick).
+static constexpr int kIdleSettleTicks = 45;
+static constexpr float kBreathAmplitude = 0.03f;
+static constexpr float kBreathRate = 0.05f;
+
+// Ticks of eased playback after switching to baked clips.
+static constexpr int kClipBlendTicks = 20;
+
+// Articulated spine: leg thrust and sideways grip per unit of pushStrength, and the speed
+// (grid units or radians per s) and head-to-target distance below which a body whose
+// target has stopped is held at rest by its planted feet (static friction) instead of
+// creeping while its joints unbend against the grip.
+static constexpr float kLegThrust = 200.f;
+static constexpr float kLegGrip = 200.f;
+static constexpr float kChainRestSpeed = 0.5f;
+static constexpr float kChainRestDistance = 0.1f;
+
+// Leg-driven locomotion: smoothing of the walking command (moves arrive every other tick),
+// the fraction of the legs' mean ground force applied as body motion per tick, and the
+// command / motion (grid units per tick) below which nothing moves.
+static constexpr float kDriveSmoothing = 0.5f;
+static constexpr float kGroundForceGain = 0.8f;
+static constexpr float kDriveStop = 1e-3f;
+
+// Phase kick (radians per grid unit) given to a segment's CPG oscillators when it is shoved.
+static constexpr float kPushPhaseKick = 0.6f;
+
+// Body plan of the default centipede: one 3-link leg on each side of every segment.
+static constexpr int kLegLinks = 3;
+using BodyLayout = morph::SegmentLayout<1>;
+
 // Build a centipede with evenly spaced segments, voxels, and initial leg phase offsets.
-Centipede::Centipede(int startX, int startY, int length) : dirX(1), dirY(0), moveCounter(0) {
+Centipede::Centipede(int startX, int startY, int length, const morph::Silhouette &silhouette) : dirX(1), dirY(0), moveCounter(0) {
     this->gaitTime = 0.f;
-    this->lastHeadX = static_cast<float>(startX);
-    this->lastHeadY = static_cast<float>(startY);
-    const int SEG_W = 3;
+    this->ikPassKernel = morph::ikPassKernelFor<kLegLinks, BodyLayout::kLegsPerSide>();
+    this->tierTick = g_nextTierTick++;
+    this->bodyMask = &morph::maskFor(silhouette);
+    const morph::RotatedMask &restMask = this->bodyMask->at(0);
+    const int SEG_W = silhouette.width;
     for (int i = 0; i < length; i++) {
         Segment seg;
         seg.x = startX - i * SEG_W;
         seg.y = startY;
         seg.px = seg.x; seg.py = seg.y;
+        seg.restTicks = 0; seg.asleep = false;
+        seg.sleepX = seg.x; seg.sleepY = seg.y;
+        seg.bodyZ = terrain::groundHeight(seg.x, seg.y) + kBodyRestZ;
+        seg.heading = math::Rot2::identity();
         seg.color = sf::Color(50,200,50);
-        seg.voxW = SEG_W; seg.voxH = SEG_W;
-        seg.voxels.clear(); seg.voxels.reserve(seg.voxW*seg.voxH);
-        for (int yy=0; yy<seg.voxH; ++yy) for (int xx=0; xx<seg.voxW; ++xx) {
-            Voxel v; int cx = seg.voxW/2, cy = seg.voxH/2; int ddx = xx-cx, ddy = yy-cy;
-            // Simple diamond mask (smaller segment)
-            v.filled = (std::abs(ddx)+std::abs(ddy) <= 1) ? 1 : 0;
-            v.baseOx = static_cast<float>(xx); v.baseOy = static_cast<float>(yy);
-            v.wx = seg.x + v.baseOx; v.wy = seg.y + v.baseOy; v.vx = v.vy = 0.f;
+        seg.voxW = silhouette.width; seg.voxH = silhouette.height;
+        seg.voxels.clear(); seg.voxels.reserve(this->bodyMask->voxelCount());
+        for (int yy=0; yy<seg.voxH; ++yy) for (uint64_t row = this->bodyMask->layout()[yy]; row; row &= row - 1) {
+            const int xx = std::countr_zero(row);
+            Voxel v;
+            v.baseOx = math::cellToFixed(xx); v.baseOy = math::cellToFixed(yy);
+            const size_t vi = seg.voxels.size();
+            v.wx = math::toFixed(seg.x) + restMask.offX[vi]; v.wy = math::toFixed(seg.y) + restMask.offY[vi]; v.vx = v.vy = 0;
             seg.voxels.push_back(v);
         }
-        seg.legs.clear(); seg.legs.reserve(2);
-        for (int side=-1; side<=1; side+=2) {
+        seg.legs.clear(); seg.legs.reserve(BodyLayout::kLegs);
+        for (int k=0; k<BodyLayout::kLegs; ++k) {
+            const int side = BodyLayout::side(k);
             Segment::Leg L;
             L.hipOx = (seg.voxW*0.5f) + (side*1.2f);
             L.hipOy = seg.voxH*0.5f;
             L.side = side;
-            L.hipAngle = L.kneeAngle = L.footAngle = 0.f;
+            L.hipYaw = L.targetHipYaw = math::Rot2::identity();
+            L.kneeAngle = L.footAngle = L.ankleAngle = 0.f;
+            L.targetKneeAngle = L.targetFootAngle = L.targetAnkleAngle = 0.f;
             // Metachronal wave: fixed phase offset per segment (rear legs lead front legs).
             const float PI = 3.14159265f;
             const float phaseStep = PI / 4.0f; // 45 degrees per segment
             float sidePhase = (side==-1) ? 0.f : PI; // opposite side out of phase
             L.phaseOffset = static_cast<float>(i) * phaseStep + sidePhase;
             L.cycle = 0.f;
+            L.phaseLead = 0.f;
             L.footHoldX = seg.x + L.hipOx;
             L.footHoldY = seg.y + L.hipOy;
             L.swingPhase = 0.f;
+            L.footHoldZ = terrain::groundHeight(L.footHoldX, L.footHoldY);
             L.swingStartX = L.footHoldX;
             L.swingStartY = L.footHoldY;
+            L.swingStartZ = L.footHoldZ;
             // Leg proportions: 3/2/1 (hip/knee/foot), keeping total length ~unchanged.
             const float totalLen = 2.0f + 2.0f + 1.5f;
             const float unit = totalLen / 6.0f;
@@ -77,127 +161,166 @@ Centipede::Centipede(int startX, int startY, int length) : dirX(1), dirY(0), mov
             L.footLength = 1.0f * unit;
             L.pushStrength = 0.06f;
             L.onGround = true;
+            L.groundForceX = L.groundForceY = 0.f;
             L.coxaLength = kCoxaLength;
+            L.ikFootX = L.ikFootY = L.ikAttachX = L.ikAttachY = L.ikBodyZ = 0.f;
+            L.ikYawRef = math::Rot2::identity();
+            L.ikConverged = false;
             seg.legs.push_back(L);
         }
+        // The IK kernel indexes BodyLayout::kLegs legs on every segment.
+        assert(seg.legs.size() == static_cast<size_t>(BodyLayout::kLegs));
         segments.push_back(seg);
     }
 }
 
+// The world is unbounded; only obstacles of the active world stop the head. Drop the
+// components of the head move that would take it into a blocked cell (a head that is
+// already in one may walk out).
+static void clampHeadToWorld(float headX, float headY, float &applyDx, float &applyDy) {
+    world::World *w = world::active();
+    if (!w || !w->blocked(headX + applyDx, headY + applyDy) || w->blocked(headX, headY)) return;
+    // Slide along the obstacle: X only, then Y only, then neither.
+    if (!w->blocked(headX + applyDx, headY)) applyDy = 0.f;
+    else if (!w->blocked(headX, headY + applyDy)) applyDx = 0.f;
+    else applyDx = applyDy = 0.f;
+}
+
 // Rate-limited head move request with a safety clamp for huge mouse deltas.
 void Centipede::tryMove(float dx, float dy) {
     // Clamp very large mouse moves: length is Euclidean norm sqrt(dx^2 + dy^2)
-    float mag = std::sqrt(dx*dx + dy*dy);
+    wakeFromIdle();
+    float mag = fastmath::sqrt(dx*dx + dy*dy);
     if (mag > Centipede::maxMovePerTry) { dx = dx/mag*Centipede::maxMovePerTry; dy = dy/mag*Centipede::maxMovePerTry; }
     moveCounter++; if (moveCounter < moveDelay) return; moveCounter = 0; moveBy(dx,dy);
 }
 
 void Centipede::moveBy(float dx, float dy) {
     if (segments.empty()) return;
+    wakeFromIdle();
+    if (chainActive()) {
+        // The articulated spine steers its head toward the target; the legs do the rest.
+        float applyDx = dx, applyDy = dy;
+        clampHeadToWorld(this->chain.targetPosX(), this->chain.targetPosY(), applyDx, applyDy);
+        this->chain.setHeadTarget(this->chain.targetPosX() + applyDx, this->chain.targetPosY() + applyDy);
+        const bool moved = std::abs(applyDx) > 1e-6f || std::abs(applyDy) > 1e-6f;
+        this->lastMoveDx = moved ? applyDx : 0.0f;
+        this->lastMoveDy = moved ? applyDy : 0.0f;
+        return;
+    }
+    if (legDriven()) {
+        // Only a walking command: the gait sweeps the planted feet and they move the body.
+        this->pendingDriveX += dx;
+        this->pendingDriveY += dy;
+        this->lastMoveDx = dx;
+        this->lastMoveDy = dy;
+        return;
+    }
+    moveHead(dx, dy);
+}
+
+// Call f(gx, gy) for every cell of `mask` on a segment at fixed-point (x, y): the mask's
+// rasterized cells around the segment's cell.
+template <typename F>
+static void forEachMaskCell(const morph::RotatedMask &mask, math::Fixed x, math::Fixed y, F &&f) {
+    const int cx = math::fixedCell(x) + mask.minX, cy = math::fixedCell(y) + mask.minY;
+    for (size_t r = 0; r < mask.rows.size(); ++r) {
+        for (uint64_t bits = mask.rows[r]; bits; bits &= bits - 1) f(cx + std::countr_zero(bits), cy + static_cast<int>(r));
+    }
+}
+
+// Move the head by (dx, dy), clearing voxels out of its way, and the followers after it.
+void Centipede::moveHead(float dx, float dy) {
+    if (this->simTier != lod::SimTier::Full || xpbdActive()) { moveSpine(dx, dy); return; }
 
-    // Remember previous logical positions so followers can chase where the leader used to be.
-    std::vector<std::pair<float,float>> prev; prev.reserve(segments.size());
-    for (auto &s : segments) prev.emplace_back(s.x, s.y);
     for (auto &s : segments) s.moved = false;
 
-    // Quick overlap test for hypothetical offsets against non-head voxels.
-    auto wouldCollide = [&](float ox, float oy) -> bool {
+    // The head's collision shape after a move by (ox, oy): its mask turned to the move's
+    // heading, at the new position.
+    auto forEachHeadCell = [&](float ox, float oy, auto &&f) {
         const Segment &head = segments[0];
-        for (const auto &hv : head.voxels) {
-            if (!hv.filled) continue;
-            float vwx = hv.wx + ox; float vwy = hv.wy + oy;
-            int igx = static_cast<int>(std::floor(vwx + 0.5f));
-            int igy = static_cast<int>(std::floor(vwy + 0.5f));
-            for (size_t si=1; si<segments.size(); ++si) {
-                const Segment &other = segments[si];
-                for (const auto &ov : other.voxels) {
-                    if (!ov.filled) continue;
-                    int ogx = static_cast<int>(std::floor(ov.wx + 0.5f));
-                    int ogy = static_cast<int>(std::floor(ov.wy + 0.5f));
-                    if (ogx==igx && ogy==igy) return true;
-                }
-            }
-        }
-        return false;
+        const morph::RotatedMask &mask = this->bodyMask->forHeading(math::Rot2::fromVector(ox, oy, head.heading));
+        forEachMaskCell(mask, math::toFixed(head.x + ox), math::toFixed(head.y + oy), f);
     };
 
-    // Occupancy map lets us relocate or push away blocking voxels.
-    std::unordered_map<uint64_t, std::pair<int,int>> occ;
-    auto cellKey = [](int gx, int gy) -> uint64_t { return (static_cast<uint64_t>(static_cast<uint32_t>(gx))<<32) | static_cast<uint32_t>(gy); };
-    for (int si=0; si<static_cast<int>(segments.size()); ++si) {
-        const Segment &s = segments[si];
-        for (int vi=0; vi<static_cast<int>(s.voxels.size()); ++vi) {
-            const Voxel &v = s.voxels[vi]; if (!v.filled) continue;
-            int igx = static_cast<int>(std::floor(v.wx + 0.5f));
-            int igy = static_cast<int>(std::floor(v.wy + 0.5f));
-            occ[cellKey(igx,igy)] = {si, vi};
+    // Occupancy lets us relocate or push away blocking voxels.
+    physics::Occupancy &occ = this->occupancy;
+    auto fillOccupancy = [&]() {
+        occ.clear();
+        for (int si=0; si<static_cast<int>(segments.size()); ++si) {
+            const Segment &s = segments[si];
+            for (int vi=0; vi<static_cast<int>(s.voxels.size()); ++vi) {
+                const Voxel &v = s.voxels[vi];
+                occ.add(math::fixedCell(v.wx), math::fixedCell(v.wy), physics::Occupancy::packOwner(si, vi));
+            }
         }
-    }
+    };
 
     // Try to move a single voxel to the nearest free ring of cells.
     auto relocateVoxel = [&](int ownerSeg, int ownerVox) -> bool {
         Voxel &ov = segments[ownerSeg].voxels[ownerVox];
-        int igx = static_cast<int>(std::floor(ov.wx + 0.5f));
-        int igy = static_cast<int>(std::floor(ov.wy + 0.5f));
+        wakeVoxels(segments[ownerSeg]);
+        int igx = math::fixedCell(ov.wx);
+        int igy = math::fixedCell(ov.wy);
         bool placed = false;
         for (int radius=1; radius<=6 && !placed; ++radius) {
             for (int dxr=-radius; dxr<=radius && !placed; ++dxr) for (int dyr=-radius; dyr<=radius && !placed; ++dyr) {
                 if (std::abs(dxr)!=radius && std::abs(dyr)!=radius) continue;
-                int nx = igx + dxr; int ny = igy + dyr; uint64_t nk = cellKey(nx,ny);
-                if (occ.find(nk)==occ.end()) { occ.erase(cellKey(igx,igy)); ov.wx = static_cast<float>(nx); ov.wy = static_cast<float>(ny); occ[nk] = {ownerSeg, ownerVox}; placed = true; }
+                int nx = igx + dxr; int ny = igy + dyr;
+                if (!occ.occupied(nx, ny)) { occ.remove(igx, igy); ov.wx = math::cellToFixed(nx); ov.wy = math::cellToFixed(ny); occ.add(nx, ny, physics::Occupancy::packOwner(ownerSeg, ownerVox)); placed = true; }
             }
         }
         return placed;
     };
 
     // Compute the integer grid cells the head wants to occupy after this move.
-    std::vector<uint64_t> headTargets;
-    {
-        const Segment &head = segments[0];
-        for (const auto &hv : head.voxels) {
-            if (!hv.filled) continue;
-            float vwx = hv.wx + dx; float vwy = hv.wy + dy;
-            int igx = static_cast<int>(std::floor(vwx + 0.5f)); int igy = static_cast<int>(std::floor(vwy + 0.5f));
-            headTargets.push_back(cellKey(igx,igy));
-        }
-    }
+    std::vector<std::pair<int,int>> headTargets;
+    forEachHeadCell(dx, dy, [&](int igx, int igy) { headTargets.emplace_back(igx, igy); });
 
     // Iteratively clear head targets by relocating or pushing blocking segments.
     const int maxIterations = 5; bool headFree = false;
     for (int iter=0; iter<maxIterations && !headFree; ++iter) {
         headFree = true;
-        occ.clear();
-        for (int si=0; si<static_cast<int>(segments.size()); ++si) {
-            const Segment &s = segments[si];
-            for (int vi=0; vi<static_cast<int>(s.voxels.size()); ++vi) {
-                const Voxel &v = s.voxels[vi]; if (!v.filled) continue;
-                int igx = static_cast<int>(std::floor(v.wx + 0.5f)); int igy = static_cast<int>(std::floor(v.wy + 0.5f)); occ[cellKey(igx,igy)] = {si,vi};
-            }
-        }
-        for (auto tk : headTargets) {
-            auto it = occ.find(tk);
-            if (it!=occ.end()) {
-                int osi = it->second.first; int ovi = it->second.second; if (osi==0) continue;
+        fillOccupancy();
+        for (auto [tx, ty] : headTargets) {
+            const uint32_t owner = occ.owner(tx, ty);
+            if (owner!=physics::Occupancy::kNoOwner) {
+                int osi = physics::Occupancy::ownerSegment(owner); int ovi = physics::Occupancy::ownerVoxel(owner); if (osi==0) continue;
                 bool ok = relocateVoxel(osi, ovi);
                 if (!ok) {
                     Segment &ownerSeg = segments[osi]; const Segment &head = segments[0];
-                    float vx = ownerSeg.x - head.x; float vy = ownerSeg.y - head.y; float vlen = std::sqrt(vx*vx+vy*vy);
+                    float vx = ownerSeg.x - head.x; float vy = ownerSeg.y - head.y; float vlen = fastmath::sqrt(vx*vx+vy*vy);
                     if (vlen < 0.001f) { vx = 1.f; vy = 0.f; vlen = 1.f; }
                     vx/=vlen; vy/=vlen; // normalize
                     float pushBase = 1.5f; float pushDist = pushBase * (1.0f + iter * 0.7f); // progressively stronger pushes per iteration
-                    for (int vii=0; vii<static_cast<int>(ownerSeg.voxels.size()); ++vii) { Voxel &ov = ownerSeg.voxels[vii]; int oxg = static_cast<int>(std::floor(ov.wx+0.5f)); int oyg = static_cast<int>(std::floor(ov.wy+0.5f)); occ.erase(cellKey(oxg, oyg)); }
+                    for (const Voxel &ov : ownerSeg.voxels) occ.remove(math::fixedCell(ov.wx), math::fixedCell(ov.wy));
                     ownerSeg.x += vx * pushDist; ownerSeg.y += vy * pushDist; ownerSeg.moved = true;
-                    for (auto &ov : ownerSeg.voxels) { ov.wx += vx * pushDist; ov.wy += vy * pushDist; }
-                    for (int vii=0; vii<static_cast<int>(ownerSeg.voxels.size()); ++vii) { Voxel &ov = ownerSeg.voxels[vii]; int nx = static_cast<int>(std::floor(ov.wx+0.5f)); int ny = static_cast<int>(std::floor(ov.wy+0.5f)); occ[cellKey(nx,ny)] = {osi, vii}; }
+                    if (this->cpg) this->cpg->perturb(this->cpgBody, static_cast<size_t>(osi), pushDist * kPushPhaseKick);
+                    const math::Fixed pushX = math::toFixed(vx * pushDist), pushY = math::toFixed(vy * pushDist);
+                    for (auto &ov : ownerSeg.voxels) { ov.wx += pushX; ov.wy += pushY; }
+                    for (int vii=0; vii<static_cast<int>(ownerSeg.voxels.size()); ++vii) { const Voxel &ov = ownerSeg.voxels[vii]; occ.add(math::fixedCell(ov.wx), math::fixedCell(ov.wy), physics::Occupancy::packOwner(osi, vii)); }
                     headFree = false;
                 }
             }
         }
     }
 
+    // Without the head's own voxels, any voxel left under a head cell belongs to another
+    // segment. Whole tiles under the head shape are rejected before its cells are tested.
+    for (const Voxel &hv : segments[0].voxels) occ.remove(math::fixedCell(hv.wx), math::fixedCell(hv.wy));
+    auto wouldCollide = [&](float ox, float oy) -> bool {
+        const Segment &head = segments[0];
+        const morph::RotatedMask &mask = this->bodyMask->forHeading(math::Rot2::fromVector(ox, oy, head.heading));
+        const int x0 = math::fixedCell(math::toFixed(head.x + ox)) + mask.minX, y0 = math::fixedCell(math::toFixed(head.y + oy)) + mask.minY;
+        if (!occ.anyIn(x0, y0, x0 + mask.spanX - 1, y0 + static_cast<int>(mask.rows.size()) - 1)) return false;
+        bool hit = false;
+        forEachMaskCell(mask, math::toFixed(head.x + ox), math::toFixed(head.y + oy), [&](int igx, int igy) { hit = hit || occ.occupied(igx, igy); });
+        return hit;
+    };
+
     // Final check: are any head target cells still occupied by others?
     bool blocked = false;
-    for (auto tk : headTargets) { auto it = occ.find(tk); if (it!=occ.end()) { if (it->second.first != 0) { blocked = true; break; } } }
+    for (auto [tx, ty] : headTargets) { if (occ.occupied(tx, ty)) { blocked = true; break; } }
 
     float applyDx = 0.f, applyDy = 0.f;
     if (!blocked) { applyDx = dx; applyDy = dy; }
@@ -206,216 +329,343 @@ void Centipede::moveBy(float dx, float dy) {
         if (!colX) { applyDx = dx; applyDy = 0.f; } else if (!colY) { applyDx = 0.f; applyDy = dy; } else { applyDx = 0.f; applyDy = 0.f; }
     }
 
-    // Boundary checking in screen space (account for isometric projection)
-    float resf = 10.0f;  // resolution factor (window 800x800, grid 80x80)
-    float newHeadX = segments[0].x + applyDx;
-    float newHeadY = segments[0].y + applyDy;
-    
-    // Convert to screen space using isometric projection
-    float halfW = resf * 0.5f;
-    float halfH = resf * 0.25f;
-    float cx = 400.0f;  // window width/2
-    float cy = 50.0f;   // base screen Y offset
-    
-    float screenX = (newHeadX - newHeadY) * halfW + cx;
-    float screenY = (newHeadX + newHeadY) * halfH + cy;
-    
-    // Check if in screen bounds with margin
-    float margin = 20.0f;
-    bool inBoundsX = (screenX >= margin && screenX <= (800.0f - margin));
-    bool inBoundsY = (screenY >= margin && screenY <= (800.0f - margin));
-    
-    if (!inBoundsX || !inBoundsY) {
-        // Clamp to boundary: try X only, then Y only, then neither
-        newHeadX = segments[0].x + (inBoundsX ? applyDx : 0.f);
-        newHeadY = segments[0].y + (inBoundsY ? applyDy : 0.f);
-        applyDx = newHeadX - segments[0].x;
-        applyDy = newHeadY - segments[0].y;
-    }
+    clampHeadToWorld(segments[0].x, segments[0].y, applyDx, applyDy);
 
+    const float oldHeadX = segments[0].x, oldHeadY = segments[0].y;
     segments[0].x += applyDx; segments[0].y += applyDy;
-    for (auto &hv : segments[0].voxels) { hv.wx += applyDx; hv.wy += applyDy; }
+    this->headStepX += applyDx; this->headStepY += applyDy;
+    const math::Fixed applyFx = math::toFixed(applyDx), applyFy = math::toFixed(applyDy);
+    for (auto &hv : segments[0].voxels) { hv.wx += applyFx; hv.wy += applyFy; }
     segments[0].moved = (std::abs(applyDx) > 1e-6f || std::abs(applyDy) > 1e-6f);
-    if (segments[0].moved) segments[0].angle = std::atan2(applyDy, applyDx);
+    if (segments[0].moved) segments[0].heading = math::Rot2::fromVector(applyDx, applyDy, segments[0].heading);
 
     // Remember last movement so gait can align to the destination direction.
     this->lastMoveDx = segments[0].moved ? applyDx : 0.0f;
     this->lastMoveDy = segments[0].moved ? applyDy : 0.0f;
 
+    followHeadPath(oldHeadX, oldHeadY);
+    fillOccupancy();
     for (size_t i=1; i<segments.size(); ++i) {
-        if (!segments[i-1].moved) { segments[i].moved = false; continue; }
-        float targetX = prev[i-1].first; float targetY = prev[i-1].second;
-        float oldx = segments[i].x; float oldy = segments[i].y;
-        segments[i].x += (targetX - segments[i].x) * Centipede::followSpeed * 0.9f;
-        segments[i].y += (targetY - segments[i].y) * Centipede::followSpeed * 0.9f;
-        segments[i].moved = (std::abs(segments[i].x - oldx) > 1e-4f || std::abs(segments[i].y - oldy) > 1e-4f);
-        float dx_to_pred = segments[i-1].x - segments[i].x; float dy_to_pred = segments[i-1].y - segments[i].y;
-        float dist_to_pred = std::sqrt(dx_to_pred*dx_to_pred + dy_to_pred*dy_to_pred);
-        if (dist_to_pred > 0.1f) {
-            float target_angle = std::atan2(dy_to_pred, dx_to_pred);
-            float da = target_angle - segments[i].angle; if (da > 3.14159f) da -= 6.28318f; if (da < -3.14159f) da += 6.28318f;
-            segments[i].angle += da * 0.15f;
-        }
+        if (!segments[i].moved) continue;
+        Segment &seg = segments[i];
+        wakeVoxels(seg);
+        // Take the follower out of the occupancy while it moves; what is left in its cells
+        // afterwards is other segments.
+        for (const Voxel &v : seg.voxels) occ.remove(math::fixedCell(v.wx), math::fixedCell(v.wy));
         // Pull follower voxels toward their logical centers with damping.
-        for (auto &v : segments[i].voxels) {
-            if (!v.filled) continue;
-            float targetWx = segments[i].x + v.baseOx; float targetWy = segments[i].y + v.baseOy;
-            float k = 0.22f; v.vx += (targetWx - v.wx) * k; v.vy += (targetWy - v.wy) * k; v.vx *= 0.82f; v.vy *= 0.82f; v.wx += v.vx; v.wy += v.vy;
+        const math::Fixed segFx = math::toFixed(seg.x), segFy = math::toFixed(seg.y);
+        const morph::RotatedMask &rest = this->bodyMask->forHeading(seg.heading);
+        for (size_t vi = 0; vi < seg.voxels.size(); ++vi) {
+            Voxel &v = seg.voxels[vi];
+            const math::Fixed targetWx = segFx + rest.offX[vi], targetWy = segFy + rest.offY[vi];
+            v.vx = math::fixedScale(v.vx + math::fixedScale(targetWx - v.wx, kFollowPull), kFollowDamping);
+            v.vy = math::fixedScale(v.vy + math::fixedScale(targetWy - v.wy, kFollowPull), kFollowDamping);
+            v.wx += v.vx; v.wy += v.vy;
         }
-        // Simple overlap push-off so followers do not sit inside others.
-        for (size_t sj=0; sj<segments.size(); ++sj) {
-            if (sj == i) continue; const Segment &other = segments[sj]; bool pushed = false;
-            for (const auto &ov : other.voxels) { if (!ov.filled) continue; int ogx = static_cast<int>(std::floor(ov.wx+0.5f)); int ogy = static_cast<int>(std::floor(ov.wy+0.5f));
-                for (auto &fv : segments[i].voxels) { if (!fv.filled) continue; int fgx = static_cast<int>(std::floor(fv.wx+0.5f)); int fgy = static_cast<int>(std::floor(fv.wy+0.5f)); if (fgx==ogx && fgy==ogy) {
-                    float pushX = (segments[i].x - other.x) * 0.2f; float pushY = (segments[i].y - other.y) * 0.2f; segments[i].x += (pushX==0.f?0.2f:pushX); segments[i].y += (pushY==0.f?0.2f:pushY);
-                    for (auto &fv2 : segments[i].voxels) { fv2.wx += (pushX==0.f?0.2f:pushX); fv2.wy += (pushY==0.f?0.2f:pushY); }
-                    pushed = true; break; }
-                }
-                if (pushed) break;
-            }
-            if (pushed) break;
+        // Simple overlap push-off so followers do not sit inside others: one push away from
+        // the segment under the first overlapping voxel. A cell whose last owner is gone or is
+        // this follower (a stale id: its voxels were removed above) names no segment to push
+        // from, so it is passed over.
+        for (const Voxel &fv : seg.voxels) {
+            const int fgx = math::fixedCell(fv.wx), fgy = math::fixedCell(fv.wy);
+            const uint32_t owner = occ.owner(fgx, fgy);
+            if (owner == physics::Occupancy::kNoOwner) continue;
+            const int sj = physics::Occupancy::ownerSegment(owner);
+            if (sj == static_cast<int>(i) || sj >= static_cast<int>(segments.size())) continue;
+            const Segment &other = segments[sj];
+            float pushX = (seg.x - other.x) * 0.2f; float pushY = (seg.y - other.y) * 0.2f; seg.x += (pushX==0.f?0.2f:pushX); seg.y += (pushY==0.f?0.2f:pushY);
+            const math::Fixed pushFx = math::toFixed(pushX==0.f?0.2f:pushX), pushFy = math::toFixed(pushY==0.f?0.2f:pushY);
+            for (auto &fv2 : seg.voxels) { fv2.wx += pushFx; fv2.wy += pushFy; }
+            if (this->cpg) this->cpg->perturb(this->cpgBody, i, 0.2f * kPushPhaseKick);
+            break;
         }
+        for (int vi=0; vi<static_cast<int>(seg.voxels.size()); ++vi) { const Voxel &v = seg.voxels[vi]; occ.add(math::fixedCell(v.wx), math::fixedCell(v.wy), physics::Occupancy::packOwner(static_cast<int>(i), vi)); }
     }
 
     for (auto &s : segments) { s.px = s.x; s.py = s.y; }
 }
 
-void Centipede::update() {
-    // Gallop-style gait: legs move in coordinated bursts
-    // Like a horse but with many legs - creates powerful pushing motion
-    
-    // Advance gait time: scale with real movement so legs "walk" toward the mouse destination.
-    // (Idle is slow; moving faster increases cadence.)
-    const float kIdleGait = 0.015f;
-    const float kGaitPerUnit = 5.55f; // radians per grid-unit moved
-    
-    // Track movement for reference
-    float headMove = 0.f;
-    if (!segments.empty()) {
-        headMove = std::sqrt((segments[0].x - this->lastHeadX)*(segments[0].x - this->lastHeadX) + 
-                             (segments[0].y - this->lastHeadY)*(segments[0].y - this->lastHeadY));
-        this->lastHeadX = segments[0].x;
-        this->lastHeadY = segments[0].y;
-    }
+// Same head and follower motion as moveBy, minus everything voxel: nothing blocks the
+// head and followers are never pushed apart. Voxels stay where they are until the
+// body is promoted back to the full tier (see restVoxels). Under XPBD only the head
+// moves here; the solver's spine constraints drag the followers.
+void Centipede::moveSpine(float dx, float dy) {
+    float applyDx = dx, applyDy = dy;
+    clampHeadToWorld(segments[0].x, segments[0].y, applyDx, applyDy);
 
-    const float gaitAdvance = kIdleGait + headMove * kGaitPerUnit;
-    this->gaitTime += gaitAdvance;
+    const float oldHeadX = segments[0].x, oldHeadY = segments[0].y;
+    segments[0].x += applyDx; segments[0].y += applyDy;
+    this->headStepX += applyDx; this->headStepY += applyDy;
+    segments[0].moved = (std::abs(applyDx) > 1e-6f || std::abs(applyDy) > 1e-6f);
+    if (segments[0].moved) segments[0].heading = math::Rot2::fromVector(applyDx, applyDy, segments[0].heading);
+    this->lastMoveDx = segments[0].moved ? applyDx : 0.0f;
+    this->lastMoveDy = segments[0].moved ? applyDy : 0.0f;
 
-    // Delegate gait/step planning to the gait controller module.
-    gait::updateGait(segments, this->gaitTime, g_bodyZ, this->lastMoveDx, this->lastMoveDy);
+    if (!xpbdActive()) followHeadPath(oldHeadX, oldHeadY);
 
-    // Estimate supported body height from planted legs.
-    float supportedZSum = 0.0f;
-    int supportedZCount = 0;
-    for (size_t i = 0; i < segments.size(); ++i) {
-        auto &seg = segments[i];
-
-        float spineX = 0.f, spineY = 0.f;
-        if (i < segments.size() - 1) {
-            spineX = segments[i + 1].x - segments[i].x;
-            spineY = segments[i + 1].y - segments[i].y;
-        } else if (i > 0) {
-            spineX = segments[i].x - segments[i - 1].x;
-            spineY = segments[i].y - segments[i - 1].y;
-        } else {
-            spineX = 1.f;
-            spineY = 0.f;
+    for (auto &s : segments) { s.px = s.x; s.py = s.y; }
+}
+
+// Followers sit on the head's path at their rest spacing behind it (O(1) lookup each),
+// so spacing is exact whatever the move size or rate.
+void Centipede::followHeadPath(float oldHeadX, float oldHeadY) {
+    if (this->headPathStale) {
+        // Seed from the spine as it stands (tail to the head's old position), keeping a
+        // body length of history plus one segment of slack.
+        float length = 0.f;
+        for (size_t i = 1; i < segments.size(); ++i) length += static_cast<float>(segments[i].voxW);
+        const Segment &tail = segments.back();
+        this->headPath.reset(segments.size() > 1 ? tail.x : oldHeadX, segments.size() > 1 ? tail.y : oldHeadY,
+                             length + static_cast<float>(tail.voxW));
+        for (size_t i = segments.size() - 1; i-- > 1;) this->headPath.advance(segments[i].x, segments[i].y);
+        this->headPath.advance(oldHeadX, oldHeadY);
+        this->headPathStale = false;
+    }
+    if (!segments[0].moved) {
+        for (size_t i = 1; i < segments.size(); ++i) segments[i].moved = false;
+        return;
+    }
+    this->headPath.advance(segments[0].x, segments[0].y);
+
+    float behind = 0.f;
+    for (size_t i = 1; i < segments.size(); ++i) {
+        Segment &seg = segments[i];
+        behind += static_cast<float>(seg.voxW);
+        float nx, ny;
+        this->headPath.sampleBehind(behind, nx, ny);
+        seg.moved = std::abs(nx - seg.x) > 1e-4f || std::abs(ny - seg.y) > 1e-4f;
+        seg.x = nx; seg.y = ny;
+        float dx_to_pred = segments[i-1].x - seg.x; float dy_to_pred = segments[i-1].y - seg.y;
+        float dist_to_pred = fastmath::sqrt(dx_to_pred*dx_to_pred + dy_to_pred*dy_to_pred);
+        if (dist_to_pred > 0.1f) {
+            // Turn toward the predecessor with a normalized lerp (no atan2 / angle wrapping).
+            math::Rot2 target{dx_to_pred / dist_to_pred, dy_to_pred / dist_to_pred};
+            seg.heading = math::nlerp(seg.heading, target, 0.15f);
         }
-        float spineLen = std::sqrt(spineX * spineX + spineY * spineY);
-        if (spineLen < 0.001f) { spineX = 1.f; spineY = 0.f; spineLen = 1.f; }
-        spineX /= spineLen;
-        spineY /= spineLen;
-        float perpX = -spineY;
-        float perpY = spineX;
+    }
+}
 
-        float midX = (i < segments.size() - 1) ? (segments[i].x + segments[i + 1].x) * 0.5f : segments[i].x;
-        float midY = (i < segments.size() - 1) ? (segments[i].y + segments[i + 1].y) * 0.5f : segments[i].y;
+// Support the planted legs of segment `i` give its body: each leg supports a clearance
+// (above the ground at its hold) at which the hold sits at a comfortable extension (75%
+// of the leg) from the hip. Adds the planted holds' ground heights to `groundSum` and
+// their clearances to `clearanceSum`, and returns how many legs are planted.
+static int supportHeights(const std::vector<Segment> &segments, size_t i, float &groundSum, float &clearanceSum) {
+    const auto &seg = segments[i];
 
-        for (auto &leg : seg.legs) {
-            if (!leg.onGround) continue;
-
-            float attachX = midX + perpX * (kStanceWidth * static_cast<float>(leg.side));
-            float attachY = midY + perpY * (kStanceWidth * static_cast<float>(leg.side));
-            float coxaAttachX = attachX + perpX * leg.coxaLength * static_cast<float>(leg.side);
-            float coxaAttachY = attachY + perpY * leg.coxaLength * static_cast<float>(leg.side);
-
-            float dxHold = leg.footHoldX - coxaAttachX;
-            float dyHold = leg.footHoldY - coxaAttachY;
-            float rHold = std::sqrt(dxHold * dxHold + dyHold * dyHold);
-
-            const float L1 = leg.hipLength;
-            const float L2 = leg.kneeLength + leg.footLength;
-            const float total = L1 + L2;
-            const float preferredExt = 0.75f;
-            float preferredDist = preferredExt * total;
-            preferredDist = std::clamp(preferredDist, std::fabs(L1 - L2) + 0.05f, total - 0.05f);
-
-            float zFromLeg = 0.0f;
-            if (rHold < preferredDist) {
-                zFromLeg = std::sqrt(std::max(0.0f, preferredDist * preferredDist - rHold * rHold));
-            } else {
-                zFromLeg = 0.05f;
-            }
+    float spineX = 0.f, spineY = 0.f;
+    if (i < segments.size() - 1) {
+        spineX = segments[i + 1].x - segments[i].x;
+        spineY = segments[i + 1].y - segments[i].y;
+    } else if (i > 0) {
+        spineX = segments[i].x - segments[i - 1].x;
+        spineY = segments[i].y - segments[i - 1].y;
+    } else {
+        spineX = 1.f;
+        spineY = 0.f;
+    }
+    float spineLen = fastmath::sqrt(spineX * spineX + spineY * spineY);
+    if (spineLen < 0.001f) { spineX = 1.f; spineY = 0.f; spineLen = 1.f; }
+    spineX /= spineLen;
+    spineY /= spineLen;
+    float perpX = -spineY;
+    float perpY = spineX;
+
+    float midX = (i < segments.size() - 1) ? (segments[i].x + segments[i + 1].x) * 0.5f : segments[i].x;
+    float midY = (i < segments.size() - 1) ? (segments[i].y + segments[i + 1].y) * 0.5f : segments[i].y;
+
+    int zCount = 0;
+    for (const auto &leg : seg.legs) {
+        if (!leg.onGround) continue;
 
-            float zMin = 0.15f;
-            float zMax = 2.0f;
-            zFromLeg = std::clamp(zFromLeg, zMin, zMax);
+        float attachX = midX + perpX * (kStanceWidth * static_cast<float>(leg.side));
+        float attachY = midY + perpY * (kStanceWidth * static_cast<float>(leg.side));
+        float coxaAttachX = attachX + perpX * leg.coxaLength * static_cast<float>(leg.side);
+        float coxaAttachY = attachY + perpY * leg.coxaLength * static_cast<float>(leg.side);
 
-            supportedZSum += zFromLeg;
-            supportedZCount += 1;
+        float dxHold = leg.footHoldX - coxaAttachX;
+        float dyHold = leg.footHoldY - coxaAttachY;
+        float rHold = fastmath::sqrt(dxHold * dxHold + dyHold * dyHold);
+
+        const float L1 = leg.hipLength;
+        const float L2 = leg.kneeLength + leg.footLength;
+        const float total = L1 + L2;
+        const float preferredExt = 0.75f;
+        float preferredDist = preferredExt * total;
+        preferredDist = std::clamp(preferredDist, std::fabs(L1 - L2) + 0.05f, total - 0.05f);
+
+        float zFromLeg = 0.0f;
+        if (rHold < preferredDist) {
+            zFromLeg = fastmath::sqrt(std::max(0.0f, preferredDist * preferredDist - rHold * rHold));
+        } else {
+            zFromLeg = 0.05f;
         }
+        groundSum += leg.footHoldZ;
+        clearanceSum += std::clamp(zFromLeg, 0.15f, 2.0f);
+        zCount += 1;
     }
+    return zCount;
+}
 
-    // Update body height from supports; if no legs are planted, relax back toward rest height.
-    float targetBodyZ = (supportedZCount > 0) ? (supportedZSum / static_cast<float>(supportedZCount)) : kBodyRestZ;
-    // Smooth to avoid bobbing
-    g_bodyZ += (targetBodyZ - g_bodyZ) * 0.12f;
-    g_bodyZ = std::clamp(g_bodyZ, 0.15f, 2.0f);
+// Mean ground height at the segment's foot holds, planted or not.
+static float feetGround(const Segment &seg) {
+    float groundSum = 0.f;
+    for (const auto &leg : seg.legs) groundSum += leg.footHoldZ;
+    return seg.legs.empty() ? 0.f : groundSum / static_cast<float>(seg.legs.size());
+}
 
-    // Pass 2: solve fully-3D leg IK (yaw + pitch + knee) using the current suspended body height
-    for (size_t i = 0; i < segments.size(); ++i) {
-        auto &seg = segments[i];
-
-        float spineX = 0.f, spineY = 0.f;
-        if (i < segments.size() - 1) {
-            spineX = segments[i + 1].x - segments[i].x;
-            spineY = segments[i + 1].y - segments[i].y;
-        } else if (i > 0) {
-            spineX = segments[i].x - segments[i - 1].x;
-            spineY = segments[i].y - segments[i - 1].y;
-        } else {
-            spineX = 1.f;
-            spineY = 0.f;
+// Full leg animation: gait planning, body height from planted legs, then IK per leg
+// (only when `solveIk`; the reduced tier solves every few ticks).
+void Centipede::animateLegsFull(float gaitAdvance, float headMove, bool solveIk) {
+    // While settling the gait is stopped (swinging legs were landed); only the IK runs.
+    const bool gaitRunning = this->idleState != IdleState::Settling;
+    if (this->cpg) {
+        // CPG gait: feed this tick's drive (applied on the network's next step) and read
+        // leg phases from the oscillators.
+        this->cpg->setDrive(this->cpgBody, gaitAdvance, headMove);
+        if (gaitRunning) gait::updateGaitCpg(segments, *this->cpg, this->cpgBody, this->lastMoveDx, this->lastMoveDy);
+    } else if (gaitRunning && legDriven()) {
+        // Every planted leg's ground force changes every tick, so step them all.
+        gait::updateGaitDriven(segments, this->gaitTime, gaitAdvance, this->lastMoveDx, this->lastMoveDy);
+    } else if (gaitRunning) {
+        // Delegate gait/step planning to the event-driven scheduler (same result as gait::updateGait).
+        this->gaitScheduler.update(segments, this->gaitTime, this->lastMoveDx, this->lastMoveDy);
+    }
+
+    // Per-segment suspension: each segment rides over the mean ground height of the
+    // planted holds of it and its neighbours (triangle window, weighted per leg) at their
+    // mean clearance, pulled toward the body-wide clearance with the weight of
+    // kSuspensionPrior legs, so a segment with one or no planted legs rides with the rest
+    // of the body; eased over time. With no planted leg in the window the segment rides
+    // over its own feet at the body-wide clearance (the rest height with none planted).
+    const size_t n = segments.size();
+    this->supportGround.resize(n);
+    this->supportClearance.resize(n);
+    this->supportLegs.resize(n);
+    float bodyClearance = 0.f, bodyLegs = 0.f;
+    for (size_t i = 0; i < n; ++i) {
+        this->supportGround[i] = this->supportClearance[i] = 0.f;
+        this->supportLegs[i] = static_cast<float>(supportHeights(segments, i, this->supportGround[i], this->supportClearance[i]));
+        bodyClearance += this->supportClearance[i];
+        bodyLegs += this->supportLegs[i];
+    }
+    const float meanClearance = bodyLegs > 0.f ? bodyClearance / bodyLegs : kBodyRestZ;
+    const size_t radius = static_cast<size_t>(kSuspensionRadius);
+    for (size_t i = 0; i < n; ++i) {
+        float ground = 0.f, clearance = 0.f, legs = 0.f;
+        for (size_t k = (i > radius ? i - radius : 0); k < std::min(n, i + radius + 1); ++k) {
+            const float w = static_cast<float>(radius + 1 - (k > i ? k - i : i - k));
+            ground += w * this->supportGround[k];
+            clearance += w * this->supportClearance[k];
+            legs += w * this->supportLegs[k];
         }
-        float spineLen = std::sqrt(spineX * spineX + spineY * spineY);
-        if (spineLen < 0.001f) {
-            spineX = 1.f;
-            spineY = 0.f;
-            spineLen = 1.f;
+        if (legs <= 0.f) easeBodyZ(segments[i], feetGround(segments[i]) + meanClearance);
+        else easeBodyZ(segments[i], ground / legs + (clearance + kSuspensionPrior * meanClearance) / (legs + kSuspensionPrior));
+    }
+
+    // Pass 2: solve fully-3D leg IK (yaw + pitch + knee) using the current suspended body height.
+    // Runs the kernel specialized for this body plan; legs whose inputs are unchanged and
+    // whose angles have settled are skipped.
+    if (!solveIk) {
+        size_t legCount = 0;
+        for (const auto &seg : segments) legCount += seg.legs.size();
+        this->ikSolvedLastTick = 0;
+        this->ikSkippedLastTick = legCount;
+        return;
+    }
+    ik::chainStats().reset();
+    morph::IkPassCounters ikCounters;
+    this->ikPassKernel(segments, ikCounters);
+    this->ikSolvedLastTick = ikCounters.solved;
+    this->ikSkippedLastTick = ikCounters.skipped;
+    this->legsConverged = ikCounters.solved == 0;
+
+    if (this->snapLegs) {
+        // Legs resuming from the ghost tier: take the solution as-is instead of easing
+        // toward it from the frozen angles.
+        for (auto &seg : segments) {
+            for (auto &leg : seg.legs) {
+                leg.hipYaw = leg.targetHipYaw;
+                leg.kneeAngle = leg.targetKneeAngle;
+                leg.footAngle = leg.targetFootAngle;
+                leg.ankleAngle = leg.targetAnkleAngle;
+            }
         }
-        spineX /= spineLen;
-        spineY /= spineLen;
-        float perpX = -spineY;
-        float perpY = spineX;
+        this->snapLegs = false;
+    }
+}
 
-        const float stanceWidth = kStanceWidth;
+// Baked leg animation: joint angles straight from the gait clips, no foot planning or IK.
+// The body eases to the height the clips were baked at.
+void Centipede::animateLegsBaked(float gaitAdvance, float headMove) {
+    // Ease in for a few ticks after switching, with the IK pass's smoothing factor.
+    const float blend = this->clipBlendTicks > 0 ? 0.2f : 1.f;
+    if (this->clipBlendTicks > 0) this->clipBlendTicks--;
+    if (this->cpg) {
+        this->cpg->setDrive(this->cpgBody, gaitAdvance, headMove);
+        anim::playClips(segments, *this->cpg, this->cpgBody, this->animSpeed, blend);
+    } else {
+        anim::playClips(segments, this->gaitTime, this->animSpeed, blend);
+    }
+    // Clips are baked on flat ground: ride at their height over the ground under each segment.
+    for (auto &seg : segments) easeBodyZ(seg, terrain::groundHeight(seg.x, seg.y) + anim::kClipBodyZ);
+    this->ikSolvedLastTick = 0;
+    this->ikSkippedLastTick = 0;
+    this->legsConverged = this->clipBlendTicks == 0;
+}
 
-        float midX = (i < segments.size() - 1) ? (segments[i].x + segments[i + 1].x) * 0.5f : segments[i].x;
-        float midY = (i < segments.size() - 1) ? (segments[i].y + segments[i + 1].y) * 0.5f : segments[i].y;
+void Centipede::update() {
+    // Idle: nothing moves but the breath until input wakes the body (see wakeFromIdle).
+    if (this->idleState == IdleState::Idle) { updateIdle(); return; }
 
-        for (auto &leg : seg.legs) {
-            float attachX = midX + perpX * (stanceWidth * static_cast<float>(leg.side));
-            float attachY = midY + perpY * (stanceWidth * static_cast<float>(leg.side));
+    // Gallop-style gait: legs move in coordinated bursts
+    // Like a horse but with many legs - creates powerful pushing motion
+    
+    // Advance gait time: scale with real movement so legs "walk" toward the mouse destination.
+    // (Idle is slow; moving faster increases cadence.)
 
-            float coxaAttachX = attachX + perpX * leg.coxaLength * static_cast<float>(leg.side);
-            float coxaAttachY = attachY + perpY * leg.coxaLength * static_cast<float>(leg.side);
+    if (legDriven()) driveFromLegs();
 
-            const float outDirX = perpX * static_cast<float>(leg.side);
-            const float outDirY = perpY * static_cast<float>(leg.side);
-            const float yawRef = std::atan2(outDirY, outDirX);
+    // Track movement for reference
+    const float headMove = fastmath::sqrt(this->headStepX * this->headStepX + this->headStepY * this->headStepY);
+    this->headStepX = this->headStepY = 0.f;
 
-            ik::solveLeg(leg, coxaAttachX, coxaAttachY, g_bodyZ, yawRef);
-        }
+    // After a while without head movement stop the gait: swinging legs land where they
+    // were heading and the IK eases them down, then the body drops into the idle path.
+    if (headMove > 0.f) {
+        this->stillTicks = 0;
+    } else if (++this->stillTicks >= kIdleSettleTicks && this->idleState == IdleState::Active) {
+        gait::landSwingingLegs(segments, this->lastMoveDx, this->lastMoveDy);
+        this->idleState = IdleState::Settling;
+    }
+
+    if (xpbdActive()) stepXpbd();
+    else if (chainActive()) stepChain();
+
+    // Leg-driven, the cadence is whatever covers the commanded speed with full strides
+    // (and there is no idle cadence: stepping in place would push the body along).
+    float gaitAdvance = kIdleGaitAdvance + headMove * kGaitPerUnit;
+    if (legDriven()) {
+        const float stride = gait::strideLength(segments[0].legs[0], segments[0].bodyZ);
+        const float drive = fastmath::sqrt(this->driveX * this->driveX + this->driveY * this->driveY);
+        gaitAdvance = stride > 1e-3f ? drive * (gait::kStanceFrac * 6.28318531f) / stride : 0.f;
+    }
+    if (this->idleState == IdleState::Settling) gaitAdvance = 0.f;
+    this->gaitTime += gaitAdvance;
+
+    this->animSpeed += (headMove - this->animSpeed) * kAnimSpeedSmoothing;
+    this->tierTick++;
+    if (this->simTier == lod::SimTier::Ghost) {
+        // Legs stay frozen; keep the CPG body driven so its phases are current on promotion.
+        if (this->cpg) this->cpg->setDrive(this->cpgBody, gaitAdvance, headMove);
+        this->ikSolvedLastTick = 0;
+        this->ikSkippedLastTick = 0;
+        this->legsConverged = true;
+    } else if (this->legAnimation == anim::LegAnimation::Baked) {
+        animateLegsBaked(gaitAdvance, headMove);
+    } else {
+        const bool solveIk = this->simTier == lod::SimTier::Full || this->snapLegs
+                             || this->tierTick % lod::kReducedIkInterval == 0;
+        animateLegsFull(gaitAdvance, headMove, solveIk);
     }
 
     // Update follower positions
@@ -426,23 +676,142 @@ void Centipede::update() {
         segments[i].py += (targetY - segments[i].py) * Centipede::followSpeed;
     }
 
+    if (this->simTier != lod::SimTier::Full) {
+        this->voxelAwakeLastTick = 0;
+        this->voxelAsleepLastTick = 0;
+    } else if (!xpbdActive()) {
+        updateVoxels();
+    }
+
+    // Forward kinematics once per tick; rendering only projects these joints.
+    if (this->simTier != lod::SimTier::Ghost) {
+        pose::buildPose(segments, this->pose);
+        measureFootSlip();
+    }
+
+    // The pose only changes with the gait and IK, so it is final once the legs settle.
+    // Voxels are frozen as they are; they are not part of the pose.
+    if (this->idleState == IdleState::Settling && this->legsConverged) {
+        this->idleState = IdleState::Idle;
+        for (auto &seg : segments) { seg.px = seg.x; seg.py = seg.y; }
+    }
+}
+
+// Idle fast path: the pose stays as the last full update left it, plus the breath.
+void Centipede::updateIdle() {
+    this->ikSolvedLastTick = 0;
+    this->ikSkippedLastTick = this->pose.legCount();
+    this->voxelAwakeLastTick = 0;
+    this->voxelAsleepLastTick = 0;
+    if (this->idleMode != IdleMode::Breathe || this->simTier == lod::SimTier::Ghost) return;
+    this->breathPhase += kBreathRate;
+    if (this->breathPhase > 6.28318531f) this->breathPhase -= 6.28318531f;
+    const float offset = kBreathAmplitude * fastmath::sin(this->breathPhase);
+    pose::offsetBody(this->pose, offset - this->breathOffset);
+    this->breathOffset = offset;
+}
+
+void Centipede::wakeFromIdle() {
+    this->stillTicks = 0;
+    if (this->idleState == IdleState::Active) return;
+    // The gait stopped with every foot planted; rebuild the schedule from there.
+    this->gaitScheduler.reset();
+    pose::offsetBody(this->pose, -this->breathOffset);
+    this->breathPhase = 0.f;
+    this->breathOffset = 0.f;
+    this->idleState = IdleState::Active;
+}
+
+void Centipede::updateVoxels() {
     // Soft-body: every voxel drifts toward its segment center; stronger when the segment moved.
+    // Segments at rest for a while fall asleep and are skipped until they move or are pushed.
+    constexpr int64_t sleepSpeed2 = int64_t(kVoxelSleepSpeed) * kVoxelSleepSpeed;
+    constexpr int64_t sleepOffset2 = int64_t(kVoxelSleepOffset) * kVoxelSleepOffset;
+    this->voxelAwakeLastTick = 0;
+    this->voxelAsleepLastTick = 0;
     for (auto &seg : segments) {
-        for (auto &v : seg.voxels) {
-            if (!v.filled) continue;
-            float targetWx = seg.x + v.baseOx; float targetWy = seg.y + v.baseOy; float k_center = 0.04f; v.vx += (targetWx - v.wx) * k_center; v.vy += (targetWy - v.wy) * k_center;
-            if (seg.moved) { float k_move = 0.12f; v.vx += (targetWx - v.wx) * k_move; v.vy += (targetWy - v.wy) * k_move; } // stronger spring after movement
-            v.vx *= 0.85f; v.vy *= 0.85f; v.wx += v.vx; v.wy += v.vy;
+        // `sleepX/Y` is the position last tick (frozen while asleep); any change wakes it.
+        const bool stayed = seg.x == seg.sleepX && seg.y == seg.sleepY;
+        seg.sleepX = seg.x; seg.sleepY = seg.y;
+        if (seg.asleep) {
+            if (stayed) { this->voxelAsleepLastTick++; continue; }
+            wakeVoxels(seg);
+        }
+        this->voxelAwakeLastTick++;
+        bool still = stayed;
+        const math::Fixed segFx = math::toFixed(seg.x), segFy = math::toFixed(seg.y);
+        const math::Factor pull = seg.moved ? kCentrePull + kMovedPull : kCentrePull; // stronger spring after movement
+        const morph::RotatedMask &rest = this->bodyMask->forHeading(seg.heading);
+        for (size_t vi = 0; vi < seg.voxels.size(); ++vi) {
+            Voxel &v = seg.voxels[vi];
+            const math::Fixed targetWx = segFx + rest.offX[vi], targetWy = segFy + rest.offY[vi];
+            v.vx = math::fixedScale(v.vx + math::fixedScale(targetWx - v.wx, pull), kVoxelDamping);
+            v.vy = math::fixedScale(v.vy + math::fixedScale(targetWy - v.wy, pull), kVoxelDamping);
+            v.wx += v.vx; v.wy += v.vy;
+            const int64_t ox = targetWx - v.wx, oy = targetWy - v.wy;
+            still = still && (int64_t(v.vx) * v.vx + int64_t(v.vy) * v.vy) < sleepSpeed2 && (ox * ox + oy * oy) < sleepOffset2;
+        }
+        if (!still) { seg.restTicks = 0; continue; }
+        if (++seg.restTicks >= kVoxelSleepTicks) {
+            seg.asleep = true;
+            for (auto &v : seg.voxels) v.vx = v.vy = 0;
         }
     }
 
-    // Rebuild occupancy to eject any overlapping voxels after dynamics.
-    std::unordered_map<uint64_t, std::pair<int,int>> occ; auto cellKey = [](int gx, int gy) -> uint64_t { return (static_cast<uint64_t>(static_cast<uint32_t>(gx))<<32) | static_cast<uint32_t>(gy); };
+    // Rebuild occupancy to eject any overlapping voxels after dynamics. Sleeping voxels
+    // claim their cells first and are never moved; an awake voxel landing on one is
+    // ejected instead and wakes that segment. With every segment asleep there is nothing to eject.
+    if (this->voxelAwakeLastTick == 0) return;
+    physics::Occupancy &occ = this->occupancy;
+    occ.clear();
+    if (this->voxelAsleepLastTick > 0) {
+        for (int si=0; si<static_cast<int>(segments.size()); ++si) {
+            const auto &seg = segments[si]; if (!seg.asleep) continue;
+            for (int vi=0; vi<static_cast<int>(seg.voxels.size()); ++vi) { const Voxel &v = seg.voxels[vi]; occ.add(math::fixedCell(v.wx), math::fixedCell(v.wy), physics::Occupancy::packOwner(si, vi)); }
+        }
+    }
     for (int si=0; si<static_cast<int>(segments.size()); ++si) {
-        auto &seg = segments[si]; for (int vi=0; vi<static_cast<int>(seg.voxels.size()); ++vi) { Voxel &v = seg.voxels[vi]; if (!v.filled) continue; int igx = static_cast<int>(std::floor(v.wx+0.5f)); int igy = static_cast<int>(std::floor(v.wy+0.5f)); uint64_t k = cellKey(igx,igy); if (occ.find(k)==occ.end()) { occ[k] = {si,vi}; continue; }
-            bool placed = false; const float step = 0.25f; for (int radius=1; radius<=6 && !placed; ++radius) { for (int dx=-radius; dx<=radius && !placed; ++dx) { for (int dy=-radius; dy<=radius && !placed; ++dy) { if (std::abs(dx)!=radius && std::abs(dy)!=radius) continue; int nx = igx + dx; int ny = igy + dy; uint64_t nk = cellKey(nx,ny); if (occ.find(nk)==occ.end()) { v.wx = static_cast<float>(nx); v.wy = static_cast<float>(ny); occ[nk] = {si,vi}; placed = true; } } } }
-            if (!placed) { for (int attempt=0; attempt<8 && !placed; ++attempt) { v.wx += v.vx * step; v.wy += v.vy * step; int nx = static_cast<int>(std::floor(v.wx+0.5f)); int ny = static_cast<int>(std::floor(v.wy+0.5f)); uint64_t nk = cellKey(nx,ny); if (occ.find(nk)==occ.end()) { occ[nk] = {si,vi}; placed = true; } } }
-            if (!placed) occ[k] = {si,vi};
+        auto &seg = segments[si]; if (seg.asleep) continue;
+        for (int vi=0; vi<static_cast<int>(seg.voxels.size()); ++vi) { Voxel &v = seg.voxels[vi]; int igx = math::fixedCell(v.wx); int igy = math::fixedCell(v.wy); const uint32_t self = physics::Occupancy::packOwner(si, vi); const uint32_t hit = occ.owner(igx, igy); if (hit==physics::Occupancy::kNoOwner) { occ.add(igx, igy, self); continue; }
+            if (segments[physics::Occupancy::ownerSegment(hit)].asleep) wakeVoxels(segments[physics::Occupancy::ownerSegment(hit)]);
+            bool placed = false; for (int radius=1; radius<=6 && !placed; ++radius) { for (int dx=-radius; dx<=radius && !placed; ++dx) { for (int dy=-radius; dy<=radius && !placed; ++dy) { if (std::abs(dx)!=radius && std::abs(dy)!=radius) continue; int nx = igx + dx; int ny = igy + dy; if (!occ.occupied(nx, ny)) { v.wx = math::cellToFixed(nx); v.wy = math::cellToFixed(ny); occ.add(nx, ny, self); placed = true; } } } }
+            if (!placed) { for (int attempt=0; attempt<8 && !placed; ++attempt) { v.wx += v.vx / 4; v.wy += v.vy / 4; int nx = math::fixedCell(v.wx); int ny = math::fixedCell(v.wy); if (!occ.occupied(nx, ny)) { occ.add(nx, ny, self); placed = true; } } }
+            if (!placed) occ.add(igx, igy, self);
+        }
+    }
+}
+
+void Centipede::rebase(float shiftX, float shiftY) {
+    const math::Fixed shiftFx = math::toFixed(shiftX), shiftFy = math::toFixed(shiftY);
+    for (auto &seg : segments) {
+        seg.x -= shiftX; seg.y -= shiftY;
+        seg.px -= shiftX; seg.py -= shiftY;
+        seg.sleepX -= shiftX; seg.sleepY -= shiftY;
+        for (auto &v : seg.voxels) { v.wx -= shiftFx; v.wy -= shiftFy; }
+        for (auto &leg : seg.legs) {
+            leg.footHoldX -= shiftX; leg.footHoldY -= shiftY;
+            leg.swingStartX -= shiftX; leg.swingStartY -= shiftY;
+            leg.swingLandX -= shiftX; leg.swingLandY -= shiftY;
+            leg.ikFootX -= shiftX; leg.ikFootY -= shiftY;
+            leg.ikAttachX -= shiftX; leg.ikAttachY -= shiftY;
+        }
+    }
+    for (float &x : this->slipFootX) x -= shiftX;
+    for (float &y : this->slipFootY) y -= shiftY;
+    this->headPath.translate(-shiftX, -shiftY);
+    this->chain.translate(-shiftX, -shiftY);
+    this->xpbd.translate(-shiftX, -shiftY);
+    pose::translate(this->pose, -shiftX, -shiftY);
+}
+
+void Centipede::restVoxels() {
+    for (auto &seg : segments) {
+        wakeVoxels(seg);
+        const morph::RotatedMask &rest = this->bodyMask->forHeading(seg.heading);
+        for (size_t vi = 0; vi < seg.voxels.size(); ++vi) {
+            Voxel &v = seg.voxels[vi];
+            v.wx = math::toFixed(seg.x) + rest.offX[vi]; v.wy = math::toFixed(seg.y) + rest.offY[vi];
+            v.vx = v.vy = 0;
         }
     }
 }
@@ -455,13 +824,14 @@ void Centipede::render(sf::RenderWindow* window, float resf) {
     drawGrid(window, resf);
     
     // First pass: Draw all spine sticks
-    for (size_t i = 0; i < segments.size() - 1; ++i) {
-        sf::Vector2f pos1 = gridToIsoZ(segments[i].x, segments[i].y, g_bodyZ, resf, window);
-        sf::Vector2f pos2 = gridToIsoZ(segments[i+1].x, segments[i+1].y, g_bodyZ, resf, window);
-        float stickLen = std::sqrt((pos2.x - pos1.x)*(pos2.x - pos1.x) + (pos2.y - pos1.y)*(pos2.y - pos1.y));
+    const size_t segCount = pose.segmentCount();
+    for (size_t i = 0; i + 1 < segCount; ++i) {
+        sf::Vector2f pos1 = gridToIsoZ(pose.spineX[i], pose.spineY[i], pose.spineZ[i], resf, window);
+        sf::Vector2f pos2 = gridToIsoZ(pose.spineX[i+1], pose.spineY[i+1], pose.spineZ[i+1], resf, window);
+        float stickLen = fastmath::sqrt((pos2.x - pos1.x)*(pos2.x - pos1.x) + (pos2.y - pos1.y)*(pos2.y - pos1.y));
         if (stickLen > 0.1f) { 
             sf::RectangleShape stick(sf::Vector2f(stickLen, resf * 0.2f)); 
-            float stickAngle = std::atan2(pos2.y - pos1.y, pos2.x - pos1.x) * 180.f / 3.14159f; 
+            float stickAngle = fastmath::atan2(pos2.y - pos1.y, pos2.x - pos1.x) * 180.f / 3.14159f; 
             stick.setRotation(stickAngle); 
             stick.setPosition(pos1.x, pos1.y); 
             stick.setFillColor(sf::Color::Red); 
@@ -476,36 +846,15 @@ void Centipede::render(sf::RenderWindow* window, float resf) {
         window->draw(legJoint);
     }
     
-    // Second pass: Draw all coxae
-    for (size_t i = 0; i < segments.size() - 1; ++i) {
-        float spineX = segments[i+1].x - segments[i].x; 
-        float spineY = segments[i+1].y - segments[i].y; 
-        float spineLen = std::sqrt(spineX*spineX + spineY*spineY); 
-        if (spineLen < 0.001f) { spineX = 1.f; spineY = 0.f; spineLen = 1.f; } 
-        spineX /= spineLen; 
-        spineY /= spineLen;
-        float perpX = -spineY; 
-        float perpY = spineX;
-        
-        float midX = (segments[i].x + segments[i+1].x) * 0.5f; 
-        float midY = (segments[i].y + segments[i+1].y) * 0.5f;
-
-        const float stanceWidth = kStanceWidth;
-        
-        for (int side = -1; side <= 1; side += 2) {
-            const auto &leg = segments[i].legs[side == -1 ? 0 : 1];
-            float hipAttachX = midX + perpX * (stanceWidth * static_cast<float>(side)); 
-            float hipAttachY = midY + perpY * (stanceWidth * static_cast<float>(side));
-            
-            // Coxa line: extends perpendicular from the spine to the hip joint
-            float coxaEndX = hipAttachX + perpX * leg.coxaLength * static_cast<float>(side);
-            float coxaEndY = hipAttachY + perpY * leg.coxaLength * static_cast<float>(side);
-            sf::Vector2f coxaStart = gridToIsoZ(hipAttachX, hipAttachY, g_bodyZ, resf, window);
-            sf::Vector2f coxaEnd = gridToIsoZ(coxaEndX, coxaEndY, g_bodyZ, resf, window);
-            float coxaDist = std::sqrt((coxaEnd.x - coxaStart.x)*(coxaEnd.x - coxaStart.x) + (coxaEnd.y - coxaStart.y)*(coxaEnd.y - coxaStart.y));
+    // Second pass: Draw all coxae (hip attach -> hip joint, both from the pose buffer)
+    for (size_t i = 0; i + 1 < segCount; ++i) {
+        for (uint32_t l = pose.legBegin[i]; l < pose.legBegin[i + 1]; ++l) {
+            sf::Vector2f coxaStart = gridToIsoZ(pose.x[pose::HipAttach][l], pose.y[pose::HipAttach][l], pose.z[pose::HipAttach][l], resf, window);
+            sf::Vector2f coxaEnd = gridToIsoZ(pose.x[pose::CoxaEnd][l], pose.y[pose::CoxaEnd][l], pose.z[pose::CoxaEnd][l], resf, window);
+            float coxaDist = fastmath::sqrt((coxaEnd.x - coxaStart.x)*(coxaEnd.x - coxaStart.x) + (coxaEnd.y - coxaStart.y)*(coxaEnd.y - coxaStart.y));
             if (coxaDist > 0.1f) {
                 sf::RectangleShape coxaSeg(sf::Vector2f(coxaDist, resf * 0.1f));
-                float coxaAngle = std::atan2(coxaEnd.y - coxaStart.y, coxaEnd.x - coxaStart.x) * 180.f / 3.14159f;
+                float coxaAngle = fastmath::atan2(coxaEnd.y - coxaStart.y, coxaEnd.x - coxaStart.x) * 180.f / 3.14159f;
                 coxaSeg.setRotation(coxaAngle);
                 coxaSeg.setPosition(coxaStart.x, coxaStart.y);
                 coxaSeg.setFillColor(sf::Color::White);
@@ -515,6 +864,314 @@ void Centipede::render(sf::RenderWindow* window, float resf) {
     }
     
     // Third pass: Draw all leg joints and segments
-    drawhelpers::drawCentipede(window, segments, resf, g_bodyZ);
+    drawhelpers::drawCentipede(window, pose, resf);
 }
 const std::vector<Segment>& Centipede::getSegments() const { return segments; }
+
+const pose::PoseBuffer& Centipede::getPose() const { return pose; }
+
+void Centipede::setLegAnimation(anim::LegAnimation mode) {
+    if (mode == this->legAnimation) return;
+    wakeFromIdle();
+    if (mode == anim::LegAnimation::Full) {
+        // Plant the gait where the clip left the feet, so the switch does not pop.
+        for (size_t i = 0; i < segments.size(); ++i) {
+            for (size_t k = 0; k < segments[i].legs.size(); ++k) {
+                auto &leg = segments[i].legs[k];
+                const uint32_t l = this->pose.legBegin.size() > i ? this->pose.legBegin[i] + static_cast<uint32_t>(k) : 0;
+                if (l < this->pose.x[pose::Foot].size()) {
+                    leg.footHoldX = leg.swingStartX = this->pose.x[pose::Foot][l];
+                    leg.footHoldY = leg.swingStartY = this->pose.y[pose::Foot][l];
+                    leg.footHoldZ = leg.swingStartZ = terrain::groundHeight(leg.footHoldX, leg.footHoldY);
+                }
+            }
+        }
+        this->gaitScheduler.reset();
+    } else {
+        this->clipBlendTicks = kClipBlendTicks;
+    }
+    this->legAnimation = mode;
+}
+
+anim::LegAnimation Centipede::getLegAnimation() const { return this->legAnimation; }
+
+void Centipede::setSimTier(lod::SimTier tier) {
+    if (tier == this->simTier) return;
+    // Switch the leg animation first: leaving baked clips plants the feet where the pose
+    // has them, which the ghost re-plant below must override.
+    setLegAnimation(lod::bakedLegs(tier) ? anim::LegAnimation::Baked : anim::LegAnimation::Full);
+    wakeFromIdle();
+    if (this->simTier == lod::SimTier::Ghost) {
+        // The legs were frozen while the spine moved on: plant them under the body as it
+        // is now and let the next solve land exactly. Ghosts are promoted before they
+        // reach the view (see lod::LodParams::viewMargin), so this is not seen.
+        gait::replantLegs(segments, this->lastMoveDx, this->lastMoveDy);
+        this->gaitScheduler.reset();
+        this->snapLegs = true;
+    }
+    // Voxels were left behind by the spine-only moves; the soft-body resumes from rest.
+    if (tier == lod::SimTier::Full) {
+        restVoxels();
+        if (this->bodyDynamics == BodyDynamics::Xpbd) syncXpbd();
+        else if (this->bodyDynamics == BodyDynamics::Articulated) buildChain();
+    }
+    this->simTier = tier;
+}
+
+lod::SimTier Centipede::getSimTier() const { return this->simTier; }
+
+void Centipede::setIdleMode(IdleMode mode) {
+    if (mode == IdleMode::Freeze) {
+        pose::offsetBody(this->pose, -this->breathOffset);
+        this->breathOffset = 0.f;
+    }
+    this->idleMode = mode;
+}
+
+bool Centipede::isIdle() const { return this->idleState == IdleState::Idle; }
+
+bool Centipede::xpbdActive() const {
+    return this->bodyDynamics == BodyDynamics::Xpbd && this->simTier == lod::SimTier::Full;
+}
+
+// Segments keep one voxel block of spacing (their construction layout); each voxel blob
+// holds its rest shape and its centroid on its segment. Voxels weigh a quarter of a
+// segment, so blobs give way to the spine rather than the reverse.
+void Centipede::buildXpbd() {
+    restVoxels();
+    this->xpbd.clear();
+    for (size_t i = 0; i < segments.size(); ++i) {
+        this->xpbd.addParticle(segments[i].x, segments[i].y, i == 0 ? 0.f : 1.f);
+        if (i > 0) {
+            this->xpbd.addDistance(static_cast<uint32_t>(i - 1), static_cast<uint32_t>(i),
+                                   static_cast<float>(segments[i].voxW), this->xpbdParams.spineCompliance);
+        }
+    }
+    std::vector<uint32_t> blob;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        blob.clear();
+        float ox = 0.f, oy = 0.f;
+        for (const auto &v : segments[i].voxels) {
+            blob.push_back(this->xpbd.addParticle(math::toFloat(v.wx), math::toFloat(v.wy), 4.f, static_cast<uint32_t>(i)));
+            ox += math::toFloat(v.baseOx); oy += math::toFloat(v.baseOy);
+        }
+        if (blob.empty()) continue;
+        const float n = static_cast<float>(blob.size());
+        this->xpbd.addShape(blob.data(), blob.size(), this->xpbdParams.shapeCompliance);
+        this->xpbd.addAttachment(blob.data(), blob.size(), static_cast<uint32_t>(i), ox / n, oy / n,
+                                 this->xpbdParams.attachCompliance);
+    }
+    this->xpbd.color();
+}
+
+// Copy segment and voxel positions into the solver (after other code moved the body).
+void Centipede::syncXpbd() {
+    uint32_t p = 0;
+    for (const auto &seg : segments) this->xpbd.resetPosition(p++, seg.x, seg.y);
+    for (const auto &seg : segments) {
+        for (const auto &v : seg.voxels) this->xpbd.resetPosition(p++, math::toFloat(v.wx), math::toFloat(v.wy));
+    }
+}
+
+// One solver tick with the head as a kinematic particle, then copy the result back.
+void Centipede::stepXpbd() {
+    this->xpbd.setPosition(0, segments[0].x, segments[0].y);
+    this->xpbd.step(this->xpbdParams);
+    // The solver places the followers; the head path re-seeds from them if it takes over.
+    this->headPathStale = true;
+
+    for (size_t i = 1; i < segments.size(); ++i) {
+        Segment &seg = segments[i];
+        const float nx = this->xpbd.posX(static_cast<uint32_t>(i)), ny = this->xpbd.posY(static_cast<uint32_t>(i));
+        seg.moved = std::abs(nx - seg.x) > 1e-4f || std::abs(ny - seg.y) > 1e-4f;
+        seg.x = nx; seg.y = ny;
+        float dx_to_pred = segments[i-1].x - seg.x; float dy_to_pred = segments[i-1].y - seg.y;
+        float dist_to_pred = fastmath::sqrt(dx_to_pred*dx_to_pred + dy_to_pred*dy_to_pred);
+        if (dist_to_pred > 0.1f) {
+            math::Rot2 target{dx_to_pred / dist_to_pred, dy_to_pred / dist_to_pred};
+            seg.heading = math::nlerp(seg.heading, target, 0.15f);
+        }
+    }
+    uint32_t p = static_cast<uint32_t>(segments.size());
+    for (auto &seg : segments) {
+        for (auto &v : seg.voxels) {
+            v.wx = math::toFixed(this->xpbd.posX(p)); v.wy = math::toFixed(this->xpbd.posY(p));
+            // Voxel velocities are kept in grid units per tick like the spring model's.
+            v.vx = math::toFixed(this->xpbd.velX(p) * this->xpbdParams.dt); v.vy = math::toFixed(this->xpbd.velY(p) * this->xpbdParams.dt);
+            ++p;
+        }
+    }
+    this->voxelAwakeLastTick = segments.size();
+    this->voxelAsleepLastTick = 0;
+}
+
+bool Centipede::legDriven() const {
+    return this->locomotion == gait::Locomotion::LegDriven && this->simTier != lod::SimTier::Ghost
+           && this->legAnimation == anim::LegAnimation::Full && !chainActive();
+}
+
+// Smooth the walking command, then move the body by the planted legs' ground forces from
+// the last gait step: their strength-weighted mean is how far the body must move for the
+// feet to stay on their holds as the stance sweep goes on. Only the part along the
+// walking direction propels (the spine follows the head, so sideways offsets of the holds
+// are the body's curve, not push), and legs do not pull the body back.
+void Centipede::driveFromLegs() {
+    this->driveX += (this->pendingDriveX - this->driveX) * kDriveSmoothing;
+    this->driveY += (this->pendingDriveY - this->driveY) * kDriveSmoothing;
+    this->pendingDriveX = this->pendingDriveY = 0.f;
+    if (std::abs(this->driveX) < kDriveStop && std::abs(this->driveY) < kDriveStop) this->driveX = this->driveY = 0.f;
+
+    gait::accumulateGroundForces(segments, this->groundForces);
+    if (this->groundForces.totalWeight <= 0.f) return;
+    const gait::Heading heading = gait::computeHeading(segments, this->lastMoveDx, this->lastMoveDy);
+    const float push = kGroundForceGain * (this->groundForces.totalX * heading.forwardX + this->groundForces.totalY * heading.forwardY)
+                       / this->groundForces.totalWeight;
+    const float drive = fastmath::sqrt(this->driveX * this->driveX + this->driveY * this->driveY);
+    const float move = std::min({push, drive, Centipede::maxMovePerTry});
+    if (move < kDriveStop) return;
+    moveHead(heading.forwardX * move, heading.forwardY * move);
+}
+
+// Travel of each planted foot since the last tick (pose order), over legs that were
+// planted on both ticks.
+void Centipede::measureFootSlip() {
+    const size_t legs = this->pose.legCount();
+    const auto &fx = this->pose.x[pose::Foot];
+    const auto &fy = this->pose.y[pose::Foot];
+    const bool fresh = this->slipFootX.size() != legs;
+    if (fresh) {
+        this->slipFootX.assign(legs, 0.f);
+        this->slipFootY.assign(legs, 0.f);
+        this->slipPlanted.assign(legs, 0);
+    }
+    gait::FootSlip slip;
+    float sum = 0.f;
+    size_t l = 0;
+    for (const auto &seg : segments) {
+        for (const auto &leg : seg.legs) {
+            if (leg.onGround && this->slipPlanted[l] && !fresh) {
+                const float d = fastmath::sqrt((fx[l] - this->slipFootX[l]) * (fx[l] - this->slipFootX[l]) +
+                                               (fy[l] - this->slipFootY[l]) * (fy[l] - this->slipFootY[l]));
+                sum += d;
+                slip.max = std::max(slip.max, d);
+                slip.planted++;
+            }
+            this->slipFootX[l] = fx[l];
+            this->slipFootY[l] = fy[l];
+            this->slipPlanted[l] = leg.onGround ? 1 : 0;
+            l++;
+        }
+    }
+    slip.mean = slip.planted > 0 ? sum / static_cast<float>(slip.planted) : 0.f;
+    this->footSlip = slip;
+}
+
+void Centipede::setLocomotion(gait::Locomotion mode) {
+    if (mode == this->locomotion) return;
+    wakeFromIdle();
+    this->locomotion = mode;
+    this->driveX = this->driveY = this->pendingDriveX = this->pendingDriveY = 0.f;
+    // The scheduler's wheel is stale after the per-tick gait path; rebuild it on return.
+    this->gaitScheduler.reset();
+    // Start from planted feet under the body, so old holds do not read as a push.
+    if (mode == gait::Locomotion::LegDriven) gait::replantLegs(segments, this->lastMoveDx, this->lastMoveDy);
+}
+
+gait::Locomotion Centipede::getLocomotion() const { return this->locomotion; }
+
+const gait::FootSlip& Centipede::getFootSlip() const { return this->footSlip; }
+
+bool Centipede::chainActive() const {
+    return this->bodyDynamics == BodyDynamics::Articulated && this->simTier == lod::SimTier::Full;
+}
+
+// One link per segment, a voxel block long, starting from the spine as it stands.
+void Centipede::buildChain() {
+    std::vector<float> xs, ys, lengths;
+    xs.reserve(segments.size()); ys.reserve(segments.size()); lengths.reserve(segments.size());
+    for (const auto &seg : segments) {
+        xs.push_back(seg.x);
+        ys.push_back(seg.y);
+        lengths.push_back(static_cast<float>(seg.voxW));
+    }
+    this->chain.build(xs.data(), ys.data(), lengths.data(), segments.size(), this->chainParams.linkMass);
+}
+
+// Planted legs push their segment at the commanded walking speed and grip against sideways
+// slip, both scaled by the leg's pushStrength; then one chain step, copied back. A body
+// that has come to rest at its target is not stepped (see kChainRestSpeed).
+void Centipede::stepChain() {
+    if (this->chain.targetSpeed() < 1e-3f && this->chain.maxSpeed() < kChainRestSpeed
+        && this->chain.headTargetDistance() < kChainRestDistance) {
+        this->chain.halt();
+        for (auto &seg : segments) seg.moved = false;
+        return;
+    }
+    const float walkSpeed = this->chain.targetSpeed();
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const float fwdX = this->chain.forwardX(i), fwdY = this->chain.forwardY(i);
+        const float cx = this->chain.posX(i), cy = this->chain.posY(i);
+        for (const auto &L : segments[i].legs) {
+            if (!L.onGround) continue;
+            // Hip on the leg's side of the spine.
+            const float hx = cx - fwdY * kStanceWidth * static_cast<float>(L.side);
+            const float hy = cy + fwdX * kStanceWidth * static_cast<float>(L.side);
+            float vx, vy;
+            this->chain.pointVelocity(i, hx, hy, vx, vy);
+            const float along = vx * fwdX + vy * fwdY;
+            const float across = -vx * fwdY + vy * fwdX;
+            const float thrust = L.pushStrength * kLegThrust * (walkSpeed - along);
+            const float grip = -L.pushStrength * kLegGrip * across;
+            this->chain.addForce(i, hx, hy, thrust * fwdX - grip * fwdY, thrust * fwdY + grip * fwdX);
+        }
+    }
+    this->chain.step(this->chainParams);
+    // The chain places the followers; the head path re-seeds from them if it takes over.
+    this->headPathStale = true;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        Segment &seg = segments[i];
+        const float nx = this->chain.posX(i), ny = this->chain.posY(i);
+        if (i == 0) { this->headStepX += nx - seg.x; this->headStepY += ny - seg.y; }
+        seg.moved = std::abs(nx - seg.x) > 1e-4f || std::abs(ny - seg.y) > 1e-4f;
+        seg.x = nx; seg.y = ny;
+        seg.heading = math::Rot2{this->chain.forwardX(i), this->chain.forwardY(i)};
+    }
+}
+
+void Centipede::setBodyDynamics(BodyDynamics mode, const physics::XpbdParams &params) {
+    wakeFromIdle();
+    this->xpbdParams = params;
+    this->bodyDynamics = mode;
+    // Compliances are baked into the constraints, so rebuild on every call.
+    if (mode == BodyDynamics::Xpbd) buildXpbd();
+    else this->xpbd.clear();
+    if (mode == BodyDynamics::Articulated) buildChain();
+}
+
+void Centipede::setBodyDynamics(BodyDynamics mode, const physics::ChainParams &params) {
+    this->chainParams = params;
+    setBodyDynamics(mode, this->xpbdParams);
+}
+
+BodyDynamics Centipede::getBodyDynamics() const { return this->bodyDynamics; }
+
+const physics::XpbdStats& Centipede::getXpbdStats() const { return this->xpbd.lastStats(); }
+
+void Centipede::attachCpg(gait::CpgNetwork *network) {
+    wakeFromIdle();
+    if (this->cpg) this->cpg->removeBody(this->cpgBody);
+    this->cpg = network;
+    if (network) this->cpgBody = network->addBody(segments.size());
+    // The scheduler's wheel is stale after running on the CPG; rebuild it on return.
+    else this->gaitScheduler.reset();
+}
+
+size_t Centipede::getAwakeSegmentCount() const { return this->voxelAwakeLastTick; }
+
+size_t Centipede::getSleepingSegmentCount() const { return this->voxelAsleepLastTick; }
+
+float Centipede::getIkSkipRatio() const {
+    size_t total = this->ikSolvedLastTick + this->ikSkippedLastTick;
+    return total > 0 ? static_cast<float>(this->ikSkippedLastTick) / static_cast<float>(total) : 0.f;
+}
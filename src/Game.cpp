@@ -1,6 +1,7 @@
 #include "Game.hpp"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include <SFML/Window.hpp>
 
 #include "render/Projection.hpp"
@@ -22,8 +23,21 @@ void Game::initWindow() {
     this->window->setFramerateLimit(60);
 }
 
-Game::Game() { initVar(); initWindow(); centipede = new Centipede(40,10,14); }
-Game::~Game() { delete window; delete centipede; }
+// Chunks evicted from memory go to a store next to the executable.
+static world::WorldParams gameWorldParams() {
+    world::WorldParams params;
+    params.maxResident = 96;
+    params.storePath = "world.chunks";
+    return params;
+}
+
+Game::Game() : world(gameWorldParams()) {
+    initVar(); initWindow();
+    world::setActive(&this->world);
+    terrain::setActive(&this->world.ground());
+    centipede = new Centipede(40,10,14);
+}
+Game::~Game() { delete window; delete centipede; terrain::setActive(nullptr); world::setActive(nullptr); }
 bool Game::getWinIsOpen() { return window->isOpen(); }
 
 void Game::update() {
@@ -81,9 +95,56 @@ void Game::update() {
         }
     }
 
+    rebaseOrigin(static_cast<float>(res) * this->zoom);
+    updateSimTier(*centipede, static_cast<float>(res) * this->zoom);
+    streamWorld(static_cast<float>(res) * this->zoom);
     centipede->update();
 }
 
+// Tier from the camera: distance of the head from the view centre (grid units) and
+// whether the body's projected bounds overlap the window.
+void Game::updateSimTier(Centipede &c, float resf) {
+    const auto &segs = c.getSegments();
+    if (segs.empty()) return;
+    const sf::Vector2f viewCentre = screenToGrid(width * 0.5f, height * 0.5f, resf, window);
+    const float dx = segs[0].px - viewCentre.x, dy = segs[0].py - viewCentre.y;
+    const float distance = std::sqrt(dx*dx + dy*dy);
+
+    sf::Vector2f lo = gridToIso(segs[0].px, segs[0].py, resf, window), hi = lo;
+    for (const auto &s : segs) {
+        const sf::Vector2f p = gridToIso(s.px, s.py, resf, window);
+        lo.x = std::min(lo.x, p.x); lo.y = std::min(lo.y, p.y);
+        hi.x = std::max(hi.x, p.x); hi.y = std::max(hi.y, p.y);
+    }
+    const bool visible = lod::overlapsView(lo.x, lo.y, hi.x, hi.y, static_cast<float>(width), static_cast<float>(height), this->lodParams.viewMargin);
+    c.setSimTier(lod::selectTier(c.getSimTier(), distance, visible, this->lodParams));
+}
+
+// Keep the chunks around the centipede and the view resident (the radius covers the body
+// and its legs, and the window's diagonal in grid units; capped so a zoomed-out view
+// stays within the resident budget).
+void Game::streamWorld(float resf) {
+    const auto &segs = centipede->getSegments();
+    if (!segs.empty()) this->world.streamAround(segs[0].x, segs[0].y, static_cast<float>(segs.size()) * 3.f + 8.f);
+    const sf::Vector2f viewCentre = screenToGrid(width * 0.5f, height * 0.5f, resf, window);
+    const float viewRadius = std::min(static_cast<float>(width + height) / resf, 3.5f * static_cast<float>(world::kChunkCells));
+    this->world.streamAround(viewCentre.x, viewCentre.y, viewRadius);
+}
+
+// Floating origin: once the centipede wanders a few chunks from the local origin, move
+// the origin under it and shift everything that holds local positions in the same tick
+// (the body, the destination, the camera), so nothing on screen or in play changes.
+void Game::rebaseOrigin(float resf) {
+    const auto &segs = centipede->getSegments();
+    if (segs.empty()) return;
+    float shiftX = 0.f, shiftY = 0.f;
+    if (!this->world.rebaseToward(segs[0].x, segs[0].y, shiftX, shiftY)) return;
+    centipede->rebase(shiftX, shiftY);
+    this->moveTargetGrid.x -= shiftX;
+    this->moveTargetGrid.y -= shiftY;
+    input::rebaseCamera(shiftX, shiftY, resf);
+}
+
 void Game::render() {
     window->clear(sf::Color::Black);
     
@@ -0,0 +1,217 @@
+#include "GaitClip.hpp"
+#include "../../include/Centipede.hpp"
+#include "../gait/GaitController.hpp"
+#include "../gait/Cpg.hpp"
+#include "../morph/Kernels.hpp"
+#include "../terrain/Heightfield.hpp"
+#include <cmath>
+#include <algorithm>
+#include <memory>
+
+namespace anim {
+
+static constexpr float kTwoPi = 6.28318531f;
+// Joint angles are within [-pi, pi] and yaw components within [-1, 1].
+static constexpr float kAngleQuant = 32767.f / 3.14159265f;
+static constexpr float kUnitQuant = 32767.f;
+
+// Reference body: a straight walker long enough that the recorded segment has
+// neighbours on both sides, like any mid-body segment in the sim.
+static constexpr int kBakeSegments = 6;
+static constexpr int kRecordSegment = 2;
+static constexpr int kMinRecordTicks = 2048;
+
+static int16_t quantize(float v, float scale) {
+    return static_cast<int16_t>(std::clamp(std::lround(v * scale), -32767L, 32767L));
+}
+
+GaitClip::GaitClip(float hipLength, float kneeLength, float footLength, float bodyZ)
+    : L1(hipLength), L2(kneeLength), L3(footLength), z(bodyZ) {
+    samples.resize(static_cast<size_t>(kClipSpeeds) * 2 * kClipPhaseBins);
+    // Bake on the flat plane z = 0 whatever terrain is active: clips must not depend on
+    // the ground near the origin when they are first needed, and the reference walk must
+    // not sample (and stream in) the live world's chunks.
+    terrain::Heightfield *ground = terrain::active();
+    terrain::setActive(nullptr);
+    for (int s = 0; s < kClipSpeeds; ++s) bakeSpeed(s);
+    terrain::setActive(ground);
+}
+
+void GaitClip::bakeSpeed(int speedIndex) {
+    const float speed = static_cast<float>(speedIndex) * kClipSpeedStep;
+    std::vector<Segment> segments = Centipede(0, 0, kBakeSegments).getSegments();
+    for (auto &seg : segments) {
+        seg.bodyZ = z;
+        for (auto &leg : seg.legs) {
+            leg.hipLength = L1;
+            leg.kneeLength = L2;
+            leg.footLength = L3;
+        }
+    }
+    const morph::IkPassKernel ikPass = morph::ikPassKernelFor<3, 1>();
+    const float advance = kIdleGaitAdvance + speed * kGaitPerUnit;
+    const int cycleTicks = static_cast<int>(std::ceil(kTwoPi / advance));
+
+    // Per bin: sums of each channel and the sample count.
+    struct Acc {
+        float yawC = 0.f, yawS = 0.f, hipPitch = 0.f, knee = 0.f, ankle = 0.f;
+        int n = 0;
+    };
+    std::vector<Acc> acc(2 * kClipPhaseBins);
+
+    // Walk three cycles to settle foot holds and smoothing, then record. At high speeds a
+    // tick covers a large part of the cycle, so record long enough to hit every bin.
+    const int warmup = 3 * cycleTicks;
+    const int record = std::max(2 * cycleTicks, kMinRecordTicks);
+    float gaitTime = 0.f;
+    for (int tick = 0; tick < warmup + record; ++tick) {
+        for (auto &seg : segments) seg.x += speed;
+        gaitTime += advance;
+        gait::updateGait(segments, gaitTime, speed, 0.f);
+        morph::IkPassCounters counters;
+        ikPass(segments, counters);
+        if (tick < warmup) continue;
+
+        // Straight walk along +x: the spine runs to -x, so the outward direction of side
+        // `side` is (0, -side) for the perpendicular (-spineY, spineX) = (0, -1).
+        for (const auto &leg : segments[kRecordSegment].legs) {
+            const float phase = gait::legPhase(gaitTime, leg.phaseOffset);
+            int bin = static_cast<int>(phase * (static_cast<float>(kClipPhaseBins) / kTwoPi) + 0.5f) % kClipPhaseBins;
+            const math::Rot2 outward{0.f, -static_cast<float>(leg.side)};
+            const math::Rot2 rel = outward.conj() * leg.hipYaw;
+            Acc &a = acc[(leg.side < 0 ? 0 : 1) * kClipPhaseBins + bin];
+            a.yawC += rel.c;
+            a.yawS += rel.s;
+            a.hipPitch += leg.kneeAngle;
+            a.knee += leg.footAngle;
+            a.ankle += leg.ankleAngle;
+            a.n++;
+        }
+    }
+
+    for (int side = 0; side < 2; ++side) {
+        Acc *bins = &acc[side * kClipPhaseBins];
+        // Bins the walk never landed in take the average of the nearest filled neighbours.
+        for (int b = 0; b < kClipPhaseBins; ++b) {
+            if (bins[b].n > 0) continue;
+            int lo = b, hi = b;
+            do { lo = (lo + kClipPhaseBins - 1) % kClipPhaseBins; } while (bins[lo].n <= 0 && lo != b);
+            do { hi = (hi + 1) % kClipPhaseBins; } while (bins[hi].n <= 0 && hi != b);
+            if (bins[lo].n <= 0) break; // nothing recorded at all
+            const Acc &a = bins[lo], &c = bins[hi];
+            Acc &m = bins[b];
+            m.yawC = 0.5f * (a.yawC / a.n + c.yawC / c.n);
+            m.yawS = 0.5f * (a.yawS / a.n + c.yawS / c.n);
+            m.hipPitch = 0.5f * (a.hipPitch / a.n + c.hipPitch / c.n);
+            m.knee = 0.5f * (a.knee / a.n + c.knee / c.n);
+            m.ankle = 0.5f * (a.ankle / a.n + c.ankle / c.n);
+            m.n = -1; // holds an average already; skipped as a neighbour for later gaps
+        }
+        for (int b = 0; b < kClipPhaseBins; ++b) {
+            const Acc &a = bins[b];
+            const float inv = a.n > 0 ? 1.f / static_cast<float>(a.n) : 1.f;
+            const math::Rot2 yaw = math::Rot2::fromVector(a.yawC * inv, a.yawS * inv);
+            Sample &out = samples[(static_cast<size_t>(speedIndex) * 2 + side) * kClipPhaseBins + b];
+            out.yawC = quantize(yaw.c, kUnitQuant);
+            out.yawS = quantize(yaw.s, kUnitQuant);
+            out.hipPitch = quantize(a.hipPitch * inv, kAngleQuant);
+            out.knee = quantize(a.knee * inv, kAngleQuant);
+            out.ankle = quantize(a.ankle * inv, kAngleQuant);
+        }
+    }
+}
+
+GaitClip::Angles GaitClip::sample(int side, float phase, float speed) const {
+    // Phase in bins, wrapped into [0, kClipPhaseBins) without floor (truncate, then fix
+    // up negatives).
+    float p = phase * (static_cast<float>(kClipPhaseBins) / kTwoPi);
+    int wraps = static_cast<int>(p * (1.f / static_cast<float>(kClipPhaseBins)));
+    if (p < 0.f) --wraps;
+    p -= static_cast<float>(wraps * kClipPhaseBins);
+    const int b0 = std::min(static_cast<int>(p), kClipPhaseBins - 1);
+    const int b1 = (b0 + 1) & (kClipPhaseBins - 1);
+    const float tp = p - static_cast<float>(b0);
+
+    const float sp = std::clamp(speed * (1.f / kClipSpeedStep), 0.f, static_cast<float>(kClipSpeeds - 1));
+    const int s0 = std::min(static_cast<int>(sp), kClipSpeeds - 2);
+    const float ts = sp - static_cast<float>(s0);
+
+    const int sideIndex = side < 0 ? 0 : 1;
+    const Sample *lo = &samples[(static_cast<size_t>(s0) * 2 + sideIndex) * kClipPhaseBins];
+    const Sample *hi = lo + 2 * kClipPhaseBins;
+    const Sample &a = lo[b0], &b = lo[b1], &c = hi[b0], &d = hi[b1];
+    const float w00 = (1.f - tp) * (1.f - ts), w10 = tp * (1.f - ts), w01 = (1.f - tp) * ts, w11 = tp * ts;
+
+    Angles out;
+    const float yc = w00 * a.yawC + w10 * b.yawC + w01 * c.yawC + w11 * d.yawC;
+    const float ys = w00 * a.yawS + w10 * b.yawS + w01 * c.yawS + w11 * d.yawS;
+    out.yaw = math::Rot2::fromVector(yc, ys);
+    const float deq = 1.f / kAngleQuant;
+    out.hipPitch = (w00 * a.hipPitch + w10 * b.hipPitch + w01 * c.hipPitch + w11 * d.hipPitch) * deq;
+    out.knee = (w00 * a.knee + w10 * b.knee + w01 * c.knee + w11 * d.knee) * deq;
+    out.ankle = (w00 * a.ankle + w10 * b.ankle + w01 * c.ankle + w11 * d.ankle) * deq;
+    return out;
+}
+
+static std::vector<std::unique_ptr<GaitClip>> s_clips;
+
+const GaitClip &clipFor(float hipLength, float kneeLength, float footLength) {
+    for (const auto &c : s_clips) {
+        if (c->matches(hipLength, kneeLength, footLength)) return *c;
+    }
+    s_clips.push_back(std::make_unique<GaitClip>(hipLength, kneeLength, footLength));
+    return *s_clips.back();
+}
+
+template <typename PhaseFn>
+static void playClipsWith(std::vector<Segment> &segments, float speed, float blend, PhaseFn phaseOf) {
+    const gait::Heading heading{segments.empty() ? 1.f : segments[0].heading.c, segments.empty() ? 0.f : segments[0].heading.s};
+    const float stanceEnd = gait::kStanceFrac * kTwoPi;
+    const GaitClip *clip = nullptr;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const gait::SegmentFrame frame = gait::computeSegmentFrame(segments, i, heading);
+        for (auto &leg : segments[i].legs) {
+            if (!clip || !clip->matches(leg.hipLength, leg.kneeLength, leg.footLength)) {
+                clip = &clipFor(leg.hipLength, leg.kneeLength, leg.footLength);
+            }
+            const float phase = phaseOf(i, leg);
+            const GaitClip::Angles a = clip->sample(leg.side, phase, speed);
+            const float side = static_cast<float>(leg.side);
+            const math::Rot2 outward{frame.perpX * side, frame.perpY * side};
+            leg.targetHipYaw = outward * a.yaw;
+            leg.targetKneeAngle = a.hipPitch;
+            leg.targetFootAngle = a.knee;
+            leg.targetAnkleAngle = a.ankle;
+            if (blend >= 1.f) {
+                leg.hipYaw = leg.targetHipYaw;
+                leg.kneeAngle = a.hipPitch;
+                leg.footAngle = a.knee;
+                leg.ankleAngle = a.ankle;
+            } else {
+                leg.hipYaw = math::nlerp(leg.hipYaw, leg.targetHipYaw, blend);
+                leg.kneeAngle += (a.hipPitch - leg.kneeAngle) * blend;
+                leg.footAngle += (a.knee - leg.footAngle) * blend;
+                leg.ankleAngle += (a.ankle - leg.ankleAngle) * blend;
+            }
+            leg.onGround = phase < stanceEnd;
+            // Force a real solve when the leg goes back to the full path.
+            leg.ikConverged = false;
+        }
+    }
+}
+
+void playClips(std::vector<Segment> &segments, float gaitTime, float speed, float blend) {
+    playClipsWith(segments, speed, blend, [gaitTime](size_t, const Segment::Leg &leg) {
+        // gaitTime and offsets are non-negative, so truncation wraps like legPhase's fmod.
+        const float t = gaitTime + leg.phaseOffset;
+        return t - kTwoPi * static_cast<float>(static_cast<int64_t>(t * (1.f / kTwoPi)));
+    });
+}
+
+void playClips(std::vector<Segment> &segments, const gait::CpgNetwork &cpg, uint32_t body, float speed, float blend) {
+    playClipsWith(segments, speed, blend, [&cpg, body](size_t i, const Segment::Leg &leg) {
+        return cpg.phase(body, i, leg.side);
+    });
+}
+
+} // namespace anim
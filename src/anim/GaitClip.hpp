@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../math/Rot2.hpp"
+
+// Included from include/Centipede.hpp, so only forward declarations here.
+struct Segment;
+namespace gait { class CpgNetwork; }
+
+namespace anim {
+
+// Phase samples per cycle and the speeds a clip set is baked at (uniform steps from 0,
+// so playback finds its speed pair without a search).
+inline constexpr int kClipPhaseBins = 64;
+inline constexpr int kClipSpeeds = 5;
+inline constexpr float kClipSpeedStep = 0.15f;  // head speed, grid units per tick
+// Body height the clips are baked at (the sim's rest height).
+inline constexpr float kClipBodyZ = 0.6f;
+
+// Joint angles of one leg over a gait cycle, baked from the full gait + IK path and
+// quantized to 16 bits (about 1e-4 rad). Yaw is stored as a unit direction relative to
+// the leg's outward direction, so a clip plays back on any heading without trig.
+class GaitClip {
+private:
+    struct Sample {
+        int16_t yawC, yawS;
+        int16_t hipPitch, knee, ankle;
+    };
+
+    float L1, L2, L3;
+    float z;
+    // samples[(speed * 2 + sideIndex) * kClipPhaseBins + bin]; sideIndex 0 = left.
+    std::vector<Sample> samples;
+
+    void bakeSpeed(int speedIndex);
+
+public:
+    // Bake for legs with the given link lengths (hip, knee, foot) at body height `bodyZ`.
+    GaitClip(float hipLength, float kneeLength, float footLength, float bodyZ = kClipBodyZ);
+
+    struct Angles {
+        math::Rot2 yaw;  // relative to the outward direction
+        float hipPitch, knee, ankle;
+    };
+
+    // Interpolated angles at `phase` (radians, any range) and head `speed`; O(1).
+    Angles sample(int side, float phase, float speed) const;
+
+    float bodyZ() const { return z; }
+    bool matches(float hipLength, float kneeLength, float footLength) const {
+        return L1 == hipLength && L2 == kneeLength && L3 == footLength;
+    }
+    size_t byteSize() const { return samples.size() * sizeof(Sample); }
+};
+
+// Shared clip for a leg morphology, baked on first use.
+const GaitClip &clipFor(float hipLength, float kneeLength, float footLength);
+
+// How a centipede animates its legs: full gait + IK per leg, or clip playback.
+enum class LegAnimation { Full, Baked };
+
+// Pose every leg from its clip instead of running gait + IK: the phase is
+// `gaitTime + phaseOffset` (or the leg's CPG oscillator), the speed the head speed.
+// Sets the joint angles (and targets) and `onGround`; foot holds are left untouched.
+// `blend` < 1 moves the angles only that fraction of the way toward the clip (used to
+// ease in after switching from the full path, whose pose can be far from the clip's).
+void playClips(std::vector<Segment> &segments, float gaitTime, float speed, float blend = 1.f);
+void playClips(std::vector<Segment> &segments, const gait::CpgNetwork &cpg, uint32_t body, float speed, float blend = 1.f);
+
+} // namespace anim
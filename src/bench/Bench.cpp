@@ -0,0 +1,1482 @@
+#include "Bench.hpp"
+#include "../../include/Centipede.hpp"
+#include "../ik/LegIK.hpp"
+#include "../ik/IKTable.hpp"
+#include "../ik/ChainIK.hpp"
+#include "../math/FastMath.hpp"
+#include "../gait/GaitController.hpp"
+#include "../gait/Cpg.hpp"
+#include "../anim/GaitClip.hpp"
+#include "../morph/Kernels.hpp"
+#include "../morph/BodyMask.hpp"
+#include "../physics/Occupancy.hpp"
+#include "../lod/SimLod.hpp"
+#include "../terrain/Heightfield.hpp"
+#include "../world/World.hpp"
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Tabulated vs closed-form planar IK for the default leg morphology.
+static bool benchIKTable() {
+    // Default leg: 3/2/1 proportions of a 5.5 unit leg (see Centipede constructor).
+    const float unit = 5.5f / 6.0f;
+    const float L1 = 3.0f * unit;
+    const float L2 = 2.0f * unit + 1.0f * unit;
+
+    std::printf("[ik-table] L1=%.3f L2=%.3f bound=%.4f rad\n", L1, L2, ik::kDefaultTableErrorBound);
+    auto t0 = Clock::now();
+    ik::IKTable table(L1, L2, ik::kDefaultTableErrorBound);
+    std::printf("  build: %.2f ms, cell=%.4f, entries=%zu, fallback cells=%zu, worst probed err=%.5f rad\n",
+                msSince(t0), table.cellSize(), table.entryCount(), table.fallbackCellCount(), table.maxProbedError());
+
+    ik::TableAccuracy acc = table.measureAccuracy(512);
+    std::printf("  accuracy (%d samples, %d via fallback): hipPitch max=%.5f mean=%.6f, knee max=%.5f mean=%.6f\n",
+                acc.samples, acc.fallbackSamples, acc.maxHipPitchErr, acc.meanHipPitchErr, acc.maxKneeErr, acc.meanKneeErr);
+
+    // Queries drawn from the range the sim actually produces (body height 0.15..2).
+    const size_t n = size_t(1) << 20;
+    std::vector<float> rs(n), dzs(n);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> rDist(0.0f, L1 + L2);
+    std::uniform_real_distribution<float> zDist(-2.0f, -0.15f);
+    for (size_t i = 0; i < n; ++i) { rs[i] = rDist(rng); dzs[i] = zDist(rng); }
+
+    float sink = 0.f;
+    t0 = Clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        float p, k;
+        ik::solvePlanar(L1, L2, ik::clampReachR(L1, L2, rs[i], dzs[i]), dzs[i], p, k);
+        sink += p + k;
+    }
+    double analyticMs = msSince(t0);
+
+    t0 = Clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        float p = 0.f, k = 0.f;
+        table.lookup(ik::clampReachR(L1, L2, rs[i], dzs[i]), dzs[i], p, k);
+        sink += p + k;
+    }
+    double tableMs = msSince(t0);
+
+    std::printf("  analytic: %.2f ns/solve, table: %.2f ns/solve, speedup %.2fx (sink %.1f)\n",
+                analyticMs * 1e6 / n, tableMs * 1e6 / n, analyticMs / tableMs, sink);
+
+    // The shared table survives a bound change (rebuilt in place), and tables stay off
+    // unless enabled.
+    const bool wasEnabled = ik::tabulatedIKEnabled();
+    const ik::IKTable &shared = ik::tableFor(L1, L2);
+    ik::setTabulatedIK(wasEnabled, 2.f * ik::kDefaultTableErrorBound);
+    const bool rebuilt = shared.errorBound() == 2.f * ik::kDefaultTableErrorBound && shared.link1() == L1;
+    ik::setTabulatedIK(wasEnabled);
+    const bool kept = rebuilt && &shared == &ik::tableFor(L1, L2) && shared.errorBound() == ik::kDefaultTableErrorBound;
+
+    // The bound holds off the probe points too: sample a denser off-grid pattern as well.
+    const ik::TableAccuracy dense = table.measureAccuracy(1536);
+    std::printf("  dense accuracy (%d samples): hipPitch max=%.5f, knee max=%.5f\n",
+                dense.samples, dense.maxHipPitchErr, dense.maxKneeErr);
+    const float bound = ik::kDefaultTableErrorBound;
+    bool ok = acc.maxHipPitchErr <= bound && acc.maxKneeErr <= bound && dense.maxHipPitchErr <= bound
+              && dense.maxKneeErr <= bound && !wasEnabled && kept;
+    if (!ok) std::printf("  FAIL: off-grid error exceeds the configured bound, tables are on by default, or a bound change dropped the shared table\n");
+    return ok;
+}
+
+// Scripted input shared by the sim benchmarks: walk a slow circle, then idle.
+static void scriptedStep(Centipede &c, int frame) {
+    if (frame % 600 < 400) {
+        const float t = static_cast<float>(frame) * 0.01f;
+        c.tryMove(std::cos(t) * 1.4f, std::sin(t) * 1.4f);
+    }
+    c.update();
+}
+
+// Iteration statistics of the n-link chain solver over a scripted walk.
+static bool benchChainIK() {
+    const int frames = 3000;
+    ik::setLegSolver(ik::LegSolver::Chain);
+    Centipede c(40, 10, 14);
+    ik::ChainStats total;
+    auto t0 = Clock::now();
+    for (int f = 0; f < frames; ++f) {
+        scriptedStep(c, f);
+        const ik::ChainStats &s = ik::chainStats();
+        total.solves += s.solves;
+        total.iterations += s.iterations;
+        total.reached += s.reached;
+        total.settled += s.settled;
+        total.hitCap += s.hitCap;
+        total.maxIterations = std::max(total.maxIterations, s.maxIterations);
+    }
+    double ms = msSince(t0);
+    ik::setLegSolver(ik::LegSolver::Analytic);
+
+    std::printf("[ik-chain] %d frames, %zu solves: mean %.2f iterations, max %d; reached %zu, settled at limits %zu, hit cap %zu\n",
+                frames, total.solves, total.meanIterations(), total.maxIterations,
+                total.reached, total.settled, total.hitCap);
+    std::printf("  sim: %.3f ms/frame\n", ms / frames);
+
+    // The re-targeted warm start should leave most solves at one sweep or none; only
+    // targets crawling along a joint limit may run into the cap.
+    bool ok = true;
+    if (total.meanIterations() > 2.f) {
+        std::printf("  FAIL: mean %.2f iterations per solve (> 2)\n", total.meanIterations());
+        ok = false;
+    }
+    if (total.hitCap * 50 > total.solves) {
+        std::printf("  FAIL: %zu of %zu solves hit the iteration cap (> 2%%)\n", total.hitCap, total.solves);
+        ok = false;
+    }
+    return ok;
+}
+
+// Approximation error against double-precision libm over each function's documented
+// domain, then scalar / SIMD throughput against the float libm calls.
+static bool benchFastMath() {
+    const size_t n = size_t(1) << 20;
+    std::vector<float> xs(n), ys(n), us(n), out(n);
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> wide(-1e4f, 1e4f), angle(-7.f, 7.f), unit(-1.f, 1.f), pos(0.f, 1e6f);
+    float maxSin = 0.f, maxCos = 0.f, maxAtan2 = 0.f, maxAcos = 0.f, maxSqrtRel = 0.f;
+    for (size_t i = 0; i < n; ++i) {
+        const float x = (i & 1) ? wide(rng) : angle(rng);
+        const float y = unit(rng) * 100.f, u = unit(rng), p = pos(rng);
+        xs[i] = x; ys[i] = y; us[i] = u;
+        maxSin = std::max(maxSin, static_cast<float>(std::fabs(fastmath::approx::sin(x) - std::sin(static_cast<double>(x)))));
+        maxCos = std::max(maxCos, static_cast<float>(std::fabs(fastmath::approx::cos(x) - std::cos(static_cast<double>(x)))));
+        maxAtan2 = std::max(maxAtan2, static_cast<float>(std::fabs(fastmath::approx::atan2(y, u) - std::atan2(static_cast<double>(y), static_cast<double>(u)))));
+        maxAcos = std::max(maxAcos, static_cast<float>(std::fabs(fastmath::approx::acos(u) - std::acos(static_cast<double>(u)))));
+        const double sq = std::sqrt(static_cast<double>(p));
+        if (sq > 0.0) maxSqrtRel = std::max(maxSqrtRel, static_cast<float>(std::fabs(fastmath::approx::sqrt(p) - sq) / sq));
+    }
+    // Denormals (and the smallest normals) up to 2 * FLT_MIN: finite, within sqrt(FLT_MIN)
+    // absolute, scalar and SIMD alike.
+    std::vector<float> tiny;
+    for (float t = std::numeric_limits<float>::denorm_min(); t <= 2.f * FLT_MIN; t *= 1.5f) tiny.push_back(t);
+    tiny.push_back(FLT_MIN);
+    tiny.push_back(std::nextafter(FLT_MIN, 0.f));
+    while (tiny.size() % 4) tiny.push_back(0.f);
+    std::vector<float> tinyOut(tiny.size());
+    fastmath::approx::sqrtN(tiny.data(), tinyOut.data(), tiny.size());
+    float maxSqrtTiny = 0.f;
+    for (size_t i = 0; i < tiny.size(); ++i) {
+        const float s = fastmath::approx::sqrt(tiny[i]);
+        const float err = static_cast<float>(std::fabs(s - std::sqrt(static_cast<double>(tiny[i]))));
+        const float laneErr = static_cast<float>(std::fabs(tinyOut[i] - std::sqrt(static_cast<double>(tiny[i]))));
+        maxSqrtTiny = std::max({maxSqrtTiny, std::isfinite(s) ? err : INFINITY, std::isfinite(tinyOut[i]) ? laneErr : INFINITY});
+    }
+    std::printf("[fastmath] max err: sin %.2e, cos %.2e, atan2 %.2e, acos %.2e, sqrt (rel) %.2e, sqrt below 2 * FLT_MIN (abs) %.2e\n",
+                maxSin, maxCos, maxAtan2, maxAcos, maxSqrtRel, maxSqrtTiny);
+    // Bounds documented in FastMath.hpp.
+    bool ok = maxSin <= 5e-7f && maxCos <= 5e-7f && maxAtan2 <= 5e-7f && maxAcos <= 5e-7f && maxSqrtRel <= 2e-7f
+              && maxSqrtTiny <= 1.1e-19f;
+
+    // SIMD lanes run the same polynomials; they must agree with the scalar forms.
+    fastmath::approx::sinN(xs.data(), out.data(), n);
+    float laneDiff = 0.f;
+    for (size_t i = 0; i < n; ++i) laneDiff = std::max(laneDiff, std::fabs(out[i] - fastmath::approx::sin(xs[i])));
+    fastmath::approx::cosN(xs.data(), out.data(), n);
+    for (size_t i = 0; i < n; ++i) laneDiff = std::max(laneDiff, std::fabs(out[i] - fastmath::approx::cos(xs[i])));
+    fastmath::approx::atan2N(ys.data(), us.data(), out.data(), n);
+    for (size_t i = 0; i < n; ++i) laneDiff = std::max(laneDiff, std::fabs(out[i] - fastmath::approx::atan2(ys[i], us[i])));
+    fastmath::approx::sqrtN(ys.data(), out.data(), n);
+    for (size_t i = 0; i < n; ++i) laneDiff = std::max(laneDiff, std::fabs(out[i] - fastmath::approx::sqrt(ys[i])));
+    std::printf("  simd vs scalar max diff: %.2e\n", laneDiff);
+    ok = ok && laneDiff <= 1e-6f;
+
+    float sink = 0.f;
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < n; ++i) sink += std::sin(xs[i]) + std::atan2(ys[i], us[i]);
+    double libmMs = msSince(t0);
+    t0 = Clock::now();
+    for (size_t i = 0; i < n; ++i) sink += fastmath::approx::sin(xs[i]) + fastmath::approx::atan2(ys[i], us[i]);
+    double scalarMs = msSince(t0);
+    t0 = Clock::now();
+    fastmath::approx::sinN(xs.data(), out.data(), n);
+    sink += out[n / 2];
+    fastmath::approx::atan2N(ys.data(), us.data(), out.data(), n);
+    sink += out[n / 3];
+    double simdMs = msSince(t0);
+    std::printf("  sin+atan2: libm %.2f ns, scalar %.2f ns, simd %.2f ns per pair (sink %.1f)\n",
+                libmMs * 1e6 / n, scalarMs * 1e6 / n, simdMs * 1e6 / n, sink);
+    if (!ok) std::printf("  FAIL: approximation error exceeds the documented bound\n");
+    return ok;
+}
+
+// Ticks until a CPG body's phases are back within `eps` of its pattern (or `limit`).
+static int ticksToSettle(gait::CpgNetwork &net, uint32_t body, float eps, int limit) {
+    int t = 0;
+    while (t < limit && net.patternError(body) > eps) { net.step(); ++t; }
+    return t;
+}
+
+// CPG gait: crowd throughput, gait transitions and recovery after shoves.
+static bool benchCpg() {
+    bool ok = true;
+
+    // Crowd: thousands of 14-segment bodies with varied drives, one network step per tick.
+    const size_t crowd = 4000;
+    gait::CpgNetwork net;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> driveDist(0.015f, 3.0f), speedDist(0.f, 0.6f);
+    for (size_t b = 0; b < crowd; ++b) {
+        const uint32_t id = net.addBody(14);
+        net.setDrive(id, driveDist(rng), speedDist(rng));
+    }
+    const int ticks = 500;
+    for (int t = 0; t < 50; ++t) net.step();  // warm the arrays; steady-state rate below
+    auto t0 = Clock::now();
+    for (int t = 0; t < ticks; ++t) net.step();
+    double ms = msSince(t0);
+    const double updates = static_cast<double>(net.oscillatorCount()) * ticks;
+    const double rate = updates / ms * 1e-6;
+    std::printf("[cpg] crowd of %zu bodies (%zu oscillators): %.3f ms/tick, %.2f M oscillator updates/ms\n",
+                crowd, net.oscillatorCount(), ms / ticks, rate);
+    if (rate < 1.0) {
+        std::printf("  FAIL: below 1 M oscillator updates/ms\n");
+        ok = false;
+    }
+
+    // Transitions: ramp one body's speed up into the gallop and back down to the wave.
+    gait::CpgNetwork single;
+    const uint32_t body = single.addBody(14);
+    single.setDrive(body, 0.3f, 0.6f);
+    single.step();
+    const bool toGallop = single.galloping(body);
+    const int gallopTicks = ticksToSettle(single, body, 0.05f, 2000);
+    single.setDrive(body, 0.1f, 0.1f);
+    single.step();
+    const bool toWave = !single.galloping(body);
+    const int waveTicks = ticksToSettle(single, body, 0.05f, 2000);
+    std::printf("  transitions: wave->gallop %s, settled in %d ticks; gallop->wave %s, settled in %d ticks\n",
+                toGallop ? "ok" : "MISSING", gallopTicks, toWave ? "ok" : "MISSING", waveTicks);
+    ok = ok && toGallop && toWave && gallopTicks < 2000 && waveTicks < 2000;
+
+    // Recovery: shove random segments by up to +-1.5 rad and wait for the pattern to return.
+    std::uniform_real_distribution<float> kick(-1.5f, 1.5f);
+    std::uniform_int_distribution<int> segDist(0, 13);
+    int worstRecovery = 0;
+    for (int trial = 0; trial < 50; ++trial) {
+        for (int k = 0; k < 3; ++k) single.perturb(body, static_cast<size_t>(segDist(rng)), kick(rng));
+        worstRecovery = std::max(worstRecovery, ticksToSettle(single, body, 0.05f, 2000));
+    }
+    std::printf("  perturbation recovery: worst %d ticks over 50 shoves\n", worstRecovery);
+    ok = ok && worstRecovery < 2000;
+
+    // Full sim on the CPG gait (the centipede pushes through its own body on turns).
+    Centipede c(40, 10, 14);
+    gait::CpgNetwork simNet;
+    c.attachCpg(&simNet);
+    t0 = Clock::now();
+    for (int f = 0; f < 3000; ++f) {
+        simNet.step();
+        scriptedStep(c, f);
+    }
+    std::printf("  sim on cpg gait: %.3f ms/frame\n", msSince(t0) / 3000);
+    c.attachCpg(nullptr);
+
+    if (!ok) std::printf("  FAIL: cpg gait did not transition or recover\n");
+    return ok;
+}
+
+// Baked gait clips: bake cost, playback error against the full path at a speed between
+// two baked ones, and per-leg cost of playback vs. full gait + IK for a crowd.
+static bool benchGaitClips() {
+    const Segment::Leg &leg0 = Centipede(0, 0, 1).getSegments()[0].legs[0];
+    auto t0 = Clock::now();
+    const anim::GaitClip &clip = anim::clipFor(leg0.hipLength, leg0.kneeLength, leg0.footLength);
+    std::printf("[clips] bake: %.2f ms, %zu bytes (%d speeds x %d phase bins x 2 sides)\n",
+                msSince(t0), clip.byteSize(), anim::kClipSpeeds, anim::kClipPhaseBins);
+
+    // A bake with terrain active gives the same clip (baked on the flat plane) and leaves
+    // the terrain active.
+    terrain::Heightfield hills;
+    terrain::setActive(&hills);
+    hills.resetStats();
+    const anim::GaitClip onHills(leg0.hipLength, leg0.kneeLength, leg0.footLength);
+    bool flatBake = terrain::active() == &hills && hills.sampleStats().queries == 0;
+    terrain::setActive(nullptr);
+    for (int k = 0; k < 256; ++k) {
+        const float phase = static_cast<float>(k) * 0.1f, sp = static_cast<float>(k % 7) * 0.1f;
+        const anim::GaitClip::Angles a = clip.sample(k & 1 ? 1 : -1, phase, sp), b = onHills.sample(k & 1 ? 1 : -1, phase, sp);
+        flatBake = flatBake && a.hipPitch == b.hipPitch && a.knee == b.knee && a.ankle == b.ankle && a.yaw.c == b.yaw.c && a.yaw.s == b.yaw.s;
+    }
+
+    // Straight walk at a speed between bake points: full path vs. clip, on a mid-body segment.
+    const float speed = 0.22f;
+    std::vector<Segment> full = Centipede(0, 0, 6).getSegments();
+    for (auto &seg : full) seg.bodyZ = anim::kClipBodyZ;
+    const morph::IkPassKernel ikPass = morph::ikPassKernelFor<3, 1>();
+    float gaitTime = 0.f, maxErr = 0.f, sumErr = 0.f;
+    int samples = 0;
+    for (int tick = 0; tick < 3000; ++tick) {
+        for (auto &seg : full) seg.x += speed;
+        gaitTime += kIdleGaitAdvance + speed * kGaitPerUnit;
+        gait::updateGait(full, gaitTime, speed, 0.f);
+        morph::IkPassCounters counters;
+        ikPass(full, counters);
+        if (tick < 500) continue;
+        for (const auto &L : full[2].legs) {
+            const anim::GaitClip::Angles a = clip.sample(L.side, gait::legPhase(gaitTime, L.phaseOffset), speed);
+            const float err = std::max(std::fabs(a.hipPitch - L.kneeAngle), std::fabs(a.knee - L.footAngle));
+            maxErr = std::max(maxErr, err);
+            sumErr += err;
+            samples++;
+        }
+    }
+    std::printf("  playback vs full at speed %.2f: pitch/knee max err %.3f rad, mean %.4f rad; baked on the flat "
+                "plane with terrain active: %s\n", speed, maxErr, sumErr / static_cast<float>(samples), flatBake ? "yes" : "no");
+
+    // Crowd: many bodies animated by each path (spine motion only, no sim).
+    const int bodies = 1000, ticks = 100;
+    std::vector<std::vector<Segment>> crowd(bodies, Centipede(0, 0, 14).getSegments());
+    for (auto &b : crowd) for (auto &seg : b) seg.bodyZ = anim::kClipBodyZ;
+    size_t legs = 0;
+    for (const auto &b : crowd) for (const auto &seg : b) legs += seg.legs.size();
+    auto runCrowd = [&](bool baked) {
+        float time = 0.f;
+        auto start = Clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            time += kIdleGaitAdvance + speed * kGaitPerUnit;
+            for (auto &b : crowd) {
+                for (auto &seg : b) seg.x += speed;
+                if (baked) {
+                    anim::playClips(b, time, speed);
+                } else {
+                    gait::updateGait(b, time, speed, 0.f);
+                    morph::IkPassCounters counters;
+                    ikPass(b, counters);
+                }
+            }
+        }
+        return msSince(start) * 1e6 / (static_cast<double>(legs) * ticks);
+    };
+    const double fullNs = runCrowd(false);
+    const double bakedNs = runCrowd(true);
+    std::printf("  %d bodies: full %.1f ns/leg, baked %.1f ns/leg (%.1fx); baked budget: %.0f agents/ms\n",
+                bodies, fullNs, bakedNs, fullNs / bakedNs, 1e6 / (bakedNs * 28.0));
+
+    // Quantized clips should track the full path closely except at touchdown, where the
+    // full path's smoothing lags the phase-locked clip.
+    const bool ok = sumErr / static_cast<float>(samples) < 0.06f && flatBake;
+    if (!ok) std::printf("  FAIL: baked clips drift from the full gait, or depend on the active terrain\n");
+    return ok;
+}
+
+// Largest per-tick foot movement between two poses of the same body.
+static float maxFootStep(const pose::PoseBuffer &a, const pose::PoseBuffer &b) {
+    float worst = 0.f;
+    const auto &ax = a.x[pose::Foot], &ay = a.y[pose::Foot], &bx = b.x[pose::Foot], &by = b.y[pose::Foot];
+    for (size_t l = 0; l < ax.size() && l < bx.size(); ++l) {
+        worst = std::max(worst, std::hypot(bx[l] - ax[l], by[l] - ay[l]));
+    }
+    return worst;
+}
+
+// Simulation LOD: per-body tick cost of each tier, and how far feet jump on the tick a
+// body is promoted compared to ordinary walking.
+static bool benchSimLod() {
+    const int bodies = 64, frames = 600;
+    double tierUs[3];
+    for (lod::SimTier tier : {lod::SimTier::Full, lod::SimTier::Reduced, lod::SimTier::Ghost}) {
+        std::vector<Centipede> crowd(bodies, Centipede(40, 10, 14));
+        for (auto &c : crowd) c.setSimTier(tier);
+        auto t0 = Clock::now();
+        for (int f = 0; f < frames; ++f) {
+            for (auto &c : crowd) scriptedStep(c, f);
+        }
+        tierUs[static_cast<int>(tier)] = msSince(t0) * 1e3 / (static_cast<double>(bodies) * frames);
+    }
+    std::printf("[lod] per body-tick: full %.2f us, reduced %.2f us (%.1fx), ghost %.2f us (%.1fx)\n",
+                tierUs[0], tierUs[1], tierUs[0] / tierUs[1], tierUs[2], tierUs[0] / tierUs[2]);
+
+    // One body walking the scripted path through every tier. Promotions to Full happen on
+    // screen and must look like an ordinary tick; promotion out of Ghost happens off-screen.
+    // The tier also switches the legs between the full gait + IK and baked clips.
+    Centipede c(40, 10, 14);
+    pose::PoseBuffer last;
+    float walkStep = 0.f, fullToReduced = 0.f, reducedToFull = 0.f, ghostToReduced = 0.f, reducedToFullAfterGhost = 0.f;
+    bool animationFollows = c.getLegAnimation() == anim::LegAnimation::Full;
+    for (int f = 0; f < 1800; ++f) {
+        if (f == 1000) c.setSimTier(lod::SimTier::Reduced);
+        if (f == 1300) c.setSimTier(lod::SimTier::Full);
+        if (f == 1400) c.setSimTier(lod::SimTier::Ghost);
+        if (f == 1500) c.setSimTier(lod::SimTier::Reduced);
+        if (f == 1550) c.setSimTier(lod::SimTier::Full);
+        const bool baked = c.getLegAnimation() == anim::LegAnimation::Baked;
+        animationFollows = animationFollows && baked == lod::bakedLegs(c.getSimTier());
+        scriptedStep(c, f);
+        const float step = f > 0 ? maxFootStep(last, c.getPose()) : 0.f;
+        if (f >= 100 && f < 400) walkStep = std::max(walkStep, step);
+        if (f >= 1000 && f < 1003) fullToReduced = std::max(fullToReduced, step);
+        if (f >= 1300 && f < 1303) reducedToFull = std::max(reducedToFull, step);
+        if (f == 1500) ghostToReduced = step;
+        if (f >= 1550 && f < 1553) reducedToFullAfterGhost = std::max(reducedToFullAfterGhost, step);
+        last = c.getPose();
+    }
+    std::printf("  max foot step per tick: walking %.3f, full->reduced (baked) %.3f, reduced->full %.3f, "
+                "ghost->reduced %.3f (off-screen), then ->full %.3f; leg animation follows the tier: %s\n",
+                walkStep, fullToReduced, reducedToFull, ghostToReduced, reducedToFullAfterGhost, animationFollows ? "yes" : "no");
+
+    const bool ok = animationFollows && fullToReduced <= walkStep && reducedToFull <= walkStep && reducedToFullAfterGhost <= walkStep;
+    if (!ok) std::printf("  FAIL: the leg animation does not follow the tier, or feet pop when a body changes tier on screen\n");
+    return ok;
+}
+
+// Voxel sleeping: idle bodies whose voxels are at rest stop paying for the soft-body,
+// and a head move wakes the segments it drags along.
+static bool benchVoxelSleep() {
+    const int bodies = 64;
+    std::vector<Centipede> crowd(bodies, Centipede(40, 10, 14));
+    auto tickAll = [&](int ticks) {
+        auto t0 = Clock::now();
+        for (int t = 0; t < ticks; ++t) for (auto &c : crowd) c.update();
+        return msSince(t0) * 1e3 / (static_cast<double>(bodies) * ticks);
+    };
+    auto counts = [&](size_t &awake, size_t &asleep) {
+        awake = asleep = 0;
+        for (const auto &c : crowd) { awake += c.getAwakeSegmentCount(); asleep += c.getSleepingSegmentCount(); }
+    };
+
+    // Windows end before the idle fast path takes over a still body (which skips voxels
+    // altogether).
+    size_t awake, asleep;
+    const double awakeUs = tickAll(25);
+    counts(awake, asleep);
+    std::printf("[voxel-sleep] idle crowd of %d: first ticks %zu awake / %zu asleep segments, %.2f us per body-tick\n",
+                bodies, awake, asleep, awakeUs);
+    tickAll(7);
+    const double asleepUs = tickAll(12);
+    size_t settledAsleep;
+    counts(awake, settledAsleep);
+    std::printf("  settled: %zu awake / %zu asleep, %.2f us per body-tick (%.2fx)\n",
+                awake, settledAsleep, asleepUs, awakeUs / asleepUs);
+
+    // Walk one body a little: the segments it moved wake up, then go back to sleep once
+    // they have rung down (about kVoxelSleepTicks) and stayed still for kVoxelSleepTicks,
+    // still before the idle fast path takes over.
+    Centipede &c = crowd[0];
+    for (int t = 0; t < 6; ++t) { c.moveBy(0.4f, 0.f); c.update(); }
+    const size_t wokeAwake = c.getAwakeSegmentCount();
+    for (int t = 0; t < 70; ++t) c.update();
+    const size_t walkedAsleep = c.getSleepingSegmentCount();
+    std::printf("  after a short walk: %zu segments awake; 70 ticks later %zu awake / %zu asleep\n",
+                wokeAwake, c.getAwakeSegmentCount(), walkedAsleep);
+
+    const bool ok = settledAsleep == static_cast<size_t>(bodies) * 14 && wokeAwake > 0 && walkedAsleep * 2 >= wokeAwake;
+    if (!ok) std::printf("  FAIL: idle voxels did not sleep, a moved body stayed asleep, or its segments did not go back to sleep\n");
+    return ok;
+}
+
+// 16.16 voxel coordinates: the cell mapping (floor(v + 0.5) on floats vs. a shift) and
+// the settle spring step, over a large voxel set in both representations; the fixed-point
+// cells must match the float ones for positions that convert exactly.
+static bool benchFixedVoxels() {
+    const size_t n = 1 << 16;
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> pos(-300.f, 300.f);
+    std::vector<float> fx(n), fy(n), fvx(n, 0.f), fvy(n, 0.f), tx(n), ty(n);
+    std::vector<math::Fixed> qx(n), qy(n), qvx(n, 0), qvy(n, 0), qtx(n), qty(n);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; ++i) {
+        // Positions on the 1/65536 grid, so both representations hold the same value.
+        qx[i] = math::toFixed(pos(rng)); qy[i] = math::toFixed(pos(rng));
+        fx[i] = math::toFloat(qx[i]); fy[i] = math::toFloat(qy[i]);
+        tx[i] = fx[i] + 0.3f; ty[i] = fy[i] - 0.2f;
+        qtx[i] = math::toFixed(tx[i]); qty[i] = math::toFixed(ty[i]);
+        if (math::fixedCell(qx[i]) != static_cast<int>(std::floor(fx[i] + 0.5f))) mismatches++;
+    }
+    const int reps = 50;
+    uint64_t sink = 0;
+    auto t0 = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (size_t i = 0; i < n; ++i) sink += static_cast<uint32_t>(static_cast<int>(std::floor(fx[i] + 0.5f)) ^ static_cast<int>(std::floor(fy[i] + 0.5f)));
+    }
+    const double floatCellNs = msSince(t0) * 1e6 / (static_cast<double>(n) * reps);
+    t0 = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (size_t i = 0; i < n; ++i) sink += static_cast<uint32_t>(math::fixedCell(qx[i]) ^ math::fixedCell(qy[i]));
+    }
+    const double fixedCellNs = msSince(t0) * 1e6 / (static_cast<double>(n) * reps);
+    t0 = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (size_t i = 0; i < n; ++i) {
+            fvx[i] = (fvx[i] + (tx[i] - fx[i]) * 0.16f) * 0.85f; fvy[i] = (fvy[i] + (ty[i] - fy[i]) * 0.16f) * 0.85f;
+            fx[i] += fvx[i]; fy[i] += fvy[i];
+        }
+    }
+    const double floatStepNs = msSince(t0) * 1e6 / (static_cast<double>(n) * reps);
+    constexpr math::Factor pull = math::toFactor(0.16f), damping = math::toFactor(0.85f);
+    t0 = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (size_t i = 0; i < n; ++i) {
+            qvx[i] = math::fixedScale(qvx[i] + math::fixedScale(qtx[i] - qx[i], pull), damping);
+            qvy[i] = math::fixedScale(qvy[i] + math::fixedScale(qty[i] - qy[i], pull), damping);
+            qx[i] += qvx[i]; qy[i] += qvy[i];
+        }
+    }
+    const double fixedStepNs = msSince(t0) * 1e6 / (static_cast<double>(n) * reps);
+    // Both settle on the target (the fixed-point run to within its rounding).
+    float settleErr = 0.f;
+    for (size_t i = 0; i < n; ++i) settleErr = std::max(settleErr, std::fabs(math::toFloat(qx[i]) - fx[i]));
+    // Scaling is symmetric in sign, so damping alone brings either direction to rest.
+    bool symmetric = true;
+    for (math::Fixed v = 1; v < 4 * math::kFixedOne; v = v * 3 + 1) {
+        symmetric = symmetric && math::fixedScale(-v, damping) == -math::fixedScale(v, damping);
+        math::Fixed up = v, down = -v;
+        for (int s = 0; s < 200; ++s) { up = math::fixedScale(up, damping); down = math::fixedScale(down, damping); }
+        symmetric = symmetric && up == 0 && down == 0;
+    }
+    std::printf("[fixed] %zu voxels: cell %.2f ns float floor, %.2f ns fixed shift (%zu mismatches); "
+                "spring step %.2f ns float, %.2f ns fixed; settled apart max %.1e; damping symmetric: %s (sink %llu)\n",
+                n, floatCellNs, fixedCellNs, mismatches, floatStepNs, fixedStepNs, settleErr, symmetric ? "yes" : "no",
+                static_cast<unsigned long long>(sink & 0xff));
+    const bool ok = mismatches == 0 && settleErr < 1e-3f && symmetric;
+    if (!ok) std::printf("  FAIL: fixed-point cells differ from the float mapping, or the spring does not settle symmetrically\n");
+    return ok;
+}
+
+// Rotated body masks: heading 0 reproduces the silhouette, segments store its filled cells
+// only, every heading keeps about its cell count, a lookup by heading is cheap next to rotating the cells, and a body with a
+// non-default silhouette walks.
+static bool benchBodyMask() {
+    const morph::Silhouette shapes[] = {morph::Silhouette::diamond(3), morph::Silhouette::ellipse(9, 5), morph::Silhouette::diamond(31)};
+    bool exact = true, counts = true;
+    for (const morph::Silhouette &shape : shapes) {
+        const morph::BodyMask &mask = morph::maskFor(shape);
+        exact = exact && &mask == &morph::maskFor(shape);
+        size_t filled = 0, lo = SIZE_MAX, hi = 0;
+        for (uint8_t cell : shape.cells) filled += cell ? 1 : 0;
+        const morph::RotatedMask &rest = mask.at(0);
+        for (int y = 0; y < shape.height; ++y) {
+            for (int x = 0; x < shape.width; ++x) {
+                const int r = y - rest.minY, b = x - rest.minX;
+                const bool bit = r >= 0 && r < static_cast<int>(rest.rows.size()) && b >= 0 && ((rest.rows[static_cast<size_t>(r)] >> b) & 1);
+                exact = exact && bit == shape.filled(x, y);
+            }
+        }
+        for (int k = 0; k < mask.headingCount(); ++k) {
+            lo = std::min(lo, mask.at(k).cellCount);
+            hi = std::max(hi, mask.at(k).cellCount);
+        }
+        // Rasterizing a rotated shape can merge or split a few cells at its rim.
+        counts = counts && lo * 4 >= filled * 3 && hi * 3 <= filled * 4;
+        // Segments store the filled cells only.
+        const Centipede body(40, 10, 2, shape);
+        const size_t stored = body.getSegments()[0].voxels.size();
+        exact = exact && stored == filled && mask.voxelCount() == filled && mask.at(0).offX.size() == filled;
+        std::printf("[mask] %dx%d silhouette, %zu cells: %d headings hold %zu..%zu cells; %zu voxel bytes per "
+                    "segment (%zu for the full box)\n",
+                    shape.width, shape.height, filled, mask.headingCount(), lo, hi, stored * sizeof(Voxel),
+                    shape.cells.size() * sizeof(Voxel));
+    }
+
+    const morph::BodyMask &mask = morph::maskFor(shapes[1]);
+    const int n = 1 << 14, reps = 50;
+    std::vector<math::Rot2> headings(n);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    for (auto &h : headings) h = math::Rot2::fromAngle(angle(rng));
+    const size_t cells = shapes[1].cells.size();
+    float sink = 0.f;
+    auto t0 = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (const auto &h : headings) {
+            for (size_t i = 0; i < cells; ++i) {
+                const float dx = static_cast<float>(i % 9) - 4.f, dy = static_cast<float>(i / 9) - 2.f;
+                sink += h.c * dx - h.s * dy + h.s * dx + h.c * dy;
+            }
+        }
+    }
+    const double rotateNs = msSince(t0) * 1e6 / (static_cast<double>(n) * reps);
+    t0 = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        for (const auto &h : headings) sink += static_cast<float>(mask.forHeading(h).offX[static_cast<size_t>(r) % cells]);
+    }
+    const double lookupNs = msSince(t0) * 1e6 / (static_cast<double>(n) * reps);
+
+    Centipede c(40, 10, 14, shapes[1]);
+    bool finite = true;
+    for (int f = 0; f < 1200; ++f) {
+        scriptedStep(c, f);
+        for (const auto &seg : c.getSegments()) finite = finite && std::isfinite(seg.x) && std::isfinite(seg.y);
+    }
+    const float walked = std::hypot(c.getSegments()[0].x - 40.f, c.getSegments()[0].y - 10.f);
+    std::printf("  per segment-tick: rotate %zu cells %.1f ns, mask lookup %.1f ns; 9x5 ellipse body walked %.1f "
+                "(sink %.0f)\n", cells, rotateNs, lookupNs, walked, std::fmod(static_cast<double>(sink), 256.0));
+    const bool ok = exact && counts && finite && walked > 1.f;
+    if (!ok) std::printf("  FAIL: heading 0 or the stored voxels differ from the silhouette, a rotation lost cells, or the ellipse body did not walk\n");
+    return ok;
+}
+
+// Hierarchical occupancy at 3x3, 16x16 and 32x32 voxels per segment: the cost of a
+// walking body-tick, and of filling / querying the voxel occupancy and of the follower
+// overlap test against the per-voxel hash and the all-pairs scan they replaced (which
+// must find the same overlaps).
+static bool benchOccupancy() {
+    const morph::Silhouette shapes[] = {morph::Silhouette::diamond(3), morph::Silhouette::ellipse(16, 16), morph::Silhouette::ellipse(32, 32)};
+    bool ok = true;
+    for (const morph::Silhouette &shape : shapes) {
+        Centipede c(40, 10, 14, shape);
+        const int frames = 200;
+        auto t0 = Clock::now();
+        for (int f = 0; f < frames; ++f) scriptedStep(c, f);
+        const double tickUs = msSince(t0) * 1e3 / frames;
+        const auto &segs = c.getSegments();
+        size_t voxels = 0;
+        for (const auto &seg : segs) voxels += seg.voxels.size();
+        bool finite = true;
+        for (const auto &seg : segs) finite = finite && std::isfinite(seg.x) && std::isfinite(seg.y);
+
+        // Fill and query every voxel's cell: a hash entry per voxel vs. tiles of cells.
+        const int reps = 20;
+        uint64_t sink = 0;
+        std::unordered_map<uint64_t, uint32_t> hash;
+        t0 = Clock::now();
+        for (int r = 0; r < reps; ++r) {
+            hash.clear();
+            for (size_t si = 0; si < segs.size(); ++si) {
+                for (size_t vi = 0; vi < segs[si].voxels.size(); ++vi) {
+                    const Voxel &v = segs[si].voxels[vi];
+                    const uint64_t k = (static_cast<uint64_t>(static_cast<uint32_t>(math::fixedCell(v.wx))) << 32) | static_cast<uint32_t>(math::fixedCell(v.wy));
+                    hash[k] = static_cast<uint32_t>(si << 16 | vi);
+                }
+            }
+            for (const auto &seg : segs) {
+                for (const Voxel &v : seg.voxels) {
+                    const uint64_t k = (static_cast<uint64_t>(static_cast<uint32_t>(math::fixedCell(v.wx))) << 32) | static_cast<uint32_t>(math::fixedCell(v.wy));
+                    sink += hash.count(k);
+                }
+            }
+        }
+        const double hashNs = msSince(t0) * 1e6 / (static_cast<double>(voxels) * reps);
+        physics::Occupancy occ;
+        t0 = Clock::now();
+        for (int r = 0; r < reps; ++r) {
+            occ.clear();
+            for (size_t si = 0; si < segs.size(); ++si) {
+                for (size_t vi = 0; vi < segs[si].voxels.size(); ++vi) {
+                    const Voxel &v = segs[si].voxels[vi];
+                    occ.add(math::fixedCell(v.wx), math::fixedCell(v.wy), physics::Occupancy::packOwner(static_cast<int>(si), static_cast<int>(vi)));
+                }
+            }
+            for (const auto &seg : segs) {
+                for (const Voxel &v : seg.voxels) sink += occ.count(math::fixedCell(v.wx), math::fixedCell(v.wy));
+            }
+        }
+        const double tileNs = msSince(t0) * 1e6 / (static_cast<double>(voxels) * reps);
+        // A body-sized box beside the body is rejected by its (absent) tiles alone.
+        const int side = shape.width;
+        t0 = Clock::now();
+        for (int r = 0; r < reps * 1000; ++r) sink += occ.anyIn(1000 + r % 7, 1000, 1000 + r % 7 + side - 1, 1000 + side - 1) ? 1 : 0;
+        const double emptyNs = msSince(t0) * 1e6 / (reps * 1000.0);
+
+        // Followers overlapping another segment: every voxel pair vs. the occupancy with
+        // the follower taken out. Timed on the walked body, then checked to agree on a copy
+        // with every other segment slid half a segment onto its predecessor.
+        using Cells = std::vector<std::vector<std::pair<int, int>>>;
+        Cells cells(segs.size());
+        for (size_t si = 0; si < segs.size(); ++si) {
+            for (const Voxel &v : segs[si].voxels) cells[si].emplace_back(math::fixedCell(v.wx), math::fixedCell(v.wy));
+        }
+        auto scanOverlaps = [](const Cells &cs) {
+            int hits = 0;
+            for (size_t i = 1; i < cs.size(); ++i) {
+                bool hit = false;
+                for (size_t j = 0; j < cs.size() && !hit; ++j) {
+                    if (j == i) continue;
+                    for (const auto &a : cs[i]) {
+                        for (const auto &b : cs[j]) hit = hit || a == b;
+                        if (hit) break;
+                    }
+                }
+                hits += hit ? 1 : 0;
+            }
+            return hits;
+        };
+        auto occupancyOverlaps = [&occ](const Cells &cs) {
+            occ.clear();
+            for (const auto &seg : cs) for (const auto &[x, y] : seg) occ.add(x, y, 0);
+            int hits = 0;
+            for (size_t i = 1; i < cs.size(); ++i) {
+                for (const auto &[x, y] : cs[i]) occ.remove(x, y);
+                bool hit = false;
+                for (const auto &[x, y] : cs[i]) hit = hit || occ.occupied(x, y);
+                hits += hit ? 1 : 0;
+                for (const auto &[x, y] : cs[i]) occ.add(x, y, 0);
+            }
+            return hits;
+        };
+        t0 = Clock::now();
+        const int scanHits = scanOverlaps(cells);
+        const double scanUs = msSince(t0) * 1e3;
+        t0 = Clock::now();
+        const int occHits = occupancyOverlaps(cells);
+        const double occUs = msSince(t0) * 1e3;
+        for (size_t si = 1; si < cells.size(); si += 2) {
+            const int sx = static_cast<int>(std::lround((segs[si - 1].x - segs[si].x) * 0.5f));
+            const int sy = static_cast<int>(std::lround((segs[si - 1].y - segs[si].y) * 0.5f));
+            for (auto &[x, y] : cells[si]) { x += sx; y += sy; }
+        }
+        const int foldedScan = scanOverlaps(cells), foldedOcc = occupancyOverlaps(cells);
+
+        std::printf("%s %2dx%-2d voxels, %3zu per segment: %8.1f us per body-tick; fill+query per voxel %.1f ns hash, "
+                    "%.1f ns tiles (%zu tiles), empty box %.1f ns; follower overlap %d/%d: all pairs %.1f us, tiles %.1f us "
+                    "(folded: %d/%d) (sink %llu)\n",
+                    &shape == &shapes[0] ? "[occupancy]" : "           ", shape.width, shape.height, segs[0].voxels.size(),
+                    tickUs, hashNs, tileNs, occ.tilesUsed(), emptyNs, occHits, static_cast<int>(segs.size()) - 1, scanUs, occUs,
+                    foldedOcc, static_cast<int>(segs.size()) - 1, static_cast<unsigned long long>(sink & 0xff));
+        ok = ok && finite && scanHits == occHits && foldedScan == foldedOcc && foldedOcc > 0;
+    }
+    if (!ok) std::printf("  FAIL: a high-resolution body blew up, or the occupancy and the pair scan disagree on overlaps\n");
+    return ok;
+}
+
+// Idle fast path: per body-tick cost of a crowd that stopped walking, before and after it
+// settles into idle (breathing and frozen), and that input wakes it on the same tick.
+static bool benchIdle() {
+    const int bodies = 64;
+    std::vector<Centipede> crowd(bodies, Centipede(40, 10, 14));
+    for (int f = 0; f < 200; ++f) for (auto &c : crowd) scriptedStep(c, f);
+
+    auto tickAll = [&](int ticks) {
+        auto t0 = Clock::now();
+        for (int t = 0; t < ticks; ++t) for (auto &c : crowd) c.update();
+        return msSince(t0) * 1e3 / (static_cast<double>(bodies) * ticks);
+    };
+    const double settlingUs = tickAll(30);
+    int ticksToIdle = 30;
+    auto allIdle = [&] { return std::all_of(crowd.begin(), crowd.end(), [](const Centipede &c) { return c.isIdle(); }); };
+    while (!allIdle() && ticksToIdle < 1000) { tickAll(1); ticksToIdle++; }
+    const double breatheUs = tickAll(200);
+    for (auto &c : crowd) c.setIdleMode(IdleMode::Freeze);
+    const double freezeUs = tickAll(200);
+    std::printf("[idle] %d bodies idle after %d still ticks; per body-tick: still but active %.2f us, "
+                "breathing %.3f us (%.0fx), frozen %.3f us (%.0fx)\n",
+                bodies, ticksToIdle, settlingUs, breatheUs, settlingUs / breatheUs, freezeUs, settlingUs / freezeUs);
+
+    // Input wakes the body on the tick it arrives.
+    Centipede &c = crowd[0];
+    c.tryMove(0.5f, 0.f);
+    c.update();
+    const bool wokeAtOnce = !c.isIdle();
+
+    const bool ok = wokeAtOnce && ticksToIdle < 1000;
+    if (!ok) std::printf("  FAIL: crowd did not settle into idle, or input did not wake it\n");
+    return ok;
+}
+
+// XPBD body dynamics on the scripted walk: spine stretch against the rest spacing, voxel
+// overlap between blobs, colouring, and cost per body-tick for several substep counts
+// (the spring model for reference).
+static bool benchXpbd() {
+    const int frames = 1200, warmup = 60;
+    auto run = [&](Centipede &c, float &meanStretch, float &maxStretch, float &maxOverlap) {
+        meanStretch = maxStretch = maxOverlap = 0.f;
+        int samples = 0;
+        double us = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            auto t0 = Clock::now();
+            scriptedStep(c, f);
+            us += msSince(t0) * 1e3;
+            if (f < warmup) continue;
+            const auto &segs = c.getSegments();
+            for (size_t i = 1; i < segs.size(); ++i) {
+                const float rest = static_cast<float>(segs[i].voxW);
+                const float e = std::fabs(std::hypot(segs[i].x - segs[i-1].x, segs[i].y - segs[i-1].y) - rest) / rest;
+                meanStretch += e;
+                maxStretch = std::max(maxStretch, e);
+                samples++;
+            }
+            for (size_t i = 0; i < segs.size(); ++i) {
+                for (size_t j = i + 1; j < segs.size(); ++j) {
+                    for (const auto &a : segs[i].voxels) {
+                        for (const auto &b : segs[j].voxels) {
+                            maxOverlap = std::max(maxOverlap, 1.f - std::hypot(math::toFloat(a.wx - b.wx), math::toFloat(a.wy - b.wy)));
+                        }
+                    }
+                }
+            }
+        }
+        meanStretch /= static_cast<float>(samples);
+        return us / frames;
+    };
+
+    float mean, worst, overlap;
+    {
+        Centipede c(40, 10, 14);
+        const double us = run(c, mean, worst, overlap);
+        std::printf("[xpbd] springs: spine stretch mean %.4f max %.3f, voxel overlap %.2f, %.2f us per body-tick\n",
+                    mean, worst, overlap, us);
+    }
+    // Overlap ceilings per substep count; more substeps must never overlap more.
+    struct Bound { int substeps; float overlap; };
+    bool ok = true, contactsOk = true;
+    float prevOverlap = 1.f;
+    for (const Bound bound : {Bound{1, 0.75f}, Bound{2, 0.2f}, Bound{4, 0.05f}, Bound{8, 0.05f}}) {
+        const int substeps = bound.substeps;
+        physics::XpbdParams params;
+        params.substeps = substeps;
+        Centipede c(40, 10, 14);
+        c.setBodyDynamics(BodyDynamics::Xpbd, params);
+        const double us = run(c, mean, worst, overlap);
+        const physics::XpbdStats &st = c.getXpbdStats();
+        std::printf("  xpbd %d substep%s: spine stretch mean %.4f max %.3f, voxel overlap %.2f, %.2f us per body-tick "
+                    "(%zu constraints in %zu colours, %zu contacts in %zu)\n",
+                    substeps, substeps == 1 ? " " : "s", mean, worst, overlap, us,
+                    st.constraints, st.colors, st.contacts, st.contactColors);
+        if (substeps == physics::XpbdParams{}.substeps) ok = mean < 0.02f && st.overflow == 0;
+        contactsOk = contactsOk && overlap <= bound.overlap && overlap <= prevOverlap;
+        prevOverlap = overlap;
+    }
+    if (!ok) std::printf("  FAIL: XPBD spine does not hold its rest spacing\n");
+    if (!contactsOk) std::printf("  FAIL: XPBD voxel overlap over its bound, or larger with more substeps\n");
+    return ok && contactsOk;
+}
+
+// Leg-driven locomotion against the kinematic mode on the scripted walk: how far the body
+// travels, how much the planted feet slip, and the cost; plus the vectorized ground-force
+// sums checked against a plain per-leg loop.
+static bool benchLocomotion() {
+    const int frames = 1200;
+    float slipKinematic = 0.f;
+    bool ok = true;
+    for (gait::Locomotion mode : {gait::Locomotion::Kinematic, gait::Locomotion::LegDriven}) {
+        Centipede c(40, 10, 14);
+        c.setLocomotion(mode);
+        double us = 0.0, slipSum = 0.0;
+        float slipMax = 0.f, travelled = 0.f;
+        size_t slipTicks = 0;
+        float lastX = c.getSegments()[0].x, lastY = c.getSegments()[0].y;
+        float forceError = 0.f;
+        for (int f = 0; f < frames; ++f) {
+            auto t0 = Clock::now();
+            scriptedStep(c, f);
+            us += msSince(t0) * 1e3;
+            const Segment &head = c.getSegments()[0];
+            travelled += std::hypot(head.x - lastX, head.y - lastY);
+            lastX = head.x; lastY = head.y;
+            const gait::FootSlip &slip = c.getFootSlip();
+            if (slip.planted > 0) { slipSum += slip.mean; slipTicks++; }
+            slipMax = std::max(slipMax, slip.max);
+
+            gait::GroundForces forces;
+            gait::accumulateGroundForces(c.getSegments(), forces);
+            float refX = 0.f, refY = 0.f;
+            for (const auto &seg : c.getSegments()) {
+                for (const auto &leg : seg.legs) if (leg.onGround) { refX += leg.groundForceX; refY += leg.groundForceY; }
+            }
+            forceError = std::max(forceError, std::fabs(forces.totalX - refX) + std::fabs(forces.totalY - refY));
+        }
+        const float slipMean = slipTicks > 0 ? static_cast<float>(slipSum / static_cast<double>(slipTicks)) : 0.f;
+        const bool driven = mode == gait::Locomotion::LegDriven;
+        std::printf("%s %s: travelled %.1f, planted-foot slip mean %.4f max %.3f per tick, %.2f us per body-tick, force sum error %.1e\n",
+                    driven ? " " : "[locomotion]", driven ? "leg-driven" : "kinematic ", travelled, slipMean, slipMax, us / frames, forceError);
+        ok = ok && forceError < 1e-4f;
+        if (!driven) slipKinematic = slipMean;
+        else ok = ok && travelled > 50.f && slipMean < slipKinematic && slipMax < 3.f;
+    }
+    // A planted foot may creep where the IK cannot hold it, but one that falls out of reach
+    // (the body turned over it) lifts instead of being dragged along a whole stride.
+    if (!ok) std::printf("  FAIL: leg-driven body does not walk, or its feet slip more than the kinematic mode's, "
+                         "or a planted foot was dragged (max slip >= 3 per tick)\n");
+    return ok;
+}
+
+// Per-segment suspension on the scripted walk (flat ground): how far the body heights
+// spread along the spine, the largest step between neighbouring segments, and that the
+// pose carries each segment's own height (outside idle).
+static bool benchSuspension() {
+    const int frames = 1200;
+    Centipede c(40, 10, 14);
+    float spreadSum = 0.f, spreadMax = 0.f, stepMax = 0.f, poseError = 0.f;
+    float zMin = 1e9f, zMax = -1e9f;
+    for (int f = 0; f < frames; ++f) {
+        scriptedStep(c, f);
+        const auto &segs = c.getSegments();
+        const pose::PoseBuffer &pose = c.getPose();
+        float lo = 1e9f, hi = -1e9f;
+        for (size_t i = 0; i < segs.size(); ++i) {
+            lo = std::min(lo, segs[i].bodyZ);
+            hi = std::max(hi, segs[i].bodyZ);
+            if (i > 0) stepMax = std::max(stepMax, std::fabs(segs[i].bodyZ - segs[i - 1].bodyZ));
+            // (Idle bodies breathe: the pose is raised over the heights.)
+            if (!c.isIdle() && i < pose.segmentCount()) poseError = std::max(poseError, std::fabs(pose.spineZ[i] - segs[i].bodyZ));
+        }
+        spreadSum += hi - lo;
+        spreadMax = std::max(spreadMax, hi - lo);
+        zMin = std::min(zMin, lo);
+        zMax = std::max(zMax, hi);
+    }
+    std::printf("[suspension] body z %.3f..%.3f, spread along the spine mean %.4f max %.4f, "
+                "neighbour step max %.4f, pose error %.1e\n",
+                zMin, zMax, spreadSum / frames, spreadMax, stepMax, poseError);
+    // On flat ground the segments differ only by their legs' clearances, which are pooled
+    // with the neighbours' and the body's.
+    const bool ok = zMin >= 0.15f && zMax <= 2.f && spreadMax > 0.f && spreadMax < 0.5f && stepMax < 0.25f &&
+                    poseError < 1e-6f;
+    if (!ok) std::printf("  FAIL: segment heights out of range, all equal, too far apart along the spine, or not in the pose\n");
+    return ok;
+}
+
+// Heightfield terrain: continuity of height across chunk borders and of the normal
+// against finite differences; then the scripted walk on it (planted feet against the
+// ground, and how many queries the per-leg caches answer), and the sampling cost for a
+// crowd of bodies per leg-tick.
+static bool benchTerrain() {
+    terrain::Heightfield field;
+    const float border = static_cast<float>(terrain::kChunkCells) * field.cellSize();
+    float seam = 0.f, normalErr = 0.f;
+    for (int k = 0; k < 200; ++k) {
+        const float t = static_cast<float>(k) * 0.37f - 40.f;
+        seam = std::max(seam, std::fabs(field.height(border - 1e-4f, t) - field.height(border + 1e-4f, t)));
+        seam = std::max(seam, std::fabs(field.height(t, -border - 1e-4f) - field.height(t, -border + 1e-4f)));
+        // Normal against central differences, away from cell edges (the gradient kinks there).
+        const float x = std::floor(t) + 0.3f, y = std::floor(t * 0.7f) + 0.6f, h = 1e-2f;
+        const terrain::GroundSample s = field.sample(x, y);
+        const float dzdx = (field.height(x + h, y) - field.height(x - h, y)) / (2.f * h);
+        const float dzdy = (field.height(x, y + h) - field.height(x, y - h)) / (2.f * h);
+        normalErr = std::max(normalErr, std::fabs(-s.nx / s.nz - dzdx) + std::fabs(-s.ny / s.nz - dzdy));
+    }
+
+    // The walk on flat ground and on the terrain. Feet lag their holds (IK smoothing and
+    // reach), so planted feet are judged against the flat walk's figure.
+    struct Walk { double footErr = 0.0, holdErr = 0.0; float holdErrMax = 0.f; size_t queries = 0, hits = 0, swingSteps = 0; };
+    auto walk = [&](terrain::Heightfield *ground) {
+        terrain::setActive(ground);
+        Centipede c(40, 10, 14);
+        field.resetStats();
+        Walk w;
+        size_t planted = 0;
+        for (int f = 0; f < 1200; ++f) {
+            scriptedStep(c, f);
+            const auto &segs = c.getSegments();
+            const pose::PoseBuffer &pose = c.getPose();
+            for (size_t i = 0; i < segs.size(); ++i) {
+                for (size_t k = 0; k < segs[i].legs.size(); ++k) {
+                    const Segment::Leg &leg = segs[i].legs[k];
+                    if (!leg.onGround) { w.swingSteps++; continue; }
+                    const uint32_t l = pose.legBegin[i] + static_cast<uint32_t>(k);
+                    w.footErr += std::fabs(pose.z[pose::Foot][l] - terrain::groundHeight(pose.x[pose::Foot][l], pose.y[pose::Foot][l]));
+                    const float holdErr = std::fabs(leg.footHoldZ - terrain::groundHeight(leg.footHoldX, leg.footHoldY));
+                    w.holdErr += holdErr;
+                    w.holdErrMax = std::max(w.holdErrMax, holdErr);
+                    planted++;
+                }
+            }
+        }
+        // The checks only take direct samples, so the cached queries are all the gait's.
+        w.queries = field.sampleStats().queries;
+        w.hits = field.sampleStats().cacheHits;
+        const double n = static_cast<double>(std::max<size_t>(planted, 1));
+        w.footErr /= n;
+        w.holdErr /= n;
+        return w;
+    };
+    const Walk flat = walk(nullptr);
+    const Walk hilly = walk(&field);
+    std::printf("[terrain] seam %.1e, normal err %.1e; walk: planted foot vs ground mean %.4f (flat %.4f), "
+                "hold height err mean %.4f max %.3f, %.2f gait queries per swinging leg-tick, cache hits %.0f%%, %zu chunks\n",
+                seam, normalErr, hilly.footErr, flat.footErr, hilly.holdErr, hilly.holdErrMax,
+                static_cast<double>(hilly.queries) / static_cast<double>(std::max<size_t>(hilly.swingSteps, 1)),
+                100.0 * static_cast<double>(hilly.hits) / static_cast<double>(std::max<size_t>(hilly.queries, 1)), field.chunkCount());
+    terrain::setActive(&field);
+
+    // Crowd: the gait's terrain queries per leg-tick, with caches vs. sampling every query.
+    const int bodies = 200, ticks = 200;
+    std::vector<std::vector<Segment>> crowd(bodies, Centipede(0, 0, 14).getSegments());
+    size_t legs = 0;
+    for (const auto &b : crowd) for (const auto &seg : b) legs += seg.legs.size();
+    auto runCrowd = [&](bool cached) {
+        field.resetStats();
+        float time = 0.f;
+        const float speed = 0.3f;
+        auto start = Clock::now();
+        for (int t = 0; t < ticks; ++t) {
+            time += kIdleGaitAdvance + speed * kGaitPerUnit;
+            for (size_t b = 0; b < crowd.size(); ++b) {
+                for (auto &seg : crowd[b]) {
+                    seg.x += speed;
+                    seg.y = static_cast<float>(b) * 9.f;
+                    if (!cached) for (auto &leg : seg.legs) leg.groundCache.valid = false;
+                }
+                gait::updateGait(crowd[b], time, speed, 0.f);
+            }
+        }
+        return msSince(start) * 1e6 / (static_cast<double>(legs) * ticks);
+    };
+    const double uncachedNs = runCrowd(false);
+    const size_t uncachedSamples = field.sampleStats().samples;
+    const double cachedNs = runCrowd(true);
+    const size_t cachedSamples = field.sampleStats().samples;
+    std::printf("  %d bodies: gait %.1f ns/leg-tick sampling every query (%.3f samples/leg-tick), "
+                "%.1f ns/leg-tick cached (%.3f samples/leg-tick), %zu chunks\n",
+                bodies, uncachedNs, static_cast<double>(uncachedSamples) / (static_cast<double>(legs) * ticks),
+                cachedNs, static_cast<double>(cachedSamples) / (static_cast<double>(legs) * ticks), field.chunkCount());
+    terrain::setActive(nullptr);
+
+    const bool ok = seam < 1e-3f && normalErr < 1e-2f && hilly.holdErrMax < 0.1f && hilly.footErr < flat.footErr + 0.15
+                    && hilly.hits * 2 > hilly.queries && cachedSamples * 2 < uncachedSamples;
+    if (!ok) std::printf("  FAIL: terrain discontinuous, feet off the ground, or the sample caches miss\n");
+    return ok;
+}
+
+// Streamed world: a body walks out past many chunks and back with a small resident
+// budget, so chunks are evicted to the mapped store and read back. Checks the budget,
+// that revisited chunks load instead of regenerating, that an edit survives eviction and
+// reopening the store, that a store which cannot grow loses no edits, and times
+// generating against loading a chunk.
+static bool benchWorld() {
+    const std::filesystem::path storePath = std::filesystem::temp_directory_path() / "centipede_bench_world.chunks";
+    std::error_code ec;
+    std::filesystem::remove(storePath, ec);
+    world::WorldParams params;
+    params.maxResident = 16;
+    params.storePath = storePath.string();
+    params.obstacleDensity = 0.f;  // a straight walk; rocks would stop it
+    bool ok = true;
+    {
+        world::World w(params);
+        world::setActive(&w);
+        terrain::setActive(&w.ground());
+        Centipede c(40, 10, 14);
+        size_t maxResident = 0;
+        double streamUs = 0.0;
+        const int frames = 6000;
+        size_t generatedOut = 0;
+        for (int f = 0; f < frames; ++f) {
+            // Out along +x for half the run, then back.
+            const float dir = f < frames / 2 ? 1.f : -1.f;
+            c.tryMove(dir * 1.2f, 0.f);
+            const Segment &head = c.getSegments()[0];
+            auto t0 = Clock::now();
+            w.streamAround(head.x, head.y, 50.f);
+            streamUs += msSince(t0) * 1e3;
+            c.update();
+            maxResident = std::max(maxResident, w.residentCount());
+            if (f == frames / 2) generatedOut = w.worldStats().generated;
+        }
+        const world::WorldStats walk = w.worldStats();
+        std::printf("[world] walk to x=%.0f and back: %zu chunks generated (%zu on the way out), %zu loaded, %zu evicted, "
+                    "%zu written; resident max %zu of %zu; stream %.2f us per tick; store %zu records, %.1f MB\n",
+                    c.getSegments()[0].x, walk.generated, generatedOut, walk.loaded, walk.evicted, walk.written,
+                    maxResident, params.maxResident, streamUs / frames, w.storedCount(), static_cast<double>(w.storeBytes()) / (1024.0 * 1024.0));
+        ok = ok && w.hasStore() && maxResident <= params.maxResident && walk.loaded > 0 && walk.generated == generatedOut;
+
+        // An edit survives eviction.
+        w.setCellFlags(5, 5, world::kCellObstacle);
+        w.setCellFlags(6, 5, 0);
+        for (int64_t k = 0; k < 40; ++k) w.posts(1000 + k, 0);
+        ok = ok && w.cellFlags(5, 5) == world::kCellObstacle && w.cellFlags(6, 5) == 0;
+
+        // Generate vs load, per chunk.
+        w.resetStats();
+        auto t0 = Clock::now();
+        for (int64_t k = 0; k < 64; ++k) w.posts(-5000, k);
+        const double genUs = msSince(t0) * 1e3 / 64.0;
+        for (int64_t k = 0; k < 64; ++k) w.posts(5000, k);
+        t0 = Clock::now();
+        for (int64_t k = 0; k < 64; ++k) w.posts(-5000, k);
+        const double loadUs = msSince(t0) * 1e3 / 64.0;
+        std::printf("  per chunk: generate %.1f us, evict + load from the store %.1f us (%zu loaded)\n",
+                    genUs, loadUs, w.worldStats().loaded);
+        ok = ok && w.worldStats().loaded >= 64;
+        terrain::setActive(nullptr);
+        world::setActive(nullptr);
+    }
+    {
+        // Reopened store: the edit is on disk.
+        world::World w(params);
+        const bool kept = w.cellFlags(5, 5) == world::kCellObstacle && w.cellFlags(6, 5) == 0 && w.worldStats().loaded == 1;
+        std::printf("  reopened store: %zu records, edit %s\n", w.storedCount(), kept ? "kept" : "LOST");
+        ok = ok && kept;
+    }
+    std::filesystem::remove(storePath, ec);
+
+    {
+        // A full store: capped at the size it is created with, so the first grow fails in
+        // map(). Edited chunks past its slots stay resident; the stored ones still load.
+        world::WorldParams capped = params;
+        capped.maxResident = 4;
+        { world::World probe(capped); capped.storeMaxBytes = probe.storeBytes(); }
+        std::filesystem::remove(storePath, ec);
+        world::World w(capped);
+        const int64_t chunks = 100;
+        for (int64_t k = 0; k < chunks; ++k) w.setCellFlags(k * world::kChunkCells, 0, world::kCellObstacle);
+        int64_t kept = 0;
+        for (int64_t k = 0; k < chunks; ++k) kept += w.cellFlags(k * world::kChunkCells, 0) == world::kCellObstacle;
+        const world::WorldStats full = w.worldStats();
+        std::printf("  full store: %zu of %lld edited chunks stored, %zu writes refused, %zu resident; %lld edits kept, store %s\n",
+                    w.storedCount(), static_cast<long long>(chunks), full.writeFailed, w.residentCount(),
+                    static_cast<long long>(kept), w.hasStore() ? "open" : "CLOSED");
+        ok = ok && w.hasStore() && full.writeFailed > 0 && w.storedCount() < static_cast<size_t>(chunks) && kept == chunks;
+    }
+    std::filesystem::remove(storePath, ec);
+    if (!ok) std::printf("  FAIL: world over its resident budget, chunks not restored from the store, or edits lost to a full store\n");
+    return ok;
+}
+
+// Floating origin: the same walk with and without rebasing (positions compared in
+// absolute terms, voxel cells checked across every rebase), a body far from the origin
+// taking small steps with and without a rebase, and the cost of a rebase per entity.
+// The steps are dyadic (1, 0.5), so the unrebased head lands on the same points however
+// far out it gets and carries no rounding of its own: what differs between the walks is
+// only what the rebase changes, and every frame of the outward leg must agree to well
+// under a voxel cell. (With arbitrary steps the unrebased head drifts by its rounding,
+// which grows with the distance from the origin, and a voxel collision eventually tips
+// the other way. On the way back the head turns into its own body and shoves voxels
+// between cells, where the last bit of a follower's position picks the cell, so that leg
+// is not compared.)
+static bool benchOrigin() {
+    world::WorldParams params;
+    params.obstacleDensity = 0.f;
+    const float span = static_cast<float>(world::kChunkCells);
+    const int frames = 1500;
+    struct Track { std::vector<float> x, y; size_t rebases = 0, cellMoves = 0; };
+    auto walk = [&](bool rebasing) {
+        world::World w(params);
+        world::setActive(&w);
+        terrain::setActive(&w.ground());
+        Centipede c(40, 10, 14);
+        Track track;
+        for (int f = 0; f < frames; ++f) {
+            float shiftX = 0.f, shiftY = 0.f;
+            if (rebasing && w.rebaseToward(c.getSegments()[0].x, c.getSegments()[0].y, shiftX, shiftY)) {
+                // Every voxel keeps its cell, shifted by whole cells.
+                std::vector<int> cells;
+                for (const auto &seg : c.getSegments()) {
+                    for (const auto &v : seg.voxels) {
+                        cells.push_back(math::fixedCell(v.wx));
+                        cells.push_back(math::fixedCell(v.wy));
+                    }
+                }
+                c.rebase(shiftX, shiftY);
+                size_t k = 0;
+                for (const auto &seg : c.getSegments()) {
+                    for (const auto &v : seg.voxels) {
+                        if (math::fixedCell(v.wx) != cells[k] - static_cast<int>(shiftX)
+                            || math::fixedCell(v.wy) != cells[k + 1] - static_cast<int>(shiftY)) track.cellMoves++;
+                        k += 2;
+                    }
+                }
+                track.rebases++;
+            }
+            // Out along a diagonal and back.
+            const float dir = f < frames / 2 ? 1.f : -1.f;
+            c.tryMove(dir * 1.f, dir * 0.5f);
+            w.streamAround(c.getSegments()[0].x, c.getSegments()[0].y, 50.f);
+            c.update();
+            const float ox = static_cast<float>(w.originChunkX()) * span, oy = static_cast<float>(w.originChunkY()) * span;
+            for (const auto &seg : c.getSegments()) {
+                track.x.push_back(seg.x + ox);
+                track.y.push_back(seg.y + oy);
+            }
+        }
+        terrain::setActive(nullptr);
+        world::setActive(nullptr);
+        return track;
+    };
+    const Track fixed = walk(false), rebased = walk(true);
+    const size_t perFrame = fixed.x.size() / frames;
+    float maxDev = 0.f;
+    int noiseFrames = 0;
+    for (int f = 0; f < frames / 2; ++f) {
+        float frameDev = 0.f;
+        for (size_t i = f * perFrame; i < (f + 1) * perFrame; ++i) {
+            frameDev = std::max(frameDev, std::max(std::fabs(fixed.x[i] - rebased.x[i]), std::fabs(fixed.y[i] - rebased.y[i])));
+        }
+        maxDev = std::max(maxDev, frameDev);
+        if (frameDev < 1e-2f) noiseFrames++;
+    }
+    std::printf("[origin] walk to x=%.0f and back: %zu rebases; on the way out, spine within 1e-2 of the unrebased walk "
+                "in %d of %d frames, max deviation %.1e; %zu voxels changed cell on rebase\n",
+                fixed.x[fixed.x.size() / 2], rebased.rebases, noiseFrames, frames / 2, maxDev, rebased.cellMoves);
+
+    // Far out (x = 30000, float spacing 2^-9: about as far as 16.16 voxels reach without
+    // a rebase) steps under half the spacing round away; rebased they do not.
+    auto crawl = [&](int x, bool rebasing) {
+        world::World w(params);
+        world::setActive(&w);
+        terrain::setActive(&w.ground());
+        Centipede c(x, 10, 14);
+        float shiftX = 0.f, shiftY = 0.f;
+        if (rebasing && w.rebaseToward(c.getSegments()[0].x, c.getSegments()[0].y, shiftX, shiftY)) c.rebase(shiftX, shiftY);
+        const float startX = c.getSegments()[0].x;
+        for (int f = 0; f < 200; ++f) {
+            c.tryMove(9e-4f, 0.f);
+            c.update();
+        }
+        const float moved = c.getSegments()[0].x - startX;
+        terrain::setActive(nullptr);
+        world::setActive(nullptr);
+        return moved;
+    };
+    const float nearMoved = crawl(40, false), farMoved = crawl(30000, false), farRebased = crawl(30000, true);
+    std::printf("  200 steps of 9e-4 at x=30000: head moved %.4f without a rebase, %.4f after one (%.4f near the origin)\n",
+                farMoved, farRebased, nearMoved);
+
+    // Cost of a rebase per entity (segment, voxel or leg).
+    Centipede big(40, 10, 200);
+    size_t entities = 0;
+    for (const auto &seg : big.getSegments()) entities += 1 + seg.voxels.size() + seg.legs.size();
+    const int reps = 2000;
+    auto t0 = Clock::now();
+    for (int r = 0; r < reps; ++r) big.rebase(r & 1 ? -span : span, 0.f);
+    const double ns = msSince(t0) * 1e6 / (static_cast<double>(reps) * static_cast<double>(entities));
+    std::printf("  rebase: %.2f ns per entity (%zu entities, %.1f us per 200-segment body)\n",
+                ns, entities, ns * static_cast<double>(entities) * 1e-3);
+
+    const bool ok = rebased.rebases > 0 && rebased.cellMoves == 0 && noiseFrames == frames / 2 && std::fabs(farRebased - nearMoved) < 1e-4f
+                    && farMoved < nearMoved * 0.5f;
+    if (!ok) std::printf("  FAIL: rebasing changed the walk or voxel cells, or far-out precision not restored\n");
+    return ok;
+}
+
+// Articulated spine: a scripted walk driven by the legs (sideways slip of the segments,
+// and whether the body comes to rest and idles in the pauses), then the cost of one chain step from 10 to 1,000 links under leg-like forces.
+static bool benchArticulated() {
+    const int frames = 1200;
+    Centipede c(40, 10, 14);
+    c.setBodyDynamics(BodyDynamics::Articulated);
+    float slip = 0.f;
+    double us = 0.0;
+    int idleFrames = 0, slipSamples = 0;
+    std::vector<std::pair<float, float>> before;
+    for (int f = 0; f < frames; ++f) {
+        auto t0 = Clock::now();
+        scriptedStep(c, f);
+        us += msSince(t0) * 1e3;
+        if (c.isIdle()) idleFrames++;
+        // Sideways speed of every segment relative to its heading (grid units per tick).
+        const auto &segs = c.getSegments();
+        if (!before.empty()) {
+            for (size_t i = 0; i < segs.size(); ++i) {
+                const float dx = segs[i].x - before[i].first, dy = segs[i].y - before[i].second;
+                slip += std::fabs(-dx * segs[i].heading.s + dy * segs[i].heading.c);
+                slipSamples++;
+            }
+        }
+        before.clear();
+        for (const auto &seg : segs) before.emplace_back(seg.x, seg.y);
+    }
+    std::printf("[chain] 14 segments: %.2f us per body-tick, mean sideways slip %.4f per tick, idle %d of 400 pause ticks\n",
+                us / frames, slip / static_cast<float>(slipSamples), idleFrames);
+    bool ok = idleFrames > 0;
+
+    for (int links : {10, 100, 1000}) {
+        std::vector<float> xs(links), ys(links, 0.f), lengths(links, 3.f);
+        for (int i = 0; i < links; ++i) xs[i] = -3.f * static_cast<float>(i);
+        physics::ArticulatedChain chain;
+        chain.build(xs.data(), ys.data(), lengths.data(), links, 1.f);
+        physics::ChainParams params;
+        float tx = 0.f, ty = 0.f;
+        const int steps = 600;
+        auto t0 = Clock::now();
+        for (int t = 0; t < steps; ++t) {
+            const float a = static_cast<float>(t) * 0.02f;
+            tx += std::cos(a) * 0.4f; ty += std::sin(a) * 0.4f;
+            chain.setHeadTarget(tx, ty);
+            for (int i = 0; i < links; ++i) {
+                // Legs: push at the walking speed, grip against sideways slip.
+                const float fx = chain.forwardX(i), fy = chain.forwardY(i);
+                float vx, vy;
+                chain.pointVelocity(i, chain.posX(i), chain.posY(i), vx, vy);
+                const float thrust = 12.f * (24.f - (vx * fx + vy * fy)), grip = -12.f * (-vx * fy + vy * fx);
+                chain.addForce(i, chain.posX(i), chain.posY(i), thrust * fx - grip * fy, thrust * fy + grip * fx);
+            }
+            chain.step(params);
+        }
+        const double stepUs = msSince(t0) * 1e3 / steps;
+        const bool finite = std::isfinite(chain.posX(links - 1)) && std::isfinite(chain.maxSpeed());
+        std::printf("  %4d links: %.1f us per step (%.1f ns per link), head %.2f behind its target%s\n",
+                    links, stepUs, stepUs * 1e3 / links, chain.headTargetDistance(), finite ? "" : " (diverged)");
+        ok = ok && finite;
+        if (links == 1000) ok = ok && stepUs < 500.0;
+    }
+    if (!ok) std::printf("  FAIL: articulated spine diverged, never came to rest, or is over budget\n");
+    return ok;
+}
+
+// Head path following on a long body: spacing error against the rest spacing, the same
+// head path driven at two move rates (whole vs. half steps), and cost per follower.
+static bool benchHeadPath() {
+    const int length = 400, moves = 2000;
+    auto walk = [&](Centipede &c, int split, float &maxError) {
+        maxError = 0.f;
+        double us = 0.0;
+        for (int m = 0; m < moves; ++m) {
+            const float t = static_cast<float>(m) * 0.02f;
+            const float dx = std::cos(t) * 0.6f / static_cast<float>(split);
+            const float dy = std::sin(t) * 0.6f / static_cast<float>(split);
+            auto t0 = Clock::now();
+            for (int k = 0; k < split; ++k) c.moveBy(dx, dy);
+            us += msSince(t0) * 1e3;
+            const auto &segs = c.getSegments();
+            for (size_t i = 1; i < segs.size(); ++i) {
+                const float rest = static_cast<float>(segs[i].voxW);
+                const float d = std::hypot(segs[i].x - segs[i-1].x, segs[i].y - segs[i-1].y);
+                maxError = std::max(maxError, std::fabs(d - rest) / rest);
+            }
+        }
+        return us / moves;
+    };
+
+    Centipede whole(40, 10, length), half(40, 10, length);
+    whole.setSimTier(lod::SimTier::Ghost);
+    half.setSimTier(lod::SimTier::Ghost);
+    float errWhole, errHalf;
+    const double us = walk(whole, 1, errWhole);
+    walk(half, 2, errHalf);
+    float drift = 0.f;
+    for (size_t i = 0; i < whole.getSegments().size(); ++i) {
+        const Segment &a = whole.getSegments()[i], &b = half.getSegments()[i];
+        drift = std::max(drift, std::hypot(a.x - b.x, a.y - b.y));
+    }
+    std::printf("[path] %d segments: max spacing error %.4f (half-rate moves %.4f), whole vs. half-rate max drift %.5f, "
+                "%.2f us per move (%.1f ns per follower)\n",
+                length, errWhole, errHalf, drift, us, us * 1e3 / (length - 1));
+    const bool ok = errWhole < 0.01f && errHalf < 0.01f && drift < 1e-2f;
+    if (!ok) std::printf("  FAIL: followers drift off the rest spacing or depend on the move rate\n");
+    return ok;
+}
+
+// Long open-loop replay of gait + IK, one record per tick with every leg's yaw, joint
+// angles and foot hold. The spine follows a scripted path instead of the full sim: the
+// voxel collision pass snaps to grid cells, so the closed-loop sim amplifies any
+// rounding difference into a different trajectory and cannot be compared across builds.
+static constexpr int kReplayFrames = 6000;
+static constexpr uint32_t kReplayMagic = 0x43525032u; // "CRP2"
+
+struct Replay {
+    std::vector<Segment> segments;
+    morph::IkPassKernel ikPass = morph::ikPassKernelFor<3, 1>();
+    float gaitTime = 0.f;
+    float lastX = 0.f, lastY = 0.f;
+
+    Replay() : segments(Centipede(40, 10, 14).getSegments()) {}
+
+    // Head on a wandering loop, followers trailing at a fixed spacing along the same curve.
+    void step(int frame, std::vector<float> &rec) {
+        const float spacing = 0.06f;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const float t = static_cast<float>(frame) * 0.004f - static_cast<float>(i) * spacing;
+            segments[i].x = 40.f + 25.f * std::cos(t) + 6.f * std::sin(2.3f * t);
+            segments[i].y = 30.f + 18.f * std::sin(t) + 4.f * std::cos(1.7f * t);
+        }
+        const float dx = segments[0].x - lastX, dy = segments[0].y - lastY;
+        lastX = segments[0].x;
+        lastY = segments[0].y;
+        gaitTime += 0.015f + std::sqrt(dx * dx + dy * dy) * 5.55f;
+        const float bodyZ = 0.6f + 0.2f * std::sin(static_cast<float>(frame) * 0.013f);
+        for (Segment &seg : segments) seg.bodyZ = bodyZ;
+        gait::updateGait(segments, gaitTime, dx, dy);
+        morph::IkPassCounters counters;
+        ikPass(segments, counters);
+
+        rec.clear();
+        for (const Segment &seg : segments) {
+            for (const Segment::Leg &L : seg.legs) {
+                // Yaw as (cos, sin) so the comparison does not see the +-pi wrap.
+                rec.push_back(L.hipYaw.c);
+                rec.push_back(L.hipYaw.s);
+                rec.push_back(L.kneeAngle);
+                rec.push_back(L.footAngle);
+                rec.push_back(L.footHoldX);
+                rec.push_back(L.footHoldY);
+            }
+        }
+    }
+};
+
+int recordReplay(const char *path) {
+    std::FILE *f = std::fopen(path, "wb");
+    if (!f) { std::printf("[replay] cannot open %s\n", path); return 1; }
+    Replay replay;
+    std::vector<float> rec;
+    const uint32_t header[2] = {kReplayMagic, static_cast<uint32_t>(kReplayFrames)};
+    std::fwrite(header, sizeof(header), 1, f);
+    for (int frame = 0; frame < kReplayFrames; ++frame) {
+        replay.step(frame, rec);
+        const uint32_t count = static_cast<uint32_t>(rec.size());
+        std::fwrite(&count, sizeof(count), 1, f);
+        std::fwrite(rec.data(), sizeof(float), rec.size(), f);
+    }
+    std::fclose(f);
+    std::printf("[replay] recorded %d frames to %s (fast math %s)\n", kReplayFrames, path, CENTIPEDE_FAST_MATH ? "on" : "off");
+    return 0;
+}
+
+int checkReplay(const char *path, float tolerance) {
+    std::FILE *f = std::fopen(path, "rb");
+    if (!f) { std::printf("[replay] cannot open %s\n", path); return 1; }
+    uint32_t header[2] = {0, 0};
+    if (std::fread(header, sizeof(header), 1, f) != 1 || header[0] != kReplayMagic) {
+        std::printf("[replay] %s is not a replay file\n", path);
+        std::fclose(f);
+        return 1;
+    }
+    Replay replay;
+    std::vector<float> rec, ref;
+    float maxDiff = 0.f;
+    int worstFrame = -1;
+    bool ok = true;
+    for (int frame = 0; frame < static_cast<int>(header[1]); ++frame) {
+        replay.step(frame, rec);
+        uint32_t count = 0;
+        if (std::fread(&count, sizeof(count), 1, f) != 1 || count != rec.size()) { ok = false; break; }
+        ref.resize(count);
+        if (std::fread(ref.data(), sizeof(float), count, f) != count) { ok = false; break; }
+        for (size_t i = 0; i < count; ++i) {
+            const float d = std::fabs(rec[i] - ref[i]);
+            if (d > maxDiff) { maxDiff = d; worstFrame = frame; }
+        }
+    }
+    std::fclose(f);
+    if (!ok) { std::printf("[replay] %s does not match this sim's layout\n", path); return 1; }
+    std::printf("[replay] %u frames (fast math %s): max diff %.2e at frame %d, tolerance %.2e\n",
+                header[1], CENTIPEDE_FAST_MATH ? "on" : "off", maxDiff, worstFrame, tolerance);
+    if (maxDiff > tolerance) { std::printf("  FAIL: replay diverged beyond tolerance\n"); return 1; }
+    return 0;
+}
+
+int run() {
+    bool ok = true;
+    ok = benchFastMath() && ok;
+    ok = benchIKTable() && ok;
+    ok = benchChainIK() && ok;
+    ok = benchCpg() && ok;
+    ok = benchGaitClips() && ok;
+    ok = benchSimLod() && ok;
+    ok = benchVoxelSleep() && ok;
+    ok = benchFixedVoxels() && ok;
+    ok = benchBodyMask() && ok;
+    ok = benchOccupancy() && ok;
+    ok = benchIdle() && ok;
+    ok = benchXpbd() && ok;
+    ok = benchHeadPath() && ok;
+    ok = benchSuspension() && ok;
+    ok = benchTerrain() && ok;
+    ok = benchWorld() && ok;
+    ok = benchOrigin() && ok;
+    ok = benchArticulated() && ok;
+    ok = benchLocomotion() && ok;
+    return ok ? 0 : 1;
+}
+
+} // namespace bench
@@ -0,0 +1,14 @@
+#pragma once
+
+namespace bench {
+    // Headless micro-benchmarks, run with `Main --bench`. Prints timings and accuracy
+    // reports to stdout and returns the process exit code (non-zero on a failed check).
+    int run();
+
+    // Cross-build check for CENTIPEDE_FAST_MATH: record a long gait + IK replay from a
+    // libm build (`Main --replay-record <file>`), then check a fast-math build against it
+    // (`Main --replay-check <file> [tolerance]`). Non-zero exit when outputs diverge.
+    inline constexpr float kDefaultReplayTolerance = 1e-3f;
+    int recordReplay(const char *path);
+    int checkReplay(const char *path, float tolerance = kDefaultReplayTolerance);
+}
@@ -0,0 +1,226 @@
+#include "Cpg.hpp"
+#include "GaitController.hpp"
+#include "../math/FastMath.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace gait {
+
+static constexpr float kTwoPi = 6.28318531f;
+static constexpr double kTurnsPerRadian = 683565275.57643159;  // 2^32 / (2*pi)
+static constexpr float kRadiansPerTurn = 1.46291808e-9f;       // 2*pi / 2^32
+
+// Fixed-point phase (any angle, wrapped to one turn).
+static uint32_t toTurns(float a) {
+    return static_cast<uint32_t>(static_cast<int64_t>(std::nearbyint(static_cast<double>(a) * kTurnsPerRadian)));
+}
+
+// Wrapped into [0, 2*pi).
+static float toRadians(uint32_t t) {
+    const float a = static_cast<float>(static_cast<double>(t) * (static_cast<double>(kTwoPi) / 4294967296.0));
+    return a >= kTwoPi ? 0.f : a;
+}
+
+// Wrapped into [-pi, pi).
+static float toSignedRadians(uint32_t t) {
+    return static_cast<float>(static_cast<int32_t>(t)) * kRadiansPerTurn;
+}
+
+// A small phase step (|a| < pi), as the network's per-tick coupling terms are.
+static uint32_t stepTurns(float a) {
+    return static_cast<uint32_t>(static_cast<int32_t>(std::lrint(a * static_cast<float>(kTurnsPerRadian))));
+}
+
+CpgNetwork::CpgNetwork(const CpgParams &params) : params(params) {
+    clear();
+}
+
+void CpgNetwork::clear() {
+    bodies.clear();
+    segments = 0;
+    for (auto *v : {&phaseL, &phaseR, &nextL, &nextR, &drive, &segmentLag, &sideLag}) v->assign(1, 0u);
+    frontWeight.assign(1, 0.f);
+}
+
+uint32_t CpgNetwork::addBody(size_t segmentCount) {
+    Body b;
+    b.begin = static_cast<uint32_t>(segments);
+    b.count = static_cast<uint32_t>(segmentCount);
+    b.drive = 0.f;
+    b.speed = 0.f;
+    b.segmentLag = kCpgWave.segmentLag;
+    b.sideLag = kCpgWave.sideLag;
+    b.gallop = false;
+
+    for (size_t i = 0; i < segmentCount; ++i) {
+        const uint32_t left = toTurns(static_cast<float>(i) * b.segmentLag);
+        phaseL.push_back(left);
+        phaseR.push_back(left + toTurns(b.sideLag));
+        frontWeight.push_back(i == 0 ? 0.f : 1.f);
+    }
+    segments += segmentCount;
+    for (auto *v : {&nextL, &nextR, &drive, &segmentLag, &sideLag}) v->resize(segments + 1, 0u);
+    writeBodyInputs(b);
+
+    bodies.push_back(b);
+    return static_cast<uint32_t>(bodies.size() - 1);
+}
+
+void CpgNetwork::removeBody(uint32_t body) {
+    Body &b = bodies[body];
+    if (b.count == 0) return;
+    const auto first = static_cast<std::ptrdiff_t>(b.begin) + 1;
+    const auto last = first + static_cast<std::ptrdiff_t>(b.count);
+    for (auto *v : {&phaseL, &phaseR, &nextL, &nextR, &drive, &segmentLag, &sideLag}) {
+        v->erase(v->begin() + first, v->begin() + last);
+    }
+    frontWeight.erase(frontWeight.begin() + first, frontWeight.begin() + last);
+    for (Body &other : bodies) {
+        if (other.count > 0 && other.begin > b.begin) other.begin -= b.count;
+    }
+    segments -= b.count;
+    b.count = 0;
+}
+
+void CpgNetwork::setDrive(uint32_t body, float phaseAdvance, float headSpeed) {
+    Body &b = bodies[body];
+    b.speed = headSpeed;
+    if (b.drive == phaseAdvance) return;
+    b.drive = phaseAdvance;
+    std::fill_n(drive.begin() + b.begin + 1, b.count, toTurns(phaseAdvance));
+}
+
+void CpgNetwork::perturb(uint32_t body, size_t segment, float dPhase) {
+    const Body &b = bodies[body];
+    if (segment >= b.count) return;
+    const size_t i = b.begin + 1 + segment;
+    phaseL[i] += toTurns(dPhase);
+    phaseR[i] += toTurns(dPhase);
+}
+
+void CpgNetwork::writeBodyInputs(const Body &b) {
+    const size_t first = b.begin + 1;
+    std::fill_n(drive.begin() + first, b.count, toTurns(b.drive));
+    writeBodyLags(b);
+}
+
+void CpgNetwork::writeBodyLags(const Body &b) {
+    const size_t first = b.begin + 1;
+    std::fill_n(segmentLag.begin() + first, b.count, toTurns(b.segmentLag));
+    std::fill_n(sideLag.begin() + first, b.count, toTurns(b.sideLag));
+}
+
+void CpgNetwork::step() {
+    // Per body: pick the gait from head speed (with hysteresis) and ease the lags toward it.
+    // The coupling terms use the coarse sin (~1e-3): it only shifts the pull strength.
+    for (Body &b : bodies) {
+        if (b.count == 0) continue;
+        if (b.gallop && b.speed < params.waveSpeed) b.gallop = false;
+        else if (!b.gallop && b.speed > params.gallopSpeed) b.gallop = true;
+        const CpgPattern &target = b.gallop ? kCpgGallop : kCpgWave;
+        if (b.segmentLag == target.segmentLag && b.sideLag == target.sideLag) continue;
+        b.segmentLag += (target.segmentLag - b.segmentLag) * params.patternRate;
+        b.sideLag += (target.sideLag - b.sideLag) * params.patternRate;
+        // Snap once close so settled bodies stop rewriting their lag arrays.
+        if (std::fabs(target.segmentLag - b.segmentLag) < 1e-4f && std::fabs(target.sideLag - b.sideLag) < 1e-4f) {
+            b.segmentLag = target.segmentLag;
+            b.sideLag = target.sideLag;
+        }
+        writeBodyLags(b);
+    }
+
+    // Phase sums wrap in uint32; only the coupling pull (well under pi) goes through float.
+    const float ks = params.segmentCoupling;
+    const float kc = params.sideCoupling;
+    const uint32_t *L = phaseL.data(), *R = phaseR.data();
+    const uint32_t *w = drive.data(), *sl = segmentLag.data(), *cl = sideLag.data();
+    const float *fw = frontWeight.data();
+    uint32_t *outL = nextL.data(), *outR = nextR.data();
+    const size_t end = segments + 1;
+    size_t i = 1;
+#if CENTIPEDE_FASTMATH_AVX2
+    {
+        const __m256 vks = _mm256_set1_ps(ks), vkc = _mm256_set1_ps(kc);
+        const __m256 turns = _mm256_set1_ps(static_cast<float>(kTurnsPerRadian));
+        auto load8 = [](const uint32_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); };
+        for (; i + 8 <= end; i += 8) {
+            const __m256i l = load8(L + i), r = load8(R + i);
+            const __m256i lp = load8(L + i - 1), rp = load8(R + i - 1);
+            const __m256i seg = load8(sl + i), cross = load8(cl + i), vw = load8(w + i);
+            const __m256 kseg = _mm256_mul_ps(vks, _mm256_loadu_ps(fw + i));
+            const __m256 sideTerm = _mm256_mul_ps(vkc, fastmath::approx::sinCoarseTurn8(_mm256_sub_epi32(_mm256_sub_epi32(r, cross), l)));
+            const __m256 segL = fastmath::approx::sinCoarseTurn8(_mm256_sub_epi32(_mm256_add_epi32(lp, seg), l));
+            const __m256 segR = fastmath::approx::sinCoarseTurn8(_mm256_sub_epi32(_mm256_add_epi32(rp, seg), r));
+            const __m256 dl = _mm256_add_ps(_mm256_mul_ps(kseg, segL), sideTerm);
+            const __m256 dr = _mm256_sub_ps(_mm256_mul_ps(kseg, segR), sideTerm);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(outL + i),
+                                _mm256_add_epi32(_mm256_add_epi32(l, vw), _mm256_cvtps_epi32(_mm256_mul_ps(dl, turns))));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(outR + i),
+                                _mm256_add_epi32(_mm256_add_epi32(r, vw), _mm256_cvtps_epi32(_mm256_mul_ps(dr, turns))));
+        }
+    }
+#endif
+#if CENTIPEDE_FASTMATH_SSE2
+    const __m128 vks = _mm_set1_ps(ks), vkc = _mm_set1_ps(kc);
+    const __m128 turns = _mm_set1_ps(static_cast<float>(kTurnsPerRadian));
+    auto load4 = [](const uint32_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); };
+    for (; i + 4 <= end; i += 4) {
+        const __m128i l = load4(L + i), r = load4(R + i);
+        const __m128i lp = load4(L + i - 1), rp = load4(R + i - 1);
+        const __m128i seg = load4(sl + i), cross = load4(cl + i), vw = load4(w + i);
+        const __m128 kseg = _mm_mul_ps(vks, _mm_loadu_ps(fw + i));
+        const __m128 sideTerm = _mm_mul_ps(vkc, fastmath::approx::sinCoarseTurn4(_mm_sub_epi32(_mm_sub_epi32(r, cross), l)));
+        const __m128 segL = fastmath::approx::sinCoarseTurn4(_mm_sub_epi32(_mm_add_epi32(lp, seg), l));
+        const __m128 segR = fastmath::approx::sinCoarseTurn4(_mm_sub_epi32(_mm_add_epi32(rp, seg), r));
+        const __m128 dl = _mm_add_ps(_mm_mul_ps(kseg, segL), sideTerm);
+        const __m128 dr = _mm_sub_ps(_mm_mul_ps(kseg, segR), sideTerm);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outL + i), _mm_add_epi32(_mm_add_epi32(l, vw), _mm_cvtps_epi32(_mm_mul_ps(dl, turns))));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outR + i), _mm_add_epi32(_mm_add_epi32(r, vw), _mm_cvtps_epi32(_mm_mul_ps(dr, turns))));
+    }
+#endif
+    for (; i < end; ++i) {
+        const float sideTerm = kc * fastmath::approx::sinCoarseTurn(static_cast<int32_t>(R[i] - cl[i] - L[i]));
+        const float kseg = ks * fw[i];
+        outL[i] = L[i] + w[i] + stepTurns(kseg * fastmath::approx::sinCoarseTurn(static_cast<int32_t>(L[i - 1] + sl[i] - L[i])) + sideTerm);
+        outR[i] = R[i] + w[i] + stepTurns(kseg * fastmath::approx::sinCoarseTurn(static_cast<int32_t>(R[i - 1] + sl[i] - R[i])) - sideTerm);
+    }
+    phaseL.swap(nextL);
+    phaseR.swap(nextR);
+}
+
+float CpgNetwork::phase(uint32_t body, size_t segment, int side) const {
+    const size_t i = bodies[body].begin + 1 + segment;
+    return toRadians(side < 0 ? phaseL[i] : phaseR[i]);
+}
+
+float CpgNetwork::patternError(uint32_t body) const {
+    const Body &b = bodies[body];
+    const uint32_t segLag = toTurns(b.segmentLag), sideLag = toTurns(b.sideLag);
+    float worst = 0.f;
+    for (size_t s = 0; s < b.count; ++s) {
+        const size_t i = b.begin + 1 + s;
+        worst = std::max(worst, std::fabs(toSignedRadians(phaseR[i] - phaseL[i] - sideLag)));
+        if (s > 0) worst = std::max(worst, std::fabs(toSignedRadians(phaseL[i] - phaseL[i - 1] - segLag)));
+    }
+    return worst;
+}
+
+size_t CpgNetwork::bodyCount() const {
+    return static_cast<size_t>(std::count_if(bodies.begin(), bodies.end(), [](const Body &b) { return b.count > 0; }));
+}
+
+void updateGaitCpg(std::vector<Segment> &segments, const CpgNetwork &cpg, uint32_t body,
+                   float lastMoveDx, float lastMoveDy) {
+    const Heading heading = computeHeading(segments, lastMoveDx, lastMoveDy);
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto &seg = segments[i];
+        const SegmentFrame frame = computeSegmentFrame(segments, i, heading);
+
+        for (auto &leg : seg.legs) {
+            stepLeg(leg, cpg.phase(body, i, leg.side), frame, heading, seg.bodyZ);
+        }
+    }
+}
+
+} // namespace gait
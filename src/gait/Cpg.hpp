@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Included from include/Centipede.hpp, so only a forward declaration here.
+struct Segment;
+
+namespace gait {
+
+// Phase relationship a CPG body settles into: `segmentLag` is how far each segment's
+// oscillator runs ahead of the one in front of it, `sideLag` how far the right side
+// runs ahead of the left (radians).
+struct CpgPattern {
+    float segmentLag;
+    float sideLag;
+};
+
+// Slow gait: the fixed metachronal wave (pi/4 per segment, sides in antiphase).
+inline constexpr CpgPattern kCpgWave{0.78539816f, 3.14159265f};
+// Fast gait: near-synchronous bursts along the body, sides slightly offset.
+inline constexpr CpgPattern kCpgGallop{0.26179939f, 0.52359878f};
+
+struct CpgParams {
+    float segmentCoupling = 0.15f;  // per-tick pull toward the segment in front (radians)
+    float sideCoupling = 0.15f;     // per-tick pull toward the opposite side
+    float patternRate = 0.03f;      // per-tick blend of the lags toward the active pattern
+    // Head speed (grid units per tick) above which a body switches to the gallop, and
+    // below which it drops back to the wave; the gap avoids flapping at the threshold.
+    float gallopSpeed = 0.45f;
+    float waveSpeed = 0.30f;
+};
+
+// Coupled phase oscillators (a central pattern generator) for many bodies at once.
+//
+// Every segment of a body has one oscillator per side. Each oscillator runs at its
+// body's drive (radians per tick) and is pulled toward the phase it should have
+// relative to the segment in front of it and to the opposite side:
+//
+//   dL_i = w + ks * sin(L_(i-1) + segLag - L_i) + kc * sin(R_i - sideLag - L_i)
+//   dR_i = w + ks * sin(R_(i-1) + segLag - R_i) - kc * sin(R_i - sideLag - L_i)
+//
+// Phases of all bodies live in two flat SoA arrays (left, right) so `step` runs eight
+// (AVX2) or four (SSE2) segments per lane group; the front segment of each body has zero segment
+// coupling, which is what separates bodies in the flat arrays. Phases are fixed point
+// (the uint32 range is one turn): they wrap for free, and a phase difference read as
+// int32 is already reduced to [-pi, pi) for the coupling sin. Gait changes move the
+// lags smoothly and the coupling carries the phases along, and any perturbation
+// (see `perturb`) decays back to the pattern.
+class CpgNetwork {
+private:
+    struct Body {
+        uint32_t begin, count;  // range in the flat arrays; count 0 = removed
+        float drive;            // phase advance per tick
+        float speed;            // head speed for gait selection
+        float segmentLag, sideLag;
+        bool gallop;
+    };
+
+    CpgParams params;
+    std::vector<Body> bodies;
+    // Flat per-segment arrays, each with one leading pad slot so index i-1 is always
+    // readable; `phaseL[0]` / `phaseR[0]` are never used. Phases, drives and lags are in
+    // turns (2^32 per 2*pi).
+    std::vector<uint32_t> phaseL, phaseR, nextL, nextR;
+    std::vector<uint32_t> drive, segmentLag, sideLag;
+    std::vector<float> frontWeight;
+    size_t segments = 0;
+
+    void writeBodyInputs(const Body &b);
+    void writeBodyLags(const Body &b);
+
+public:
+    explicit CpgNetwork(const CpgParams &params = CpgParams{});
+
+    // Register a body with `segmentCount` segments, starting on the wave pattern with
+    // every oscillator already in place. Returns its id (stable until `clear`).
+    uint32_t addBody(size_t segmentCount);
+    // Drop a body's oscillators; later bodies keep their ids.
+    void removeBody(uint32_t body);
+    void clear();
+
+    // Per-tick input from the owner: phase advance and current head speed.
+    void setDrive(uint32_t body, float phaseAdvance, float headSpeed);
+
+    // Kick both oscillators of a segment by `dPhase` (e.g. the segment was shoved).
+    void perturb(uint32_t body, size_t segment, float dPhase);
+
+    // Advance every body by one tick.
+    void step();
+
+    // Wrapped phase in [0, 2*pi) of a segment's left (side < 0) or right oscillator.
+    float phase(uint32_t body, size_t segment, int side) const;
+
+    bool galloping(uint32_t body) const { return bodies[body].gallop; }
+    // Largest deviation (radians) of a body's phases from its current lags; near zero
+    // once it has recovered from a perturbation.
+    float patternError(uint32_t body) const;
+
+    size_t bodyCount() const;
+    size_t oscillatorCount() const { return segments * 2; }
+};
+
+// Gait update driven by a CPG body instead of `gaitTime + phaseOffset`: same stance /
+// swing handling as `updateGait`, with each leg's phase read from its segment side's
+// oscillator.
+void updateGaitCpg(std::vector<Segment> &segments, const CpgNetwork &cpg, uint32_t body,
+                   float lastMoveDx, float lastMoveDy);
+
+} // namespace gait
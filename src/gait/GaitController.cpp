@@ -1,29 +1,25 @@
 #include "GaitController.hpp"
-#include <cmath>
-#include "GaitController.hpp"
+#include "../math/FastMath.hpp"
+#include "../terrain/Heightfield.hpp"
 #include <cmath>
 #include <algorithm>
 
 namespace gait {
 
-void updateGait(std::vector<Segment> &segments, float gaitTime, float bodyZ, float lastMoveDx, float lastMoveDy) {
-    const float PI = 3.14159265f;
-    const float stanceFrac = 0.55f;
-    const float stanceWidth = kStanceWidth;
-    const float desiredSweepDeg = 150.0f;
-    const float desiredHalfSweep = (desiredSweepDeg * (PI / 180.0f)) * 0.5f;
+static constexpr float PI = 3.14159265f;
 
+Heading computeHeading(const std::vector<Segment> &segments, float lastMoveDx, float lastMoveDy) {
     float baseSpineX = 1.f, baseSpineY = 0.f;
     if (segments.size() >= 2) {
         baseSpineX = segments[1].x - segments[0].x;
         baseSpineY = segments[1].y - segments[0].y;
-        float bl = std::sqrt(baseSpineX * baseSpineX + baseSpineY * baseSpineY);
+        float bl = fastmath::sqrt(baseSpineX * baseSpineX + baseSpineY * baseSpineY);
         if (bl > 1e-4f) { baseSpineX /= bl; baseSpineY /= bl; } else { baseSpineX = 1.f; baseSpineY = 0.f; }
     }
 
     float moveDirX = lastMoveDx;
     float moveDirY = lastMoveDy;
-    float moveMag = std::sqrt(moveDirX * moveDirX + moveDirY * moveDirY);
+    float moveMag = fastmath::sqrt(moveDirX * moveDirX + moveDirY * moveDirY);
     if (moveMag > 1e-4f) {
         moveDirX /= moveMag;
         moveDirY /= moveMag;
@@ -35,109 +31,231 @@ void updateGait(std::vector<Segment> &segments, float gaitTime, float bodyZ, flo
     const float kMoveBias = 0.85f;
     float forwardX = baseSpineX * (1.0f - kMoveBias) + moveDirX * kMoveBias;
     float forwardY = baseSpineY * (1.0f - kMoveBias) + moveDirY * kMoveBias;
-    float forwardLen = std::sqrt(forwardX * forwardX + forwardY * forwardY);
+    float forwardLen = fastmath::sqrt(forwardX * forwardX + forwardY * forwardY);
     if (forwardLen < 1e-4f) { forwardX = 1.f; forwardY = 0.f; forwardLen = 1.f; }
     forwardX /= forwardLen;
     forwardY /= forwardLen;
+    return Heading{forwardX, forwardY};
+}
+
+SegmentFrame computeSegmentFrame(const std::vector<Segment> &segments, size_t i, const Heading &heading) {
+    float spineX = 0.f, spineY = 0.f;
+    if (i < segments.size() - 1) {
+        spineX = segments[i + 1].x - segments[i].x;
+        spineY = segments[i + 1].y - segments[i].y;
+    } else if (i > 0) {
+        spineX = segments[i].x - segments[i - 1].x;
+        spineY = segments[i].y - segments[i - 1].y;
+    } else {
+        spineX = heading.forwardX;
+        spineY = heading.forwardY;
+    }
+    float spineLen = fastmath::sqrt(spineX * spineX + spineY * spineY);
+    if (spineLen < 1e-4f) { spineX = heading.forwardX; spineY = heading.forwardY; spineLen = 1.f; }
+    spineX /= spineLen;
+    spineY /= spineLen;
+
+    SegmentFrame f;
+    f.perpX = -spineY;
+    f.perpY = spineX;
+    f.midX = (i < segments.size() - 1) ? (segments[i].x + segments[i + 1].x) * 0.5f : segments[i].x;
+    f.midY = (i < segments.size() - 1) ? (segments[i].y + segments[i + 1].y) * 0.5f : segments[i].y;
+    return f;
+}
+
+float legPhase(float gaitTime, float phaseOffset) {
+    float phase = std::fmod(gaitTime + phaseOffset, 2.0f * PI);
+    if (phase < 0.f) phase += 2.0f * PI;
+    return phase;
+}
+
+// Horizontal reach of a leg at body height `bodyZ`, split into the outward offset of its
+// rest foot position and the forward offset of its landing target (a 150 degree sweep).
+static void legReach(const Segment::Leg &leg, float bodyZ, float &baseOutR, float &forwardAmp) {
+    const float desiredSweepDeg = 150.0f;
+    const float desiredHalfSweep = (desiredSweepDeg * (PI / 180.0f)) * 0.5f;
+
+    const float L1 = leg.hipLength;
+    const float L2 = leg.kneeLength + leg.footLength;
+    const float maxDist = (L1 + L2) - 0.05f;
+    const float dzAbs = std::fabs(bodyZ);
+    float maxReachR = 0.0f;
+    if (dzAbs < maxDist) {
+        maxReachR = fastmath::sqrt(std::max(0.0f, maxDist * maxDist - dzAbs * dzAbs));
+    }
+    baseOutR = maxReachR * fastmath::cos(desiredHalfSweep);
+    forwardAmp = maxReachR * fastmath::sin(desiredHalfSweep);
+}
+
+float strideLength(const Segment::Leg &leg, float bodyZ) {
+    float baseOutR, forwardAmp;
+    legReach(leg, bodyZ - leg.footHoldZ, baseOutR, forwardAmp);
+    return 2.0f * forwardAmp;
+}
+
+// Ground height at a landing target, through the leg's sample cache (flat plane without
+// an active terrain).
+static float landingHeight(Segment::Leg &leg, float x, float y) {
+    terrain::Heightfield *field = terrain::active();
+    return field ? field->sampleCached(leg.groundCache, x, y).z : 0.f;
+}
+
+void stepLeg(Segment::Leg &leg, float phase, const SegmentFrame &frame, const Heading &heading, float bodyZ) {
+    const float stanceWidth = kStanceWidth;
+
+    const bool wasOnGround = leg.onGround;
+
+    const float stanceEnd = kStanceFrac * 2.0f * PI;
+    const bool inSwing = (phase >= stanceEnd);
+
+    float attachX = frame.midX + frame.perpX * (stanceWidth * static_cast<float>(leg.side));
+    float attachY = frame.midY + frame.perpY * (stanceWidth * static_cast<float>(leg.side));
+
+    float coxaAttachX = attachX + frame.perpX * leg.coxaLength * static_cast<float>(leg.side);
+    float coxaAttachY = attachY + frame.perpY * leg.coxaLength * static_cast<float>(leg.side);
+
+    const float outDirX = frame.perpX * static_cast<float>(leg.side);
+    const float outDirY = frame.perpY * static_cast<float>(leg.side);
+
+    // Reach from the hip's height above the ground the foot stands on.
+    float baseOutR, forwardAmp;
+    legReach(leg, bodyZ - leg.footHoldZ, baseOutR, forwardAmp);
+
+    float restX = coxaAttachX + outDirX * baseOutR;
+    float restY = coxaAttachY + outDirY * baseOutR;
+
+    float landX = restX + heading.forwardX * forwardAmp;
+    float landY = restY + heading.forwardY * forwardAmp;
+
+    {
+        float toTX = landX - coxaAttachX;
+        float toTY = landY - coxaAttachY;
+        float outComp = toTX * outDirX + toTY * outDirY;
+        float minOut = baseOutR * 0.95f;
+        if (outComp < minOut) {
+            float add = (minOut - outComp);
+            landX += outDirX * add;
+            landY += outDirY * add;
+        }
+    }
+
+    // Only a swinging or landing foot needs the ground at its target; planted feet keep theirs.
+    const float landZ = (inSwing || !wasOnGround) ? landingHeight(leg, landX, landY) : leg.footHoldZ;
+
+    if (inSwing) {
+        leg.onGround = false;
+        if (wasOnGround) {
+            leg.swingStartX = leg.footHoldX;
+            leg.swingStartY = leg.footHoldY;
+            leg.swingStartZ = leg.footHoldZ;
+        }
+
+        float swingT = (phase - stanceEnd) / (2.0f * PI - stanceEnd);
+        swingT = std::clamp(swingT, 0.0f, 1.0f);
+        leg.swingPhase = swingT;
+
+        float t = swingT * swingT * (3.0f - 2.0f * swingT);
+        leg.footHoldX = leg.swingStartX + (landX - leg.swingStartX) * t;
+        leg.footHoldY = leg.swingStartY + (landY - leg.swingStartY) * t;
+        leg.footHoldZ = leg.swingStartZ + (landZ - leg.swingStartZ) * t;
+        leg.groundForceX = leg.groundForceY = 0.f;
+    } else {
+        leg.onGround = true;
+        leg.swingPhase = 0.f;
+
+        if (!wasOnGround) {
+            leg.footHoldX = landX;
+            leg.footHoldY = landY;
+            leg.footHoldZ = landZ;
+        }
+
+        // Over the stance the foot should sweep from its landing target back past the
+        // rest position by the same amount. The planted hold's displacement from where
+        // the sweep has got to is how far this leg pushes the body along.
+        const float sweep = forwardAmp * (1.0f - 2.0f * phase / stanceEnd);
+        const float wantX = restX + heading.forwardX * sweep;
+        const float wantY = restY + heading.forwardY * sweep;
+        leg.groundForceX = leg.pushStrength * (leg.footHoldX - wantX);
+        leg.groundForceY = leg.pushStrength * (leg.footHoldY - wantY);
+    }
+}
+
+void updateGait(std::vector<Segment> &segments, float gaitTime, float lastMoveDx, float lastMoveDy) {
+    const Heading heading = computeHeading(segments, lastMoveDx, lastMoveDy);
 
     for (size_t i = 0; i < segments.size(); ++i) {
         auto &seg = segments[i];
+        const SegmentFrame frame = computeSegmentFrame(segments, i, heading);
 
-        float spineX = 0.f, spineY = 0.f;
-        if (i < segments.size() - 1) {
-            spineX = segments[i + 1].x - segments[i].x;
-            spineY = segments[i + 1].y - segments[i].y;
-        } else if (i > 0) {
-            spineX = segments[i].x - segments[i - 1].x;
-            spineY = segments[i].y - segments[i - 1].y;
-        } else {
-            spineX = forwardX;
-            spineY = forwardY;
+        for (auto &leg : seg.legs) {
+            stepLeg(leg, legPhase(gaitTime, leg.phaseOffset), frame, heading, seg.bodyZ);
         }
-        float spineLen = std::sqrt(spineX * spineX + spineY * spineY);
-        if (spineLen < 1e-4f) { spineX = forwardX; spineY = forwardY; spineLen = 1.f; }
-        spineX /= spineLen;
-        spineY /= spineLen;
-        float perpX = -spineY;
-        float perpY = spineX;
+    }
+}
 
-        float midX = (i < segments.size() - 1) ? (segments[i].x + segments[i + 1].x) * 0.5f : segments[i].x;
-        float midY = (i < segments.size() - 1) ? (segments[i].y + segments[i + 1].y) * 0.5f : segments[i].y;
+// Whether a planted hold has left the leg's reach from its hip on `frame`: farther than
+// any landing target can be (kReachSlack over the reach, for targets off the segment's
+// perpendicular), or behind the hip line where no hip yaw points.
+static bool holdOutOfReach(const Segment::Leg &leg, const SegmentFrame &frame, float bodyZ) {
+    constexpr float kReachSlack = 1.25f;
+    const float side = static_cast<float>(leg.side);
+    const float out = (kStanceWidth + leg.coxaLength) * side;
+    const float dx = leg.footHoldX - (frame.midX + frame.perpX * out);
+    const float dy = leg.footHoldY - (frame.midY + frame.perpY * out);
+    if ((dx * frame.perpX + dy * frame.perpY) * side < 0.f) return true;
+    float baseOutR, forwardAmp;
+    legReach(leg, bodyZ - leg.footHoldZ, baseOutR, forwardAmp);
+    return dx * dx + dy * dy > kReachSlack * kReachSlack * (baseOutR * baseOutR + forwardAmp * forwardAmp);
+}
+
+void updateGaitDriven(std::vector<Segment> &segments, float gaitTime, float gaitAdvance, float lastMoveDx, float lastMoveDy) {
+    const Heading heading = computeHeading(segments, lastMoveDx, lastMoveDy);
+    const float stanceEnd = kStanceFrac * 2.0f * PI;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto &seg = segments[i];
+        const SegmentFrame frame = computeSegmentFrame(segments, i, heading);
 
         for (auto &leg : seg.legs) {
-            const bool wasOnGround = leg.onGround;
-
-            float phase = std::fmod(gaitTime + leg.phaseOffset, 2.0f * PI);
-            if (phase < 0.f) phase += 2.0f * PI;
-
-            const float stanceEnd = stanceFrac * 2.0f * PI;
-            const bool inSwing = (phase >= stanceEnd);
-
-            float attachX = midX + perpX * (stanceWidth * static_cast<float>(leg.side));
-            float attachY = midY + perpY * (stanceWidth * static_cast<float>(leg.side));
-
-            float coxaAttachX = attachX + perpX * leg.coxaLength * static_cast<float>(leg.side);
-            float coxaAttachY = attachY + perpY * leg.coxaLength * static_cast<float>(leg.side);
-
-            const float L1 = leg.hipLength;
-            const float L2 = leg.kneeLength + leg.footLength;
-            const float maxDist = (L1 + L2) - 0.05f;
-            const float dzAbs = std::fabs(bodyZ);
-            float maxReachR = 0.0f;
-            if (dzAbs < maxDist) {
-                maxReachR = std::sqrt(std::max(0.0f, maxDist * maxDist - dzAbs * dzAbs));
-            }
-
-            const float outDirX = perpX * static_cast<float>(leg.side);
-            const float outDirY = perpY * static_cast<float>(leg.side);
-
-            const float baseOutR = maxReachR * std::cos(desiredHalfSweep);
-            const float forwardAmp = maxReachR * std::sin(desiredHalfSweep);
-
-            float restX = coxaAttachX + outDirX * baseOutR;
-            float restY = coxaAttachY + outDirY * baseOutR;
-
-            float landX = restX + forwardX * forwardAmp;
-            float landY = restY + forwardY * forwardAmp;
-
-            {
-                float toTX = landX - coxaAttachX;
-                float toTY = landY - coxaAttachY;
-                float outComp = toTX * outDirX + toTY * outDirY;
-                float minOut = baseOutR * 0.95f;
-                if (outComp < minOut) {
-                    float add = (minOut - outComp);
-                    landX += outDirX * add;
-                    landY += outDirY * add;
-                }
-            }
-
-            if (inSwing) {
-                leg.onGround = false;
-                if (wasOnGround) {
-                    leg.swingStartX = leg.footHoldX;
-                    leg.swingStartY = leg.footHoldY;
-                }
-
-                float swingT = (phase - stanceEnd) / (2.0f * PI - stanceEnd);
-                swingT = std::clamp(swingT, 0.0f, 1.0f);
-                leg.swingPhase = swingT;
-
-                float t = swingT * swingT * (3.0f - 2.0f * swingT);
-                leg.footHoldX = leg.swingStartX + (landX - leg.swingStartX) * t;
-                leg.footHoldY = leg.swingStartY + (landY - leg.swingStartY) * t;
-            } else {
-                leg.onGround = true;
-                leg.swingPhase = 0.f;
-
-                if (!wasOnGround) {
-                    leg.footHoldX = landX;
-                    leg.footHoldY = landY;
-                }
-            }
+            leg.phaseLead -= std::min(leg.phaseLead, kPhaseLeadRelax * gaitAdvance);
+            const float phase = legPhase(gaitTime + leg.phaseLead, leg.phaseOffset);
+            stepLeg(leg, phase, frame, heading, seg.bodyZ);
+            if (!leg.onGround || leg.pushStrength <= 0.f) continue;
+
+            // The ground force is pushStrength times the hold's offset from the sweep.
+            const float halfStride = 0.5f * strideLength(leg, seg.bodyZ);
+            const float offX = leg.groundForceX / leg.pushStrength;
+            const float offY = leg.groundForceY / leg.pushStrength;
+            if (offX * offX + offY * offY <= halfStride * halfStride && !holdOutOfReach(leg, frame, seg.bodyZ)) continue;
+            leg.phaseLead = std::fmod(leg.phaseLead + (stanceEnd - phase), 2.0f * PI);
+            stepLeg(leg, stanceEnd, frame, heading, seg.bodyZ);
         }
     }
 }
 
-} // namespace gait
+static void plantLegs(std::vector<Segment> &segments, float lastMoveDx, float lastMoveDy, bool swingingOnly) {
+    const Heading heading = computeHeading(segments, lastMoveDx, lastMoveDy);
 
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const SegmentFrame frame = computeSegmentFrame(segments, i, heading);
+        for (auto &leg : segments[i].legs) {
+            if (swingingOnly && leg.onGround) continue;
+            // Phase 0 after a swing is a touchdown: the foot lands on this frame's target.
+            leg.onGround = false;
+            stepLeg(leg, 0.f, frame, heading, segments[i].bodyZ);
+            leg.swingStartX = leg.footHoldX;
+            leg.swingStartY = leg.footHoldY;
+            leg.swingStartZ = leg.footHoldZ;
+        }
+    }
+}
+
+void replantLegs(std::vector<Segment> &segments, float lastMoveDx, float lastMoveDy) {
+    plantLegs(segments, lastMoveDx, lastMoveDy, false);
+}
+
+void landSwingingLegs(std::vector<Segment> &segments, float lastMoveDx, float lastMoveDy) {
+    plantLegs(segments, lastMoveDx, lastMoveDy, true);
+}
+
+} // namespace gait
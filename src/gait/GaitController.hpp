@@ -3,9 +3,64 @@
 #include "../../include/Centipede.hpp"
 
 namespace gait {
+    // Fraction of the gait cycle a leg spends planted (the rest is swing).
+    inline constexpr float kStanceFrac = 0.55f;
+
+    // Share of the gait advance by which an early-lifted leg's phase lead relaxes per tick.
+    inline constexpr float kPhaseLeadRelax = 0.25f;
+
+    // Travel direction shared by every leg for one tick (unit vector, grid space).
+    struct Heading {
+        float forwardX, forwardY;
+    };
+
+    // Per-segment attachment frame: outward perpendicular and leg-pair midpoint.
+    struct SegmentFrame {
+        float perpX, perpY;
+        float midX, midY;
+    };
+
+    // Blend the head spine direction with the last move delta into a forward heading.
+    Heading computeHeading(const std::vector<Segment> &segments, float lastMoveDx, float lastMoveDy);
+
+    // Spine-perpendicular frame for segment `i` (falls back to `heading` for a single segment).
+    SegmentFrame computeSegmentFrame(const std::vector<Segment> &segments, size_t i, const Heading &heading);
+
+    // Wrapped gait phase of a leg in [0, 2*pi).
+    float legPhase(float gaitTime, float phaseOffset);
+
+    // How far a planted foot sweeps back relative to its hip over one stance at body height
+    // `bodyZ` over the leg's current hold (from the landing target to as far behind the
+    // rest position).
+    float strideLength(const Segment::Leg &leg, float bodyZ);
+
+    // Advance a single leg for this tick given its wrapped `phase`: handles stance/swing
+    // transitions, swing interpolation toward the landing target and touchdown, and the
+    // leg's ground reaction force (see Segment::Leg::groundForceX). Landing targets are
+    // placed on the active terrain (terrain::active()) through the leg's sample cache.
+    void stepLeg(Segment::Leg &leg, float phase, const SegmentFrame &frame, const Heading &heading, float bodyZ);
+
     // Update gait state (swing/stance and foot holds) for all segments.
     // - `gaitTime` is the global phase accumulator (radians).
-    // - `bodyZ` is current body height used to compute reach.
+    // - each leg's reach comes from its segment's body height (Segment::bodyZ).
     // - `lastMoveDx/lastMoveDy` are last applied movement deltas to bias forward direction.
-    void updateGait(std::vector<Segment> &segments, float gaitTime, float bodyZ, float lastMoveDx, float lastMoveDy);
+    // This is the reference O(legs) path; `GaitScheduler` produces the same result
+    // while only touching legs that change state or are swinging.
+    void updateGait(std::vector<Segment> &segments, float gaitTime, float lastMoveDx, float lastMoveDy);
+
+    // Leg-driven gait update: as updateGait, but a planted leg whose hold has fallen more
+    // than half a stride from where its stance sweep should be, or out of the leg's reach
+    // (the body turned or ran ahead of it), lifts into its swing right away instead of
+    // being dragged, and its clock then runs slower by kPhaseLeadRelax of `gaitAdvance`
+    // until it is back in step.
+    void updateGaitDriven(std::vector<Segment> &segments, float gaitTime, float gaitAdvance, float lastMoveDx, float lastMoveDy);
+
+    // Plant every foot at its landing target under the current spine, as if all legs had
+    // just touched down. Used when legs resume after being frozen (stale foot holds);
+    // the next gait update lifts the legs that are due to swing from there.
+    void replantLegs(std::vector<Segment> &segments, float lastMoveDx, float lastMoveDy);
+
+    // Same for the legs currently in swing only: they land on this tick's target (used to
+    // settle the feet when the gait stops; the IK smoothing eases the legs down).
+    void landSwingingLegs(std::vector<Segment> &segments, float lastMoveDx, float lastMoveDy);
 }
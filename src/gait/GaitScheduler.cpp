@@ -0,0 +1,139 @@
+#include "GaitScheduler.hpp"
+#include "GaitController.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace gait {
+
+static constexpr float PI = 3.14159265f;
+
+GaitScheduler::GaitScheduler() : wheel(kSlots) {}
+
+void GaitScheduler::reset() {
+    for (auto &slot : wheel) slot.clear();
+    legs.clear();
+    swingPos.clear();
+    swinging.clear();
+    lastStepTick.clear();
+    initialized = false;
+}
+
+int64_t GaitScheduler::slotOf(float time) const {
+    return static_cast<int64_t>(std::floor(time / kSlotWidth));
+}
+
+void GaitScheduler::setSwinging(uint32_t leg, bool inSwing) {
+    int32_t pos = swingPos[leg];
+    if (inSwing && pos < 0) {
+        swingPos[leg] = static_cast<int32_t>(swinging.size());
+        swinging.push_back(leg);
+    } else if (!inSwing && pos >= 0) {
+        uint32_t moved = swinging.back();
+        swinging[pos] = moved;
+        swingPos[moved] = pos;
+        swinging.pop_back();
+        swingPos[leg] = -1;
+    }
+}
+
+void GaitScheduler::schedule(uint32_t leg, float gaitTime, float phase, bool inSwing) {
+    const float stanceEnd = kStanceFrac * 2.0f * PI;
+    float remaining = inSwing ? (2.0f * PI - phase) : (stanceEnd - phase);
+    // Fire a little early: float rounding in the wrapped phase grows with gait time,
+    // and an early pop is only a cheap re-check whereas a late one would miss a transition.
+    float early = 1e-4f + std::fabs(gaitTime) * 1e-6f;
+    float time = gaitTime + remaining - early;
+    int64_t slot = std::max(slotOf(time), slotOf(gaitTime));
+    wheel[static_cast<size_t>(slot & (kSlots - 1))].push_back(Event{time, leg});
+}
+
+void GaitScheduler::rebuild(std::vector<Segment> &segments, float gaitTime, float lastMoveDx, float lastMoveDy) {
+    reset();
+    for (uint32_t si = 0; si < segments.size(); ++si) {
+        for (uint32_t li = 0; li < segments[si].legs.size(); ++li) legs.push_back(LegRef{si, li});
+    }
+    swingPos.assign(legs.size(), -1);
+    lastStepTick.assign(legs.size(), 0);
+
+    // Full evaluation once (identical to `updateGait`), then only events drive updates.
+    const Heading heading = computeHeading(segments, lastMoveDx, lastMoveDy);
+    for (uint32_t l = 0; l < legs.size(); ++l) {
+        const LegRef ref = legs[l];
+        Segment::Leg &leg = segments[ref.seg].legs[ref.idx];
+        const SegmentFrame frame = computeSegmentFrame(segments, ref.seg, heading);
+        const float phase = legPhase(gaitTime, leg.phaseOffset);
+        stepLeg(leg, phase, frame, heading, segments[ref.seg].bodyZ);
+        setSwinging(l, !leg.onGround);
+        schedule(l, gaitTime, phase, !leg.onGround);
+    }
+
+    this->lastTime = gaitTime;
+    this->lastEvents = legs.size();
+    this->lastStepped = legs.size();
+    this->initialized = true;
+}
+
+void GaitScheduler::update(std::vector<Segment> &segments, float gaitTime, float lastMoveDx, float lastMoveDy) {
+    size_t legCount = 0;
+    for (const auto &seg : segments) legCount += seg.legs.size();
+    if (!initialized || legCount != legs.size() || gaitTime < lastTime) {
+        rebuild(segments, gaitTime, lastMoveDx, lastMoveDy);
+        return;
+    }
+
+    ++tick;
+    lastEvents = 0;
+    lastStepped = 0;
+    const Heading heading = computeHeading(segments, lastMoveDx, lastMoveDy);
+
+    // Pop every event that became due since the last tick. A single tick may advance
+    // gait time by more than a cycle, in which case each slot is visited once.
+    int64_t first = slotOf(lastTime);
+    int64_t last = slotOf(gaitTime);
+    if (last - first >= kSlots) last = first + kSlots - 1;
+    due.clear();
+    for (int64_t s = first; s <= last; ++s) {
+        auto &slot = wheel[static_cast<size_t>(s & (kSlots - 1))];
+        for (size_t e = 0; e < slot.size();) {
+            if (slot[e].time <= gaitTime) {
+                due.push_back(slot[e].leg);
+                slot[e] = slot.back();
+                slot.pop_back();
+            } else {
+                ++e;
+            }
+        }
+    }
+
+    // Re-evaluate legs whose state may have changed and queue their next event.
+    for (uint32_t l : due) {
+        const LegRef ref = legs[l];
+        Segment::Leg &leg = segments[ref.seg].legs[ref.idx];
+        const SegmentFrame frame = computeSegmentFrame(segments, ref.seg, heading);
+        const float phase = legPhase(gaitTime, leg.phaseOffset);
+        stepLeg(leg, phase, frame, heading, segments[ref.seg].bodyZ);
+        setSwinging(l, !leg.onGround);
+        schedule(l, gaitTime, phase, !leg.onGround);
+        lastStepTick[l] = tick;
+    }
+    lastEvents = due.size();
+    lastStepped = due.size();
+
+    // Interpolate the remaining swinging legs. Walk backwards so a (rounding-induced)
+    // early touchdown can be swap-removed without skipping an entry.
+    for (size_t k = swinging.size(); k-- > 0;) {
+        uint32_t l = swinging[k];
+        if (lastStepTick[l] == tick) continue;
+        const LegRef ref = legs[l];
+        Segment::Leg &leg = segments[ref.seg].legs[ref.idx];
+        const SegmentFrame frame = computeSegmentFrame(segments, ref.seg, heading);
+        stepLeg(leg, legPhase(gaitTime, leg.phaseOffset), frame, heading, segments[ref.seg].bodyZ);
+        lastStepTick[l] = tick;
+        ++lastStepped;
+        if (leg.onGround) setSwinging(l, false);
+    }
+
+    this->lastTime = gaitTime;
+}
+
+} // namespace gait
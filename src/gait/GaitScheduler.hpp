@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Included from include/Centipede.hpp, so only a forward declaration here.
+struct Segment;
+
+namespace gait {
+
+// Event-driven replacement for `updateGait`.
+//
+// A leg only changes state at two instants of its cycle: swing-start (phase reaches
+// the end of stance) and touchdown (phase wraps to 0). Those instants are known in
+// gait-time units from the leg's phase offset, so each leg keeps exactly one pending
+// event in a hashed timer wheel keyed by gait time. Per tick we pop the events that
+// became due, re-evaluate just those legs, and interpolate the legs that are currently
+// swinging. Planted legs between events are never touched.
+//
+// The output matches `updateGait` tick for tick: due legs are re-classified with the
+// same wrapped phase (so a tick that skips a whole cycle behaves identically), and
+// events are scheduled slightly early so rounding can only cause a harmless re-check.
+class GaitScheduler {
+private:
+    struct Event {
+        float time;    // absolute gait time at which the leg's state may change
+        uint32_t leg;  // flat leg index
+    };
+    struct LegRef {
+        uint32_t seg;
+        uint32_t idx;
+    };
+
+    // Wheel geometry: kSlots * kSlotWidth must cover a full gait cycle (2*pi).
+    static constexpr int kSlots = 64;
+    static constexpr float kSlotWidth = 0.125f;
+
+    std::vector<std::vector<Event>> wheel;
+    std::vector<LegRef> legs;             // flat index -> (segment, leg)
+    std::vector<int32_t> swingPos;        // flat index -> position in `swinging` or -1
+    std::vector<uint32_t> swinging;       // dense list of legs currently in swing
+    std::vector<uint32_t> lastStepTick;   // flat index -> tick on which it was last stepped
+    std::vector<uint32_t> due;            // scratch buffer for popped legs
+    uint32_t tick = 0;
+    float lastTime = 0.f;
+    bool initialized = false;
+
+    // Counters for the last update (useful to verify cost ~ swinging legs).
+    size_t lastEvents = 0;
+    size_t lastStepped = 0;
+
+    void rebuild(std::vector<Segment> &segments, float gaitTime, float lastMoveDx, float lastMoveDy);
+    void schedule(uint32_t leg, float gaitTime, float phase, bool inSwing);
+    void setSwinging(uint32_t leg, bool inSwing);
+    int64_t slotOf(float time) const;
+
+public:
+    GaitScheduler();
+
+    // Same contract as `gait::updateGait`. Rebuilds itself when the leg layout changes
+    // or gait time runs backwards.
+    void update(std::vector<Segment> &segments, float gaitTime, float lastMoveDx, float lastMoveDy);
+
+    // Drop all scheduled state; the next update re-evaluates every leg.
+    void reset();
+
+    size_t swingingCount() const { return swinging.size(); }
+    size_t eventsLastTick() const { return lastEvents; }
+    size_t legsSteppedLastTick() const { return lastStepped; }
+};
+
+} // namespace gait
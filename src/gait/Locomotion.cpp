@@ -0,0 +1,66 @@
+#include "Locomotion.hpp"
+#include "../../include/Centipede.hpp"
+#include "../math/FastMath.hpp"
+
+namespace gait {
+
+void accumulateGroundForces(const std::vector<Segment> &segments, GroundForces &out) {
+    // Gather: flat leg arrays, swing legs zeroed so the sums below need no branches.
+    size_t legs = 0;
+    for (const auto &seg : segments) legs += seg.legs.size();
+    out.legX.resize(legs); out.legY.resize(legs); out.legWeight.resize(legs);
+    size_t l = 0;
+    bool uniformPairs = true;
+    for (const auto &seg : segments) {
+        uniformPairs = uniformPairs && seg.legs.size() == 2;
+        for (const auto &leg : seg.legs) {
+            const float planted = leg.onGround ? 1.f : 0.f;
+            out.legX[l] = leg.groundForceX * planted;
+            out.legY[l] = leg.groundForceY * planted;
+            out.legWeight[l] = leg.pushStrength * planted;
+            l++;
+        }
+    }
+
+    const size_t n = segments.size();
+    out.segX.resize(n); out.segY.resize(n); out.segWeight.resize(n);
+    size_t s = 0;
+    if (uniformPairs) {
+        // One leg per side: sum adjacent pairs, four segments per lane group.
+        const float *fx = out.legX.data(), *fy = out.legY.data(), *fw = out.legWeight.data();
+#if CENTIPEDE_FASTMATH_SSE2
+        auto pairSums = [](const float *p) {
+            const __m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4);
+            return _mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        };
+        for (; s + 4 <= n; s += 4) {
+            _mm_storeu_ps(out.segX.data() + s, pairSums(fx + 2 * s));
+            _mm_storeu_ps(out.segY.data() + s, pairSums(fy + 2 * s));
+            _mm_storeu_ps(out.segWeight.data() + s, pairSums(fw + 2 * s));
+        }
+#endif
+        for (; s < n; ++s) {
+            out.segX[s] = fx[2 * s] + fx[2 * s + 1];
+            out.segY[s] = fy[2 * s] + fy[2 * s + 1];
+            out.segWeight[s] = fw[2 * s] + fw[2 * s + 1];
+        }
+    } else {
+        l = 0;
+        for (; s < n; ++s) {
+            float x = 0.f, y = 0.f, w = 0.f;
+            for (size_t k = 0; k < segments[s].legs.size(); ++k, ++l) {
+                x += out.legX[l]; y += out.legY[l]; w += out.legWeight[l];
+            }
+            out.segX[s] = x; out.segY[s] = y; out.segWeight[s] = w;
+        }
+    }
+
+    out.totalX = out.totalY = out.totalWeight = 0.f;
+    for (size_t i = 0; i < n; ++i) {
+        out.totalX += out.segX[i];
+        out.totalY += out.segY[i];
+        out.totalWeight += out.segWeight[i];
+    }
+}
+
+} // namespace gait
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Included from include/Centipede.hpp, so only a forward declaration here.
+struct Segment;
+
+namespace gait {
+
+// What moves the body: input moves the head directly and the legs keep up (Kinematic),
+// or input only sets the walking direction and speed, the gait sweeps the planted feet
+// back at that speed, and their ground reaction forces move the body (LegDriven).
+enum class Locomotion { Kinematic, LegDriven };
+
+// Ground reaction forces of every leg for one tick. Gathered into flat per-leg arrays
+// (segment-major; swing legs contribute zero force and weight) and summed per segment
+// and over the body in a vectorized pass.
+struct GroundForces {
+    std::vector<float> legX, legY, legWeight;  // force and pushStrength while planted
+    std::vector<float> segX, segY, segWeight;  // per-segment sums
+    float totalX = 0.f, totalY = 0.f, totalWeight = 0.f;
+};
+
+void accumulateGroundForces(const std::vector<Segment> &segments, GroundForces &out);
+
+// World-space travel of the planted feet over one tick, for legs planted on both ticks.
+// Zero for feet that stay exactly where they were put down.
+struct FootSlip {
+    float mean = 0.f;
+    float max = 0.f;
+    size_t planted = 0;
+};
+
+} // namespace gait
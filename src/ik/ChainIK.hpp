@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ik {
+
+// Upper bound on links per leg chain (morph::LegChain; fixed-size, no allocation per solve).
+inline constexpr int kMaxChainLinks = 8;
+
+struct ChainSolveParams {
+    int maxIterations = 6;    // hard cap per solve
+    float tolerance = 0.01f;  // end-effector distance (grid units) that counts as converged
+};
+
+// Iteration statistics, accumulated across solves until reset (typically per frame).
+// A solve ends in one of three ways: the target is reached within tolerance, the chain
+// settles against its joint limits (a sweep moves the end effector by less than a tenth
+// of the tolerance; the target is out of the limited workspace), or it hits the cap.
+struct ChainStats {
+    size_t solves = 0;
+    size_t iterations = 0;
+    size_t reached = 0;
+    size_t settled = 0;
+    size_t hitCap = 0;
+    int maxIterations = 0;
+
+    void reset() { *this = ChainStats{}; }
+    float meanIterations() const { return solves > 0 ? static_cast<float>(iterations) / static_cast<float>(solves) : 0.f; }
+};
+
+} // namespace ik
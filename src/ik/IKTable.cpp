@@ -0,0 +1,177 @@
+#include "IKTable.hpp"
+#include "LegIK.hpp"
+#include <cmath>
+#include <algorithm>
+#include <memory>
+
+namespace ik {
+
+// Upper bound on table size per morphology; refinement stops here and the remaining
+// out-of-bound cells fall back to the analytic solve.
+static constexpr size_t kMaxEntries = size_t(1) << 20;
+static constexpr float kInitialCell = 0.25f;
+// Refinement stops once at most 1/kBadCellRatio of the cells need the fallback.
+static constexpr size_t kBadCellRatio = 200;
+// Probe lattice per cell (kProbeSteps + 1 points per side: the centre and the edge
+// midpoints) and the share of the bound the probes may use up.
+static constexpr int kProbeSteps = 2;
+static constexpr float kProbeMargin = 0.5f;
+
+static void analyticAngles(float L1, float L2, float r, float dz, float &hipPitch, float &knee) {
+    solvePlanar(L1, L2, clampReachR(L1, L2, r, dz), dz, hipPitch, knee);
+}
+
+IKTable::IKTable(float L1, float L2, float errorBound)
+    : L1(L1), L2(L2), bound(errorBound), measuredMaxErr(0.f), rMin(0.f), dzMin(kTableDzMin),
+      h(kInitialCell), invH(1.f / kInitialCell), nR(0), nZ(0), badCells(0) {
+    float cell = kInitialCell;
+    for (;;) {
+        fill(cell);
+        // Halving the cell roughly quadruples the entry count.
+        const bool last = entries.size() * 4 > kMaxEntries;
+        const size_t cells = static_cast<size_t>(nR - 1) * static_cast<size_t>(nZ - 1);
+        if (classifyCells(last ? cells : cells / kBadCellRatio) || last) break;
+        cell *= 0.5f;
+    }
+}
+
+void IKTable::fill(float cell) {
+    h = cell;
+    invH = 1.f / cell;
+    const float rMax = L1 + L2;
+    nR = static_cast<int>(std::ceil((rMax - rMin) * invH)) + 1;
+    nZ = static_cast<int>(std::ceil((kTableDzMax - dzMin) * invH)) + 1;
+    entries.assign(static_cast<size_t>(nR) * static_cast<size_t>(nZ), Entry{0.f, 0.f});
+    for (int iz = 0; iz < nZ; ++iz) {
+        const float dz = dzMin + static_cast<float>(iz) * h;
+        for (int ir = 0; ir < nR; ++ir) {
+            const float r = rMin + static_cast<float>(ir) * h;
+            Entry &e = entries[static_cast<size_t>(iz) * nR + ir];
+            analyticAngles(L1, L2, r, dz, e.hipPitch, e.knee);
+        }
+    }
+}
+
+bool IKTable::classifyCells(size_t maxBad) {
+    // Probe a lattice over each cell, edges included: bilinear error peaks inside the cell
+    // in smooth regions, but a clamp kink clipping a corner of the cell shows up first along
+    // its edges. Between probes the error can still rise, so a cell only counts as within
+    // the bound with kProbeMargin to spare. Stops early (false) past `maxBad` bad cells.
+    cellOk.assign(static_cast<size_t>(nR - 1) * static_cast<size_t>(nZ - 1), 0);
+    badCells = 0;
+    measuredMaxErr = 0.f;
+    for (int iz = 0; iz + 1 < nZ; ++iz) {
+        for (int ir = 0; ir + 1 < nR; ++ir) {
+            float worst = 0.f;
+            for (int pz = 0; pz <= kProbeSteps; ++pz) {
+                for (int pr = 0; pr <= kProbeSteps; ++pr) {
+                    // Corners are table entries: no error there.
+                    if ((pr == 0 || pr == kProbeSteps) && (pz == 0 || pz == kProbeSteps)) continue;
+                    const float tr = static_cast<float>(pr) / static_cast<float>(kProbeSteps);
+                    const float tz = static_cast<float>(pz) / static_cast<float>(kProbeSteps);
+                    const float r = rMin + (static_cast<float>(ir) + tr) * h;
+                    const float dz = dzMin + (static_cast<float>(iz) + tz) * h;
+                    float tp, tk, ap, ak;
+                    interpolate(ir, iz, tr, tz, tp, tk);
+                    analyticAngles(L1, L2, r, dz, ap, ak);
+                    worst = std::max(worst, std::max(std::fabs(tp - ap), std::fabs(tk - ak)));
+                }
+            }
+            const bool ok = worst <= kProbeMargin * bound;
+            cellOk[static_cast<size_t>(iz) * (nR - 1) + ir] = ok ? 1 : 0;
+            if (ok) measuredMaxErr = std::max(measuredMaxErr, worst);
+            else if (++badCells > maxBad) return false;
+        }
+    }
+    return true;
+}
+
+void IKTable::interpolate(int ir, int iz, float tr, float tz, float &hipPitch, float &knee) const {
+    const Entry &e00 = entries[static_cast<size_t>(iz) * nR + ir];
+    const Entry &e10 = entries[static_cast<size_t>(iz) * nR + ir + 1];
+    const Entry &e01 = entries[static_cast<size_t>(iz + 1) * nR + ir];
+    const Entry &e11 = entries[static_cast<size_t>(iz + 1) * nR + ir + 1];
+
+    const float p0 = e00.hipPitch + (e10.hipPitch - e00.hipPitch) * tr;
+    const float p1 = e01.hipPitch + (e11.hipPitch - e01.hipPitch) * tr;
+    const float k0 = e00.knee + (e10.knee - e00.knee) * tr;
+    const float k1 = e01.knee + (e11.knee - e01.knee) * tr;
+    hipPitch = p0 + (p1 - p0) * tz;
+    knee = k0 + (k1 - k0) * tz;
+}
+
+bool IKTable::lookup(float r, float dz, float &hipPitch, float &knee) const {
+    const float fr = (r - rMin) * invH;
+    const float fz = (dz - dzMin) * invH;
+    if (!(fr >= 0.f && fz >= 0.f && fr <= static_cast<float>(nR - 1) && fz <= static_cast<float>(nZ - 1))) return false;
+
+    const int ir = std::min(static_cast<int>(fr), nR - 2);
+    const int iz = std::min(static_cast<int>(fz), nZ - 2);
+    if (!cellOk[static_cast<size_t>(iz) * (nR - 1) + ir]) return false;
+    interpolate(ir, iz, fr - static_cast<float>(ir), fz - static_cast<float>(iz), hipPitch, knee);
+    return true;
+}
+
+TableAccuracy IKTable::measureAccuracy(int samplesPerAxis) const {
+    TableAccuracy acc{0.f, 0.f, 0.f, 0.f, 0, 0};
+    const int n = std::max(1, samplesPerAxis);
+    const float rSpan = static_cast<float>(nR - 1) * h;
+    const float zSpan = static_cast<float>(nZ - 1) * h;
+    double sumP = 0.0, sumK = 0.0;
+    for (int b = 0; b < n; ++b) {
+        for (int a = 0; a < n; ++a) {
+            // Irrational offsets keep samples off the grid nodes.
+            const float u = (static_cast<float>(a) + 0.381966f) / static_cast<float>(n);
+            const float v = (static_cast<float>(b) + 0.618034f) / static_cast<float>(n);
+            const float r = rMin + u * rSpan;
+            const float dz = dzMin + v * zSpan;
+            float tp, tk, ap, ak;
+            analyticAngles(L1, L2, r, dz, ap, ak);
+            if (!lookup(r, dz, tp, tk)) { tp = ap; tk = ak; acc.fallbackSamples++; }
+            const float ep = std::fabs(tp - ap);
+            const float ek = std::fabs(tk - ak);
+            acc.maxHipPitchErr = std::max(acc.maxHipPitchErr, ep);
+            acc.maxKneeErr = std::max(acc.maxKneeErr, ek);
+            sumP += ep;
+            sumK += ek;
+            acc.samples++;
+        }
+    }
+    if (acc.samples > 0) {
+        acc.meanHipPitchErr = static_cast<float>(sumP / acc.samples);
+        acc.meanKneeErr = static_cast<float>(sumK / acc.samples);
+    }
+    return acc;
+}
+
+// Tables are shared per morphology; link lengths come from a handful of archetypes.
+// Off by default: the analytic solve stays the leg solver until a caller opts in.
+static bool s_tablesEnabled = false;
+static float s_tableErrorBound = kDefaultTableErrorBound;
+static std::vector<std::unique_ptr<IKTable>> s_tables;
+
+void setTabulatedIK(bool enabled, float errorBound) {
+    // Rebuild at the new bound in place, so references from `tableFor` stay valid.
+    if (errorBound != s_tableErrorBound) {
+        for (auto &t : s_tables) *t = IKTable(t->link1(), t->link2(), errorBound);
+    }
+    s_tablesEnabled = enabled;
+    s_tableErrorBound = errorBound;
+}
+
+bool tabulatedIKEnabled() { return s_tablesEnabled; }
+
+const IKTable &tableFor(float L1, float L2) {
+    for (const auto &t : s_tables) {
+        if (t->link1() == L1 && t->link2() == L2) return *t;
+    }
+    s_tables.push_back(std::make_unique<IKTable>(L1, L2, s_tableErrorBound));
+    return *s_tables.back();
+}
+
+bool lookupTabulated(float L1, float L2, float r, float dz, float &hipPitch, float &knee) {
+    if (!s_tablesEnabled) return false;
+    return tableFor(L1, L2).lookup(r, dz, hipPitch, knee);
+}
+
+} // namespace ik
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ik {
+
+// Max absolute angle error (radians) a table may have against the closed-form solve.
+inline constexpr float kDefaultTableErrorBound = 2e-3f;
+
+// Vertical offset range covered by a table (grid units, negative = foot below hip).
+// Body height is clamped to [0.15, 2.0]; the range stops short of dz = 0 because the
+// solve is singular at the hip itself (r = dz = 0), where no grid can meet the bound.
+inline constexpr float kTableDzMin = -2.25f;
+inline constexpr float kTableDzMax = -0.10f;
+
+// Accuracy of a table against `solvePlanar`, sampled off-grid. Samples that land in
+// cells deferred to the analytic solve are counted in `fallbackSamples` (zero error).
+struct TableAccuracy {
+    float maxHipPitchErr, maxKneeErr;
+    float meanHipPitchErr, meanKneeErr;
+    int samples;
+    int fallbackSamples;
+};
+
+// Precomputed workspace lookup for one leg morphology (link lengths L1, L2).
+// Entries sit on a regular (r, dz) grid and hold the reach-clamped, limit-clamped hip
+// pitch and knee angles; queries are bilinearly interpolated. At build time every cell
+// is probed against the analytic solve and the grid is refined until almost all cells
+// are within half the error bound at the probes, which leaves room for the error between
+// them. The few that never are (the limit and reach clamps put kinks in the angle field)
+// are flagged, and lookups there defer to the analytic solve, so the bound holds
+// everywhere the table answers.
+class IKTable {
+private:
+    struct Entry {
+        float hipPitch, knee;
+    };
+
+    float L1, L2;
+    float bound;
+    float measuredMaxErr;
+    float rMin, dzMin;
+    float h, invH;
+    int nR, nZ;
+    std::vector<Entry> entries;   // row-major: entries[iz * nR + ir]
+    std::vector<uint8_t> cellOk;  // per cell (nR-1 x nZ-1): 1 if within bound
+    size_t badCells;
+
+    void fill(float cell);
+    bool classifyCells(size_t maxBad);
+    void interpolate(int ir, int iz, float tr, float tz, float &hipPitch, float &knee) const;
+
+public:
+    IKTable(float L1, float L2, float errorBound = kDefaultTableErrorBound);
+
+    // Interpolated hip pitch / knee for horizontal reach `r` and vertical offset `dz`.
+    // Returns false outside the table domain (caller falls back to the analytic solve).
+    bool lookup(float r, float dz, float &hipPitch, float &knee) const;
+
+    // Compare against the analytic solver on a `samplesPerAxis`^2 off-grid pattern.
+    TableAccuracy measureAccuracy(int samplesPerAxis) const;
+
+    float link1() const { return L1; }
+    float link2() const { return L2; }
+    float errorBound() const { return bound; }
+    // Worst probed error over the cells the table answers for (<= errorBound() / 2).
+    float maxProbedError() const { return measuredMaxErr; }
+    float cellSize() const { return h; }
+    size_t entryCount() const { return entries.size(); }
+    size_t fallbackCellCount() const { return badCells; }
+};
+
+// Toggle table lookups inside `ik::solveLeg` (off by default). Changing the bound
+// rebuilds the cached tables in place; references from `tableFor` stay valid.
+void setTabulatedIK(bool enabled, float errorBound = kDefaultTableErrorBound);
+bool tabulatedIKEnabled();
+
+// Shared table for a morphology, built on first use with the current error bound
+// (enable tables before the first tick, or call this at startup, to keep the build out
+// of the game loop).
+const IKTable &tableFor(float L1, float L2);
+
+// Table lookup used by `solveLeg`; false when disabled or out of domain.
+bool lookupTabulated(float L1, float L2, float r, float dz, float &hipPitch, float &knee);
+
+} // namespace ik
@@ -1,34 +1,78 @@
 #include "LegIK.hpp"
+#include "IKTable.hpp"
+#include "../math/FastMath.hpp"
+#include "../morph/Morphology.hpp"
 #include <cmath>
 #include <algorithm>
 
 namespace ik {
 
-static float wrapAngle(float a) {
-    const float PI = 3.14159265f;
-    while (a > PI) a -= 2.0f * PI;
-    while (a < -PI) a += 2.0f * PI;
-    return a;
+static LegSolver s_legSolver = LegSolver::Analytic;
+static ChainSolveParams s_chainParams;
+static ChainStats s_chainStats;
+
+void setLegSolver(LegSolver solver) { s_legSolver = solver; }
+LegSolver legSolver() { return s_legSolver; }
+void setChainSolveParams(const ChainSolveParams &params) { s_chainParams = params; }
+ChainStats &chainStats() { return s_chainStats; }
+
+// Hip pitch / knee / ankle via the iterative chain solver on the leg's real links
+// (compile-time chain of the morphology's link count, so the CCD sweep and FK are unrolled).
+template <int NumLinks>
+static void solveLegChain(Segment::Leg &leg, float r, float dz, float &hipPitch, float &knee, float &ankle) {
+    static_assert(NumLinks == 3, "Segment::Leg stores exactly hip/knee/foot links");
+    morph::LegChain<NumLinks> chain;
+    chain.length = {leg.hipLength, leg.kneeLength, leg.footLength};
+    chain.minAngle = {kHipPitchMin, kKneeMin, kAnkleMin};
+    chain.maxAngle = {kHipPitchMax, kKneeMax, kAnkleMax};
+
+    // Warm start from the previous frame's (unsmoothed) solution; solveCCD re-targets it to the moved hold.
+    typename morph::LegChain<NumLinks>::Angles angles = {leg.targetKneeAngle, leg.targetFootAngle, leg.targetAnkleAngle};
+    chain.solveCCD(r, dz, angles, s_chainParams, &s_chainStats);
+    hipPitch = angles[0];
+    knee = angles[1];
+    ankle = angles[2];
 }
 
-void solveLeg(Segment::Leg &leg, float coxaAttachX, float coxaAttachY, float bodyZ, float yawRef) {
-    const float targetZ = 0.0f;
+float clampReachR(float L1, float L2, float r, float dz) {
+    const float dist = fastmath::sqrt(r * r + dz * dz);
+    const float maxDist = (L1 + L2) - 0.05f;
+    const float minDist = std::fabs(L1 - L2) + 0.05f;
+    const float clampedDist = std::clamp(dist, minDist, maxDist);
+    if (dist > 1e-4f && std::fabs(clampedDist - dist) > 1e-5f) {
+        return fastmath::sqrt(std::max(0.0f, clampedDist * clampedDist - dz * dz));
+    }
+    return r;
+}
+
+void solvePlanar(float L1, float L2, float r, float dz, float &hipPitch, float &knee) {
+    float cosKnee = (r * r + dz * dz - L1 * L1 - L2 * L2) / (2.0f * L1 * L2);
+    cosKnee = std::clamp(cosKnee, -0.999f, 0.999f);
+    // Choose the "elbow-down" solution (knee bends toward ground): use a signed knee angle.
+    knee = -fastmath::acos(cosKnee);
+
+    hipPitch = fastmath::atan2(dz, r) - fastmath::atan2(L2 * fastmath::sin(knee), L1 + L2 * fastmath::cos(knee));
+
+    // Enforce hard joint limits.
+    hipPitch = std::clamp(hipPitch, kHipPitchMin, kHipPitchMax);
+    knee = std::clamp(knee, kKneeMin, kKneeMax);
+}
+
+template <int NumLinks>
+void solveLeg(Segment::Leg &leg, float coxaAttachX, float coxaAttachY, float bodyZ, math::Rot2 yawRef) {
+    const float targetZ = leg.footHoldZ; // ground height at the hold
     const float dz = targetZ - bodyZ; // negative => down
 
     float dx = leg.footHoldX - coxaAttachX;
     float dy = leg.footHoldY - coxaAttachY;
-    float r = std::sqrt(dx * dx + dy * dy);
-    float dist = std::sqrt(r * r + dz * dz);
+    float r = fastmath::sqrt(dx * dx + dy * dy);
 
     const float L1 = leg.hipLength;
     const float L2 = leg.kneeLength + leg.footLength;
 
-    const float maxDist = (L1 + L2) - 0.05f;
-    const float minDist = std::fabs(L1 - L2) + 0.05f;
-    float clampedDist = std::clamp(dist, minDist, maxDist);
-
-    if (dist > 1e-4f && std::fabs(clampedDist - dist) > 1e-5f) {
-        float desiredR = std::sqrt(std::max(0.0f, clampedDist * clampedDist - dz * dz));
+    // Pull the target back inside the reachable shell (scales the horizontal offset only).
+    float desiredR = clampReachR(L1, L2, r, dz);
+    if (desiredR != r) {
         float scale = (r > 1e-4f) ? (desiredR / r) : 0.0f;
         dx *= scale;
         dy *= scale;
@@ -40,39 +84,76 @@ void solveLeg(Segment::Leg &leg, float coxaAttachX, float coxaAttachY, float bod
         }
 
         r = desiredR;
-        dist = clampedDist;
     }
 
-    float yaw = (r > 1e-6f) ? std::atan2(dy, dx) : leg.hipAngle;
+    // Horizontal leg direction; keep the previous yaw when the foot is right under the hip.
+    math::Rot2 yaw = (r > 1e-6f) ? math::Rot2::fromVector(dx, dy, leg.hipYaw) : leg.hipYaw;
 
-    float cosKnee = (r * r + dz * dz - L1 * L1 - L2 * L2) / (2.0f * L1 * L2);
-    cosKnee = std::clamp(cosKnee, -0.999f, 0.999f);
-    // Choose the "elbow-down" solution (knee bends toward ground): use a signed knee angle.
-    float knee = -std::acos(cosKnee);
-
-    float hipPitch = std::atan2(dz, r) - std::atan2(L2 * std::sin(knee), L1 + L2 * std::cos(knee));
-
-    // Enforce hard joint limits.
-    hipPitch = std::clamp(hipPitch, kHipPitchMin, kHipPitchMax);
-    knee = std::clamp(knee, kKneeMin, kKneeMax);
+    // Pitch/knee from the chain solver, or from the per-morphology workspace table when
+    // enabled, else closed form (the latter two keep the ankle straight).
+    float hipPitch = 0.f, knee = 0.f, ankle = 0.f;
+    if (s_legSolver == LegSolver::Chain) {
+        solveLegChain<NumLinks>(leg, r, dz, hipPitch, knee, ankle);
+    } else if (!lookupTabulated(L1, L2, r, dz, hipPitch, knee)) {
+        solvePlanar(L1, L2, r, dz, hipPitch, knee);
+    }
 
     // Hard yaw clamp around the provided reference direction (horizontal plane).
-    float yawDelta = wrapAngle(yaw - yawRef);
-    yawDelta = std::clamp(yawDelta, -kHipYawMaxDelta, kHipYawMaxDelta);
-    yaw = wrapAngle(yawRef + yawDelta);
-
-    // Smooth angles with wrap-aware delta so we never jump across ±pi.
-    float dyaw = wrapAngle(yaw - leg.hipAngle);
-    leg.hipAngle = wrapAngle(leg.hipAngle + dyaw * 0.20f);
-    leg.kneeAngle += (hipPitch - leg.kneeAngle) * 0.20f;
-    leg.footAngle += (knee - leg.footAngle) * 0.20f;
+    yaw = math::clampAround(yawRef, yaw, kHipYawLimit);
+
+    leg.targetHipYaw = yaw;
+    leg.targetKneeAngle = hipPitch;
+    leg.targetFootAngle = knee;
+    leg.targetAnkleAngle = ankle;
+
+    // Smooth toward the targets; yaw uses a normalized lerp so it never jumps across ±pi.
+    float dyaw = leg.hipYaw.cross(yaw);           // sin of the remaining yaw step
+    bool yawAhead = leg.hipYaw.dot(yaw) > 0.f;    // excludes the (sin ≈ 0) opposite case
+    float dpitch = hipPitch - leg.kneeAngle;
+    float dknee = knee - leg.footAngle;
+    float dankle = ankle - leg.ankleAngle;
+    leg.hipYaw = math::nlerp(leg.hipYaw, yaw, 0.20f);
+    leg.kneeAngle += dpitch * 0.20f;
+    leg.footAngle += dknee * 0.20f;
+    leg.ankleAngle += dankle * 0.20f;
+
+    // Converged once every remaining step toward the target is below the lazy epsilon.
+    const float kConvergedEps = kLazyInputEps;
+    leg.ikConverged = yawAhead && std::fabs(dyaw) < kConvergedEps && std::fabs(dpitch) < kConvergedEps &&
+                      std::fabs(dknee) < kConvergedEps && std::fabs(dankle) < kConvergedEps;
 
     // Clamp state too (so smoothing can never overshoot past limits).
-    float stateYawDelta = wrapAngle(leg.hipAngle - yawRef);
-    stateYawDelta = std::clamp(stateYawDelta, -kHipYawMaxDelta, kHipYawMaxDelta);
-    leg.hipAngle = wrapAngle(yawRef + stateYawDelta);
+    leg.hipYaw = math::clampAround(yawRef, leg.hipYaw, kHipYawLimit);
     leg.kneeAngle = std::clamp(leg.kneeAngle, kHipPitchMin, kHipPitchMax);
     leg.footAngle = std::clamp(leg.footAngle, kKneeMin, kKneeMax);
+    leg.ankleAngle = std::clamp(leg.ankleAngle, kAnkleMin, kAnkleMax);
+}
+
+template <int NumLinks>
+bool solveLegLazy(Segment::Leg &leg, float coxaAttachX, float coxaAttachY, float bodyZ, math::Rot2 yawRef) {
+    const float eps = kLazyInputEps;
+    if (leg.ikConverged &&
+        std::fabs(leg.footHoldX - leg.ikFootX) < eps && std::fabs(leg.footHoldY - leg.ikFootY) < eps &&
+        std::fabs(coxaAttachX - leg.ikAttachX) < eps && std::fabs(coxaAttachY - leg.ikAttachY) < eps &&
+        std::fabs(bodyZ - leg.ikBodyZ) < eps && std::fabs(yawRef.cross(leg.ikYawRef)) < eps && yawRef.dot(leg.ikYawRef) > 0.f) {
+        return false;
+    }
+
+    solveLeg<NumLinks>(leg, coxaAttachX, coxaAttachY, bodyZ, yawRef);
+
+    // Record inputs after the solve: a swinging foot hold may have been clamped to reach,
+    // and the clamped value is what the next tick will present.
+    leg.ikFootX = leg.footHoldX;
+    leg.ikFootY = leg.footHoldY;
+    leg.ikAttachX = coxaAttachX;
+    leg.ikAttachY = coxaAttachY;
+    leg.ikBodyZ = bodyZ;
+    leg.ikYawRef = yawRef;
+    return true;
 }
 
+// Instantiated leg morphologies (see morph::selectIkPassKernel).
+template void solveLeg<3>(Segment::Leg &, float, float, float, math::Rot2);
+template bool solveLegLazy<3>(Segment::Leg &, float, float, float, math::Rot2);
+
 } // namespace ik
@@ -1,10 +1,47 @@
 #pragma once
 
 #include "../../include/Centipede.hpp"
+#include "ChainIK.hpp"
 
 namespace ik {
-    // Solve IK for a single leg. Updates `leg.hipAngle`, `leg.kneeAngle`, `leg.footAngle`.
+    // Horizontal reach `r` pulled back so that (r, dz) lies inside the leg's reachable
+    // shell [|L1 - L2|, L1 + L2] (with a small margin). Returns `r` unchanged if inside.
+    float clampReachR(float L1, float L2, float r, float dz);
+
+    // Closed-form planar 2-link solve (elbow-down) for an already clamped reach `r` and
+    // vertical offset `dz`. Outputs limit-clamped hip pitch and knee (radians).
+    void solvePlanar(float L1, float L2, float r, float dz, float &hipPitch, float &knee);
+
+    // Which solver `solveLeg` uses for the pitch joints:
+    // - Analytic: closed-form 2-link solve with knee+foot folded into one link (ankle
+    //   stays straight); optionally served from the tabulated workspace (IKTable).
+    // - Chain: CCD over the real hip/knee/foot links with per-joint limits, warm-started
+    //   from the previous solution (`target*Angle`), so the ankle can bend.
+    enum class LegSolver { Analytic, Chain };
+    void setLegSolver(LegSolver solver);
+    LegSolver legSolver();
+
+    // Iteration cap / tolerance used by the chain solver.
+    void setChainSolveParams(const ChainSolveParams &params);
+
+    // Chain solver statistics since the last reset (Centipede::update resets per tick).
+    ChainStats &chainStats();
+
+    // Solve IK for a single leg. Updates `leg.hipYaw`, `leg.kneeAngle`, `leg.footAngle`, `leg.ankleAngle`.
     // - `coxaAttachX/Y` are the hip joint world position (after coxa offset).
-    // - `bodyZ` is the hip Z (negative downwards is handled by solver as in original code).
-    void solveLeg(Segment::Leg &leg, float coxaAttachX, float coxaAttachY, float bodyZ, float yawRef);
+    // - `bodyZ` is the hip Z; the foot target is the hold at ground height `leg.footHoldZ`.
+    // - `yawRef` is the outward-facing direction the yaw limit is measured from.
+    // Also sets `leg.ikConverged` once the smoothed angles have reached their targets.
+    // `NumLinks` is the morphology's leg chain: the chain solver runs on
+    // morph::LegChain<NumLinks> (instantiated for the three links Segment::Leg stores).
+    template <int NumLinks = 3>
+    void solveLeg(Segment::Leg &leg, float coxaAttachX, float coxaAttachY, float bodyZ, math::Rot2 yawRef);
+
+    // Inputs closer than this (grid units / sin of yaw change) to the last solve count as unchanged.
+    inline constexpr float kLazyInputEps = 1e-4f;
+
+    // Dirty-tracked wrapper around `solveLeg`: skips the solve when the leg has converged
+    // and none of its inputs moved by more than `kLazyInputEps`. Returns true if solved.
+    template <int NumLinks = 3>
+    bool solveLegLazy(Segment::Leg &leg, float coxaAttachX, float coxaAttachY, float bodyZ, math::Rot2 yawRef);
 }
@@ -46,4 +46,10 @@ void handleCameraEvent(const sf::Event &ev, sf::RenderWindow* window, float &zoo
     }
 }
 
+void rebaseCamera(float shiftX, float shiftY, float resf) {
+    // Inverse of the shift's isometric image (see gridToIsoZ).
+    g_camOffX += (shiftX - shiftY) * resf * 0.5f;
+    g_camOffY += (shiftX + shiftY) * resf * 0.25f;
+}
+
 } // namespace input
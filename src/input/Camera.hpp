@@ -8,4 +8,8 @@ namespace input {
 
     // Handle camera-related events: middle-button drag and wheel zoom anchoring.
     void handleCameraEvent(const sf::Event &ev, sf::RenderWindow* window, float &zoom, bool &middleDragging, sf::Vector2i &middleLastMouse);
+
+    // The world's local origin moved by (shiftX, shiftY) grid units: move the camera with
+    // it so the view does not jump (resf as in the projection).
+    void rebaseCamera(float shiftX, float shiftY, float resf);
 }
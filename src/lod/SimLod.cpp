@@ -0,0 +1,27 @@
+#include "SimLod.hpp"
+
+namespace lod {
+
+bool overlapsView(float minX, float minY, float maxX, float maxY, float width, float height, float margin) {
+    return maxX >= -margin && minX <= width + margin && maxY >= -margin && minY <= height + margin;
+}
+
+SimTier selectTier(SimTier current, float distance, bool visible, const LodParams &params) {
+    // Demotion waits for the hysteresis band; promotion happens at the threshold itself.
+    const float fullLimit = params.fullDistance + (current == SimTier::Full ? params.hysteresis : 0.f);
+    const float reducedLimit = params.reducedDistance + (current != SimTier::Ghost ? params.hysteresis : 0.f);
+    if (visible && distance <= fullLimit) return SimTier::Full;
+    if (visible || distance <= reducedLimit) return SimTier::Reduced;
+    return SimTier::Ghost;
+}
+
+const char *tierName(SimTier tier) {
+    switch (tier) {
+    case SimTier::Full: return "full";
+    case SimTier::Reduced: return "reduced";
+    case SimTier::Ghost: return "ghost";
+    }
+    return "?";
+}
+
+} // namespace lod
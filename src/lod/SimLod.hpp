@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lod {
+
+// How much of the simulation a centipede runs per tick.
+// - Full:    gait, IK, voxel soft-body and occupancy ejection (everything).
+// - Reduced: legs play baked gait clips (no gait or IK; see lod::bakedLegs), no voxel
+//            soft-body. With full leg animation forced back on, gait runs every tick
+//            and IK every `kReducedIkInterval` ticks.
+// - Ghost:   only the head path and spine advance; legs, voxels and the pose are frozen.
+enum class SimTier : uint8_t { Full, Reduced, Ghost };
+
+inline constexpr int kReducedIkInterval = 4;
+
+// Whether a body in `tier` plays baked leg clips (anim::LegAnimation::Baked) instead of
+// the full gait + IK. Reduced bodies are far or small on screen, where clip playback
+// looks the same; ghosts freeze their legs either way, so they keep the clips and
+// ghost <-> reduced never switches.
+inline constexpr bool bakedLegs(SimTier tier) { return tier != SimTier::Full; }
+
+struct LodParams {
+    // Distances (grid units) from the view centre. Visible bodies within `fullDistance`
+    // run Full; bodies that are visible, or within `reducedDistance`, run Reduced.
+    float fullDistance = 60.f;
+    float reducedDistance = 120.f;
+    // A body keeps its current tier until it is this much further out than the
+    // threshold, so bodies on a boundary do not flip tiers every tick.
+    float hysteresis = 8.f;
+    // Screen-space margin (pixels) around the window that already counts as visible:
+    // ghosts are promoted while still off-screen, so their re-planted legs are never seen.
+    float viewMargin = 160.f;
+};
+
+// Screen-space bounds of a body (pixels) against a width x height window grown by `margin`.
+bool overlapsView(float minX, float minY, float maxX, float maxY, float width, float height, float margin);
+
+// Tier for a body at `distance` from the view centre, given whether it overlaps the
+// (margin-grown) view and the tier it ran last tick.
+SimTier selectTier(SimTier current, float distance, bool visible, const LodParams &params = LodParams{});
+
+const char *tierName(SimTier tier);
+
+} // namespace lod
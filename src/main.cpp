@@ -1,9 +1,17 @@
 #include <iostream>
+#include <string>
 #include "FallingSand.hpp"
+#include "bench/Bench.hpp"
 
 
 
-int main(){
+int main(int argc, char** argv){
+
+    // Headless benchmark mode
+    if (argc > 1 && std::string(argv[1]) == "--bench") return bench::run();
+    if (argc > 2 && std::string(argv[1]) == "--replay-record") return bench::recordReplay(argv[2]);
+    if (argc > 2 && std::string(argv[1]) == "--replay-check")
+        return bench::checkReplay(argv[2], argc > 3 ? std::stof(argv[3]) : bench::kDefaultReplayTolerance);
 
     //init srand
     std::srand(static_cast<unsigned>(time(NULL)));
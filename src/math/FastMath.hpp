@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CENTIPEDE_FASTMATH_SSE2 1
+#else
+#define CENTIPEDE_FASTMATH_SSE2 0
+#endif
+
+// Eight-lane forms, only when the compiler targets AVX2 (CMake option CENTIPEDE_AVX2).
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CENTIPEDE_FASTMATH_AVX2 1
+#else
+#define CENTIPEDE_FASTMATH_AVX2 0
+#endif
+
+// Compile-time switch: build with CENTIPEDE_FAST_MATH=1 (CMake option of the same name)
+// to route gait, IK, the sim update and the renderer through the approximations below.
+#ifndef CENTIPEDE_FAST_MATH
+#define CENTIPEDE_FAST_MATH 0
+#endif
+
+namespace fastmath {
+
+// Polynomial / minimax approximations. Max errors are measured over the stated domain
+// against double-precision libm (float inputs, float arithmetic), see `Main --bench`:
+//
+//   sin, cos : |x| <= 1e4        abs err <= 5e-7
+//   atan2    : all finite        abs err <= 5e-7 rad
+//   acos     : [-1, 1]           abs err <= 5e-7 rad
+//   sqrt     : [0, 1e6]          rel err <= 2e-7
+//   sinCoarse: |x| <= 1e3        abs err <= 1.2e-3
+//
+// Away from the origin sin/cos lose precision with |x| like any float range reduction.
+namespace approx {
+
+inline constexpr float kPi = 3.14159265f;
+inline constexpr float kHalfPi = 1.57079633f;
+
+// sin on [-pi/2, pi/2]: odd degree-9 minimax polynomial (3.4e-9 in exact arithmetic).
+inline float sinPoly(float x) {
+    const float x2 = x * x;
+    return x * (0.99999997659f + x2 * (-0.16666647635f + x2 * (0.0083328998234f +
+           x2 * (-0.00019800897763f + x2 * 2.5904885005e-6f))));
+}
+
+// Reduce to [-pi, pi] with a two-part 2*pi (Cody-Waite).
+inline float reduceAngle(float x) {
+    const float k = std::nearbyint(x * 0.15915494309189535f);
+    return (x - k * 6.28125f) - k * 1.9353071795864769e-3f;
+}
+
+// sin of an angle in [-pi, pi]: fold to [-pi/2, pi/2] by symmetry about +-pi/2.
+inline float sinReduced(float x) {
+    if (x > kHalfPi) x = kPi - x;
+    else if (x < -kHalfPi) x = -kPi - x;
+    return sinPoly(x);
+}
+
+inline float sin(float x) {
+    return sinReduced(reduceAngle(x));
+}
+
+inline float cos(float x) {
+    // Shift after reducing: adding pi/2 to a large x would round away the phase.
+    float r = reduceAngle(x) + kHalfPi;
+    if (r > kPi) r -= 2.f * kPi;
+    return sinReduced(r);
+}
+
+// Coarse sin for feedback terms (e.g. oscillator coupling) where ~1e-3 is plenty:
+// one-step reduction, a parabola through 0, +-pi/2, +-pi and one refinement.
+// abs err <= 1.2e-3 for |x| <= 1e3.
+inline float sinCoarse(float x) {
+    x -= 6.28318531f * std::nearbyint(x * 0.15915494f);
+    const float y = x * (1.27323954f - 0.40528473f * std::fabs(x));
+    return y + 0.225f * (y * std::fabs(y) - y);
+}
+
+// sinCoarse of a fixed-point angle: the int32 range is one turn, [-pi, pi), so the
+// argument is already reduced (e.g. a difference of wrapping uint32 phases).
+inline float sinCoarseTurn(int32_t t) {
+    const float u = static_cast<float>(t) * 4.65661287e-10f;  // t / 2^31, angle / pi
+    const float y = u * (4.f - 4.f * std::fabs(u));
+    return y + 0.225f * (y * std::fabs(y) - y);
+}
+
+// atan on [0, 1]: Abramowitz & Stegun 4.4.49 (|eps| <= 2e-8 in exact arithmetic).
+inline float atanUnit(float z) {
+    const float z2 = z * z;
+    return z * (0.9999993329f + z2 * (-0.3332985605f + z2 * (0.1994653599f + z2 * (-0.1390853351f +
+           z2 * (0.0964200441f + z2 * (-0.0559098861f + z2 * (0.0218612288f + z2 * -0.0040540580f)))))));
+}
+
+inline float atan2(float y, float x) {
+    const float ax = std::fabs(x), ay = std::fabs(y);
+    const float mx = ax > ay ? ax : ay;
+    if (mx == 0.f) return 0.f;
+    const float mn = ax > ay ? ay : ax;
+    float r = atanUnit(mn / mx);
+    if (ay > ax) r = kHalfPi - r;
+    if (x < 0.f) r = kPi - r;
+    return y < 0.f ? -r : r;
+}
+
+// sqrt via reciprocal-sqrt estimate plus one Newton step (SSE), or the integer seed
+// plus two steps elsewhere. Returns 0 for x < FLT_MIN: the estimate is inf for denormals
+// (and 0 is within sqrt(FLT_MIN) ~ 1e-19 of their root).
+inline float sqrt(float x) {
+    if (!(x >= FLT_MIN)) return 0.f;
+#if CENTIPEDE_FASTMATH_SSE2
+    float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    y = y * (1.5f - 0.5f * x * y * y);
+#else
+    uint32_t i;
+    std::memcpy(&i, &x, sizeof(i));
+    i = 0x5f375a86u - (i >> 1);
+    float y;
+    std::memcpy(&y, &i, sizeof(y));
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+#endif
+    float s = x * y;
+    // One Heron step on the product removes the remaining rsqrt error.
+    return 0.5f * (s + x / s);
+}
+
+// acos on [0, 1]: sqrt(1 - x) * poly(x), Abramowitz & Stegun 4.4.46 (|eps| <= 2e-8).
+inline float acosUnit(float x) {
+    const float p = 1.5707963050f + x * (-0.2145988016f + x * (0.0889789874f + x * (-0.0501743046f +
+                    x * (0.0308918810f + x * (-0.0170881256f + x * (0.0066700901f + x * -0.0012624911f))))));
+    return std::sqrt(1.f - x) * p;
+}
+
+inline float acos(float x) {
+    x = x > 1.f ? 1.f : (x < -1.f ? -1.f : x);
+    return x >= 0.f ? acosUnit(x) : kPi - acosUnit(-x);
+}
+
+// SIMD: four lanes at a time (SSE2 when available, scalar loop otherwise). The lane
+// math is the same polynomials as above, so errors match the scalar versions.
+#if CENTIPEDE_FASTMATH_SSE2
+inline __m128 sinPoly4(__m128 x) {
+    const __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p = _mm_set1_ps(2.5904885005e-6f);
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.00019800897763f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(0.0083328998234f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-0.16666647635f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(0.99999997659f));
+    return _mm_mul_ps(p, x);
+}
+
+inline __m128 reduceAngle4(__m128 x) {
+    // Round-to-nearest via cvtps (default MXCSR rounding), then Cody-Waite reduction.
+    const __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.15915494309189535f))));
+    return _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(6.28125f))), _mm_mul_ps(k, _mm_set1_ps(1.9353071795864769e-3f)));
+}
+
+inline __m128 sinReduced4(__m128 x) {
+    const __m128 pi = _mm_set1_ps(kPi), halfPi = _mm_set1_ps(kHalfPi);
+    const __m128 hi = _mm_cmpgt_ps(x, halfPi);
+    const __m128 lo = _mm_cmplt_ps(x, _mm_sub_ps(_mm_setzero_ps(), halfPi));
+    const __m128 foldHi = _mm_sub_ps(pi, x);
+    const __m128 foldLo = _mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), pi), x);
+    x = _mm_or_ps(_mm_and_ps(hi, foldHi), _mm_andnot_ps(hi, x));
+    x = _mm_or_ps(_mm_and_ps(lo, foldLo), _mm_andnot_ps(lo, x));
+    return sinPoly4(x);
+}
+
+inline __m128 sin4(__m128 x) {
+    return sinReduced4(reduceAngle4(x));
+}
+
+inline __m128 cos4(__m128 x) {
+    __m128 r = _mm_add_ps(reduceAngle4(x), _mm_set1_ps(kHalfPi));
+    const __m128 wrap = _mm_cmpgt_ps(r, _mm_set1_ps(kPi));
+    return sinReduced4(_mm_sub_ps(r, _mm_and_ps(wrap, _mm_set1_ps(2.f * kPi))));
+}
+
+inline __m128 sinCoarse4(__m128 x) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.15915494f))));
+    x = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(6.28318531f)));
+    const __m128 y = _mm_mul_ps(x, _mm_sub_ps(_mm_set1_ps(1.27323954f), _mm_mul_ps(_mm_set1_ps(0.40528473f), _mm_and_ps(x, absMask))));
+    return _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(0.225f), _mm_sub_ps(_mm_mul_ps(y, _mm_and_ps(y, absMask)), y)));
+}
+
+inline __m128 sinCoarseTurn4(__m128i t) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 u = _mm_mul_ps(_mm_cvtepi32_ps(t), _mm_set1_ps(4.65661287e-10f));
+    const __m128 y = _mm_mul_ps(u, _mm_sub_ps(_mm_set1_ps(4.f), _mm_mul_ps(_mm_set1_ps(4.f), _mm_and_ps(u, absMask))));
+    return _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(0.225f), _mm_sub_ps(_mm_mul_ps(y, _mm_and_ps(y, absMask)), y)));
+}
+
+#if CENTIPEDE_FASTMATH_AVX2
+inline __m256 sinCoarseTurn8(__m256i t) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 u = _mm256_mul_ps(_mm256_cvtepi32_ps(t), _mm256_set1_ps(4.65661287e-10f));
+    const __m256 y = _mm256_mul_ps(u, _mm256_sub_ps(_mm256_set1_ps(4.f), _mm256_mul_ps(_mm256_set1_ps(4.f), _mm256_and_ps(u, absMask))));
+    return _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(0.225f), _mm256_sub_ps(_mm256_mul_ps(y, _mm256_and_ps(y, absMask)), y)));
+}
+
+inline __m256 sinCoarse8(__m256 x) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.15915494f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(6.28318531f)));
+    const __m256 y = _mm256_mul_ps(x, _mm256_sub_ps(_mm256_set1_ps(1.27323954f), _mm256_mul_ps(_mm256_set1_ps(0.40528473f), _mm256_and_ps(x, absMask))));
+    return _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(0.225f), _mm256_sub_ps(_mm256_mul_ps(y, _mm256_and_ps(y, absMask)), y)));
+}
+#endif
+
+inline __m128 atan2_4(__m128 y, __m128 x) {
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    const __m128 ax = _mm_andnot_ps(signMask, x), ay = _mm_andnot_ps(signMask, y);
+    const __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+    const __m128 zero = _mm_cmpeq_ps(mx, _mm_setzero_ps());
+    const __m128 z = _mm_div_ps(mn, _mm_or_ps(mx, _mm_and_ps(zero, _mm_set1_ps(1.f))));
+    const __m128 z2 = _mm_mul_ps(z, z);
+    __m128 p = _mm_set1_ps(-0.0040540580f);
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(0.0218612288f));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(-0.0559098861f));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(0.0964200441f));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(-0.1390853351f));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(0.1994653599f));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(-0.3332985605f));
+    p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(0.9999993329f));
+    __m128 r = _mm_mul_ps(p, z);
+    const __m128 steep = _mm_cmpgt_ps(ay, ax);
+    r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps(kHalfPi), r)), _mm_andnot_ps(steep, r));
+    const __m128 neg = _mm_cmplt_ps(x, _mm_setzero_ps());
+    r = _mm_or_ps(_mm_and_ps(neg, _mm_sub_ps(_mm_set1_ps(kPi), r)), _mm_andnot_ps(neg, r));
+    r = _mm_or_ps(r, _mm_and_ps(y, signMask)); // copy the sign of y
+    return _mm_andnot_ps(zero, r);
+}
+
+inline __m128 sqrt4(__m128 x) {
+    const __m128 pos = _mm_cmpge_ps(x, _mm_set1_ps(FLT_MIN));
+    __m128 y = _mm_rsqrt_ps(x);
+    y = _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), _mm_mul_ps(y, y))));
+    __m128 s = _mm_and_ps(pos, _mm_mul_ps(x, y));
+    const __m128 safe = _mm_or_ps(s, _mm_andnot_ps(pos, _mm_set1_ps(1.f)));
+    s = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_add_ps(s, _mm_div_ps(x, safe)));
+    return _mm_and_ps(pos, s);
+}
+#endif
+
+// Array forms: process `n` values, four lanes at a time, scalar for the tail.
+inline void sinN(const float *in, float *out, size_t n) {
+    size_t i = 0;
+#if CENTIPEDE_FASTMATH_SSE2
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, sin4(_mm_loadu_ps(in + i)));
+#endif
+    for (; i < n; ++i) out[i] = sin(in[i]);
+}
+
+inline void cosN(const float *in, float *out, size_t n) {
+    size_t i = 0;
+#if CENTIPEDE_FASTMATH_SSE2
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, cos4(_mm_loadu_ps(in + i)));
+#endif
+    for (; i < n; ++i) out[i] = cos(in[i]);
+}
+
+inline void atan2N(const float *y, const float *x, float *out, size_t n) {
+    size_t i = 0;
+#if CENTIPEDE_FASTMATH_SSE2
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, atan2_4(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+#endif
+    for (; i < n; ++i) out[i] = atan2(y[i], x[i]);
+}
+
+inline void sqrtN(const float *in, float *out, size_t n) {
+    size_t i = 0;
+#if CENTIPEDE_FASTMATH_SSE2
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, sqrt4(_mm_loadu_ps(in + i)));
+#endif
+    for (; i < n; ++i) out[i] = sqrt(in[i]);
+}
+
+} // namespace approx
+
+// Routed entry points used by gait, IK, Centipede::update and drawCentipede: libm by
+// default, the approximations when built with CENTIPEDE_FAST_MATH=1.
+#if CENTIPEDE_FAST_MATH
+inline float sin(float x) { return approx::sin(x); }
+inline float cos(float x) { return approx::cos(x); }
+inline float atan2(float y, float x) { return approx::atan2(y, x); }
+inline float acos(float x) { return approx::acos(x); }
+inline float sqrt(float x) { return approx::sqrt(x); }
+#else
+inline float sin(float x) { return std::sin(x); }
+inline float cos(float x) { return std::cos(x); }
+inline float atan2(float y, float x) { return std::atan2(y, x); }
+inline float acos(float x) { return std::acos(x); }
+inline float sqrt(float x) { return std::sqrt(x); }
+#endif
+
+} // namespace fastmath
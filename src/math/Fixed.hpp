@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+namespace math {
+
+// 16.16 fixed point: a grid coordinate as an int32 with 16 fraction bits (1/65536 of a
+// cell, range +-32768 grid units around the local origin; the floating origin keeps
+// bodies well inside it). Voxel positions use it so that the occupancy cell of a voxel
+// is an add and a shift, exact and the same at every distance from the origin.
+using Fixed = int32_t;
+
+inline constexpr int kFixedShift = 16;
+inline constexpr Fixed kFixedOne = Fixed(1) << kFixedShift;
+inline constexpr Fixed kFixedHalf = kFixedOne / 2;
+
+// Nearest fixed-point value (ties away from zero).
+constexpr Fixed toFixed(float v) {
+    return static_cast<Fixed>(v * static_cast<float>(kFixedOne) + (v >= 0.f ? 0.5f : -0.5f));
+}
+constexpr float toFloat(Fixed v) { return static_cast<float>(v) * (1.f / static_cast<float>(kFixedOne)); }
+
+// Cell whose centre is nearest, floor(v + 0.5) (the arithmetic shift floors negatives).
+constexpr int fixedCell(Fixed v) { return (v + kFixedHalf) >> kFixedShift; }
+// Position of the centre of cell `c`.
+constexpr Fixed cellToFixed(int c) { return static_cast<Fixed>(static_cast<uint32_t>(c) << kFixedShift); }
+
+// Constant factors in [0, 1] (springs, damping) with 8 fraction bits: a factor times a
+// value under 128 grid units stays within 32 bits, so scaling is one 32-bit multiply and
+// a shift (no 64-bit product, so loops of it vectorize).
+using Factor = int32_t;
+inline constexpr int kFactorShift = 8;
+constexpr Factor toFactor(float f) { return static_cast<Factor>(f * static_cast<float>(1 << kFactorShift) + 0.5f); }
+// v * f, for |v| < 128 grid units, rounded toward zero: a plain shift would floor, so a
+// damped negative velocity would stop at -1 LSB while a positive one reaches 0 (and
+// rounding to nearest would hold both at +-1 under any damping above 0.5).
+constexpr Fixed fixedScale(Fixed v, Factor f) {
+    const Fixed p = v * f;
+    return (p + ((p >> 31) & ((Fixed(1) << kFactorShift) - 1))) >> kFactorShift;
+}
+
+} // namespace math
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+
+namespace math {
+
+// Planar rotation / heading stored as a unit complex number (c, s) = (cos a, sin a).
+// Composition, relative angles and limit checks are products, dots and crosses; trig is
+// only needed when converting to or from radians at an API boundary (`fromAngle`,
+// `angle`).
+struct Rot2 {
+    float c = 1.f;
+    float s = 0.f;
+
+    static Rot2 identity() { return Rot2{1.f, 0.f}; }
+
+    // Boundary conversions (the only trig in this type).
+    static Rot2 fromAngle(float radians) { return Rot2{std::cos(radians), std::sin(radians)}; }
+    float angle() const { return std::atan2(s, c); }
+
+    // Direction of (x, y); `fallback` if the vector is (nearly) zero.
+    static Rot2 fromVector(float x, float y, Rot2 fallback = identity()) {
+        const float len2 = x * x + y * y;
+        if (len2 < 1e-12f) return fallback;
+        const float inv = 1.f / std::sqrt(len2);
+        return Rot2{x * inv, y * inv};
+    }
+
+    // this followed by `o` (angles add).
+    Rot2 operator*(const Rot2 &o) const { return Rot2{c * o.c - s * o.s, c * o.s + s * o.c}; }
+    // Inverse rotation (negated angle).
+    Rot2 conj() const { return Rot2{c, -s}; }
+
+    // cos / sin of the angle from this to `o`.
+    float dot(const Rot2 &o) const { return c * o.c + s * o.s; }
+    float cross(const Rot2 &o) const { return c * o.s - s * o.c; }
+
+    // Renormalize after accumulated products.
+    Rot2 normalized() const { return fromVector(c, s, *this); }
+};
+
+// Normalized lerp from `a` toward `b` by `t` (0..1). Not constant angular speed, but
+// monotonic and exact at the ends, which is all the smoothing filters need. Opposite
+// headings have no shortest way round; the sweep then turns counter-clockwise.
+inline Rot2 nlerp(const Rot2 &a, const Rot2 &b, float t) {
+    float x = a.c + (b.c - a.c) * t;
+    float y = a.s + (b.s - a.s) * t;
+    if (x * x + y * y < 1e-8f) { x = -a.s; y = a.c; }
+    return Rot2::fromVector(x, y, a);
+}
+
+// `q` limited to within `limit` (a Rot2 of the max deviation, 0..pi) of `ref`. The
+// limit test is a dot product against cos(limit); the side comes from the cross sign.
+inline Rot2 clampAround(const Rot2 &ref, const Rot2 &q, const Rot2 &limit) {
+    const Rot2 rel = ref.conj() * q;
+    if (rel.c >= limit.c) return q;
+    return ref * Rot2{limit.c, rel.s < 0.f ? -limit.s : limit.s};
+}
+
+} // namespace math
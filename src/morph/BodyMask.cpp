@@ -0,0 +1,98 @@
+#include "BodyMask.hpp"
+#include "../math/FastMath.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+
+namespace morph {
+
+static constexpr float kTwoPi = 6.28318530718f;
+
+Silhouette Silhouette::diamond(int side) {
+    Silhouette s;
+    s.width = s.height = std::clamp(side, 1, kMaxSilhouetteSide);
+    s.cells.resize(static_cast<size_t>(s.width) * s.height);
+    const int c = s.width / 2;
+    for (int y = 0; y < s.height; ++y) {
+        for (int x = 0; x < s.width; ++x) s.cells[static_cast<size_t>(y) * s.width + x] = (std::abs(x - c) + std::abs(y - c) <= c) ? 1 : 0;
+    }
+    return s;
+}
+
+Silhouette Silhouette::ellipse(int width, int height) {
+    Silhouette s;
+    s.width = std::clamp(width, 1, kMaxSilhouetteSide);
+    s.height = std::clamp(height, 1, kMaxSilhouetteSide);
+    s.cells.resize(static_cast<size_t>(s.width) * s.height);
+    const float cx = (s.width - 1) * 0.5f, cy = (s.height - 1) * 0.5f;
+    const float rx = s.width * 0.5f, ry = s.height * 0.5f;
+    for (int y = 0; y < s.height; ++y) {
+        for (int x = 0; x < s.width; ++x) {
+            const float u = (x - cx) / rx, v = (y - cy) / ry;
+            s.cells[static_cast<size_t>(y) * s.width + x] = (u * u + v * v <= 1.f) ? 1 : 0;
+        }
+    }
+    return s;
+}
+
+BodyMask::BodyMask(const Silhouette &silhouette, int headings) : shape(silhouette) {
+    const int n = std::max(headings, 1);
+    const int w = shape.width, h = shape.height;
+    const float cx = (w - 1) * 0.5f, cy = (h - 1) * 0.5f;
+    layoutRows.assign(static_cast<size_t>(h), 0);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (shape.filled(x, y)) layoutRows[static_cast<size_t>(y)] |= uint64_t(1) << x;
+        }
+        filledCount += static_cast<size_t>(std::popcount(layoutRows[static_cast<size_t>(y)]));
+    }
+    std::vector<int> cellX, cellY;
+    masks.resize(static_cast<size_t>(n));
+    for (int k = 0; k < n; ++k) {
+        RotatedMask &m = masks[static_cast<size_t>(k)];
+        const float a = kTwoPi * static_cast<float>(k) / static_cast<float>(n);
+        // Heading 0 exactly (the unrotated layout).
+        const float c = k == 0 ? 1.f : std::cos(a), s = k == 0 ? 0.f : std::sin(a);
+        m.offX.clear();
+        m.offY.clear();
+        cellX.clear();
+        cellY.clear();
+        for (int y = 0; y < h; ++y) {
+            for (uint64_t row = layoutRows[static_cast<size_t>(y)]; row; row &= row - 1) {
+                const int x = std::countr_zero(row);
+                const float dx = x - cx, dy = y - cy;
+                m.offX.push_back(math::toFixed(cx + c * dx - s * dy));
+                m.offY.push_back(math::toFixed(cy + s * dx + c * dy));
+                cellX.push_back(math::fixedCell(m.offX.back()));
+                cellY.push_back(math::fixedCell(m.offY.back()));
+            }
+        }
+        if (cellX.empty()) continue;
+        m.minX = *std::min_element(cellX.begin(), cellX.end());
+        m.minY = *std::min_element(cellY.begin(), cellY.end());
+        const int maxY = *std::max_element(cellY.begin(), cellY.end());
+        m.spanX = *std::max_element(cellX.begin(), cellX.end()) - m.minX + 1;
+        m.rows.assign(static_cast<size_t>(maxY - m.minY + 1), 0);
+        for (size_t j = 0; j < cellX.size(); ++j) m.rows[static_cast<size_t>(cellY[j] - m.minY)] |= uint64_t(1) << (cellX[j] - m.minX);
+        for (uint64_t row : m.rows) m.cellCount += static_cast<size_t>(std::popcount(row));
+    }
+}
+
+int BodyMask::headingIndex(const math::Rot2 &heading) const {
+    const int n = headingCount();
+    const int k = static_cast<int>(std::lround(fastmath::atan2(heading.s, heading.c) * static_cast<float>(n) / kTwoPi));
+    return ((k % n) + n) % n;
+}
+
+static std::vector<std::unique_ptr<BodyMask>> s_masks;
+
+const BodyMask &maskFor(const Silhouette &silhouette) {
+    for (const auto &m : s_masks) {
+        if (m->silhouette() == silhouette) return *m;
+    }
+    s_masks.push_back(std::make_unique<BodyMask>(silhouette));
+    return *s_masks.back();
+}
+
+} // namespace morph
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../math/Fixed.hpp"
+#include "../math/Rot2.hpp"
+
+namespace morph {
+
+// Headings a body mask is precomputed at (evenly spaced, heading 0 along +x).
+inline constexpr int kMaskHeadings = 16;
+// Largest silhouette side (cells): every rotation of it fits the 64-bit mask rows.
+inline constexpr int kMaxSilhouetteSide = 40;
+
+// Collision silhouette of a segment: `width` x `height` voxel cells, row-major, nonzero =
+// filled. Columns run along the segment's heading (+x at heading 0), rows across it.
+struct Silhouette {
+    int width = 0, height = 0;
+    std::vector<uint8_t> cells;
+
+    // The original segment: a diamond (|dx| + |dy| <= side / 2 from the centre cell).
+    static Silhouette diamond(int side);
+    // An ellipse inscribed in a width x height box.
+    static Silhouette ellipse(int width, int height);
+
+    bool filled(int x, int y) const { return cells[static_cast<size_t>(y) * width + x] != 0; }
+    bool operator==(const Silhouette &o) const = default;
+};
+
+// A silhouette turned to one heading, about its centre.
+struct RotatedMask {
+    // Rest offset of every filled silhouette cell (in layout order, as the voxels are
+    // stored) from its segment: the soft-body pulls voxel i toward segment + offset i.
+    std::vector<math::Fixed> offX, offY;
+    // The filled cells' offsets rasterized for a segment at the centre of cell (0, 0):
+    // bit b of rows[r] is cell (minX + b, minY + r), b < spanX.
+    int minX = 0, minY = 0, spanX = 0;
+    std::vector<uint64_t> rows;
+    size_t cellCount = 0;
+};
+
+// Rotated masks of one silhouette at every heading, built once (per silhouette, see
+// `maskFor`), so turning a segment's collision shape is a table lookup by quantized
+// heading instead of rotating each voxel every tick. At heading 0 the offsets are the
+// silhouette's own cells (cell (x, y) at offset (x, y), as segments always laid them out).
+class BodyMask {
+private:
+    Silhouette shape;
+    std::vector<uint64_t> layoutRows;
+    size_t filledCount = 0;
+    std::vector<RotatedMask> masks;
+
+public:
+    explicit BodyMask(const Silhouette &silhouette, int headings = kMaskHeadings);
+
+    const Silhouette &silhouette() const { return shape; }
+    // Filled cells of the silhouette: bit x of layout()[y] is cell (x, y). A segment stores
+    // one voxel per set bit, rows in order and bits low to high (its layout order).
+    const std::vector<uint64_t> &layout() const { return layoutRows; }
+    size_t voxelCount() const { return filledCount; }
+    int headingCount() const { return static_cast<int>(masks.size()); }
+    // Index of the precomputed heading nearest to `heading`.
+    int headingIndex(const math::Rot2 &heading) const;
+    const RotatedMask &at(int index) const { return masks[static_cast<size_t>(index)]; }
+    const RotatedMask &forHeading(const math::Rot2 &heading) const { return at(headingIndex(heading)); }
+};
+
+// Masks are shared per silhouette: built on first use and kept for the program's life.
+const BodyMask &maskFor(const Silhouette &silhouette);
+
+} // namespace morph
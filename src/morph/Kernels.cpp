@@ -0,0 +1,100 @@
+#include "Kernels.hpp"
+#include "Morphology.hpp"
+#include "../../include/Centipede.hpp"
+#include "../ik/LegIK.hpp"
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+namespace morph {
+
+template <int NumLinks, int LegsPerSide>
+static void ikPassKernel(std::vector<Segment> &segments, IkPassCounters &counters) {
+    using Layout = SegmentLayout<LegsPerSide>;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto &seg = segments[i];
+
+        float spineX = 0.f, spineY = 0.f;
+        if (i < segments.size() - 1) {
+            spineX = segments[i + 1].x - segments[i].x;
+            spineY = segments[i + 1].y - segments[i].y;
+        } else if (i > 0) {
+            spineX = segments[i].x - segments[i - 1].x;
+            spineY = segments[i].y - segments[i - 1].y;
+        } else {
+            spineX = 1.f;
+            spineY = 0.f;
+        }
+        float spineLen = fastmath::sqrt(spineX * spineX + spineY * spineY);
+        if (spineLen < 0.001f) {
+            spineX = 1.f;
+            spineY = 0.f;
+            spineLen = 1.f;
+        }
+        spineX /= spineLen;
+        spineY /= spineLen;
+        float perpX = -spineY;
+        float perpY = spineX;
+
+        const float stanceWidth = kStanceWidth;
+        const float bodyZ = seg.bodyZ;
+
+        float midX = (i < segments.size() - 1) ? (segments[i].x + segments[i + 1].x) * 0.5f : segments[i].x;
+        float midY = (i < segments.size() - 1) ? (segments[i].y + segments[i + 1].y) * 0.5f : segments[i].y;
+
+        // Legs of one side spread evenly along the spine around the midpoint.
+        const float slotSpacing = spineLen / static_cast<float>(LegsPerSide);
+
+        assert(seg.legs.size() == static_cast<size_t>(Layout::kLegs));
+        Segment::Leg *legs = seg.legs.data();
+        staticFor<Layout::kLegs>([&](auto k) {
+            constexpr float side = static_cast<float>(Layout::side(decltype(k)::value));
+            constexpr float slot = static_cast<float>(Layout::slot(decltype(k)::value)) - 0.5f * static_cast<float>(LegsPerSide - 1);
+            Segment::Leg &leg = legs[k];
+            float attachX = midX + spineX * (slot * slotSpacing) + perpX * (stanceWidth * side);
+            float attachY = midY + spineY * (slot * slotSpacing) + perpY * (stanceWidth * side);
+
+            float coxaAttachX = attachX + perpX * leg.coxaLength * side;
+            float coxaAttachY = attachY + perpY * leg.coxaLength * side;
+
+            const float outDirX = perpX * side;
+            const float outDirY = perpY * side;
+            // perp is unit length, so the outward direction is already a valid rotation.
+            const math::Rot2 yawRef{outDirX, outDirY};
+
+            if (ik::solveLegLazy<NumLinks>(leg, coxaAttachX, coxaAttachY, bodyZ, yawRef)) counters.solved++;
+            else counters.skipped++;
+        });
+    }
+}
+
+// Instantiated morphologies. `Segment::Leg` stores three links (hip/knee/foot), and
+// bodies are built with one leg per side (the kernel indexes Layout::kLegs legs per
+// segment), so that is the only form until segments are laid out with more.
+struct KernelEntry {
+    int numLinks;
+    int legsPerSide;
+    IkPassKernel kernel;
+};
+static constexpr KernelEntry kKernels[] = {
+    {3, 1, &ikPassKernel<3, 1>},
+};
+
+static constexpr bool kernelsMatchForms() {
+    if (std::size(kKernels) != std::size(kIkPassForms)) return false;
+    for (size_t i = 0; i < std::size(kKernels); ++i) {
+        if (kKernels[i].numLinks != kIkPassForms[i].numLinks || kKernels[i].legsPerSide != kIkPassForms[i].legsPerSide) return false;
+    }
+    return true;
+}
+static_assert(kernelsMatchForms(), "kIkPassForms must list exactly the instantiated kernels");
+
+IkPassKernel selectIkPassKernel(int numLinks, int legsPerSide) {
+    for (const auto &e : kKernels) {
+        if (e.numLinks == numLinks && e.legsPerSide == legsPerSide) return e.kernel;
+    }
+    return nullptr;
+}
+
+} // namespace morph
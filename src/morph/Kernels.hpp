@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Included from include/Centipede.hpp, so only a forward declaration here.
+struct Segment;
+
+namespace morph {
+
+struct IkPassCounters {
+    size_t solved = 0;
+    size_t skipped = 0;
+};
+
+// Per-tick IK pass over all segments: builds each segment's frame once, then solves
+// every leg (lazily, at its segment's body height) with the leg loop unrolled for a
+// fixed layout.
+using IkPassKernel = void (*)(std::vector<Segment> &segments, IkPassCounters &counters);
+
+// Kernel specialized for `numLinks` links per leg and `legsPerSide` legs on each side of
+// a segment, or nullptr when that morphology has no instantiation. Select it once (at
+// construction) and call it every tick. Every segment passed to a kernel must hold
+// exactly 2 * legsPerSide legs.
+IkPassKernel selectIkPassKernel(int numLinks, int legsPerSide);
+
+// Morphologies with an instantiated kernel (Kernels.cpp checks its table against this).
+struct KernelForm {
+    int numLinks;
+    int legsPerSide;
+};
+inline constexpr KernelForm kIkPassForms[] = {
+    {3, 1},
+};
+
+constexpr bool hasIkPassKernel(int numLinks, int legsPerSide) {
+    for (const KernelForm &f : kIkPassForms) {
+        if (f.numLinks == numLinks && f.legsPerSide == legsPerSide) return true;
+    }
+    return false;
+}
+
+// Kernel for a morphology fixed at compile time: one without an instantiation fails to
+// build here instead of returning nullptr.
+template <int NumLinks, int LegsPerSide>
+IkPassKernel ikPassKernelFor() {
+    static_assert(hasIkPassKernel(NumLinks, LegsPerSide), "no IK pass kernel is instantiated for this morphology");
+    return selectIkPassKernel(NumLinks, LegsPerSide);
+}
+
+} // namespace morph
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include "../ik/ChainIK.hpp"
+#include "../math/FastMath.hpp"
+
+namespace morph {
+
+// Call `f(std::integral_constant<int, I>{})` for I = 0..N-1, expanded at compile time so
+// loops over links/legs of a fixed morphology are fully unrolled.
+template <int N, typename F>
+inline void staticFor(F &&f) {
+    [&]<int... I>(std::integer_sequence<int, I...>) {
+        (f(std::integral_constant<int, I>{}), ...);
+    }(std::make_integer_sequence<int, N>{});
+}
+
+// A planar leg chain with a compile-time link count. Joint 0 is the absolute hip pitch
+// (from the horizontal, negative = down), later joints are relative to the previous link.
+template <int NumLinks>
+struct LegChain {
+    static_assert(NumLinks >= 1 && NumLinks <= ik::kMaxChainLinks, "unsupported link count");
+    static constexpr int kLinks = NumLinks;
+    using Angles = std::array<float, NumLinks>;
+    using Points = std::array<float, NumLinks + 1>;
+
+    std::array<float, NumLinks> length{};
+    std::array<float, NumLinks> minAngle{};
+    std::array<float, NumLinks> maxAngle{};
+
+    float reach() const {
+        float sum = 0.f;
+        staticFor<NumLinks>([&](auto j) { sum += length[j]; });
+        return sum;
+    }
+
+    // Joint positions in the leg plane (r = horizontal, z = vertical), base at the origin.
+    void forward(const Angles &angles, Points &r, Points &z) const {
+        float pitch = 0.f;
+        r[0] = 0.f;
+        z[0] = 0.f;
+        staticFor<NumLinks>([&](auto j) {
+            pitch += angles[j];
+            r[j + 1] = r[j] + length[j] * fastmath::cos(pitch);
+            z[j + 1] = z[j] + length[j] * fastmath::sin(pitch);
+        });
+    }
+
+    // Joint positions in world space for a hip at (hipX, hipY, hipZ) and horizontal
+    // leg direction (dirX, dirY) (unit vector from the yaw).
+    void forwardWorld(const Angles &angles, float hipX, float hipY, float hipZ, float dirX, float dirY,
+                      Points &x, Points &y, Points &z) const {
+        Points r;
+        forward(angles, r, z);
+        staticFor<NumLinks + 1>([&](auto j) {
+            x[j] = hipX + dirX * r[j];
+            y[j] = hipY + dirY * r[j];
+            z[j] = hipZ + z[j];
+        });
+    }
+
+    // Re-target a warm start to a moved end effector: links 1.. are held at their current
+    // relative pose as one rigid virtual link, and the hip and first joint are placed in
+    // closed form (law of cosines, same bend direction as the warm start), then clamped.
+    // Exact whenever those two joints stay inside their limits.
+    void retarget(float targetR, float targetZ, Angles &angles) const {
+        const float dist = fastmath::sqrt(targetR * targetR + targetZ * targetZ);
+        if (dist < 1e-5f) return;
+        const float aim = fastmath::atan2(targetZ, targetR);
+        if constexpr (NumLinks == 1) {
+            angles[0] = std::clamp(aim, minAngle[0], maxAngle[0]);
+        } else {
+            Points pr, pz;
+            forward(angles, pr, pz);
+            // Straighten the distal joints (within limits) when the folded pose falls short.
+            if constexpr (NumLinks > 2) {
+                const float wr = pr[NumLinks] - pr[1], wz = pz[NumLinks] - pz[1];
+                if (dist > length[0] + fastmath::sqrt(wr * wr + wz * wz)) {
+                    staticFor<NumLinks - 2>([&](auto k) {
+                        constexpr int j = decltype(k)::value + 2;
+                        angles[j] = std::clamp(0.0f, minAngle[j], maxAngle[j]);
+                    });
+                    forward(angles, pr, pz);
+                }
+            }
+            // Virtual link (joint 1 -> end effector) in link 0's frame.
+            const float c0 = fastmath::cos(angles[0]), s0 = fastmath::sin(angles[0]);
+            const float wr = pr[NumLinks] - pr[1], wz = pz[NumLinks] - pz[1];
+            const float vr = c0 * wr + s0 * wz, vz = c0 * wz - s0 * wr;
+            const float a = length[0];
+            const float b = fastmath::sqrt(vr * vr + vz * vz);
+            if (b < 1e-5f) return;
+            const float offset = fastmath::atan2(vz, vr) - angles[1];
+            const float cosBend = std::clamp((dist * dist - a * a - b * b) / (2.0f * a * b), -1.0f, 1.0f);
+            const float bend = (vz > 0.f ? 1.0f : -1.0f) * fastmath::acos(cosBend);
+            angles[1] = std::clamp(bend - offset, minAngle[1], maxAngle[1]);
+            angles[0] = std::clamp(aim - fastmath::atan2(b * fastmath::sin(bend), a + b * fastmath::cos(bend)),
+                                   minAngle[0], maxAngle[0]);
+        }
+    }
+
+    // Cyclic-coordinate-descent solve toward (targetR, targetZ) in the leg plane. `angles`
+    // is the warm start (the previous frame's solution) and is updated in place with every
+    // joint clamped to its limits; returns the iterations used (zero when the warm start is
+    // already within tolerance). The warm start is first re-targeted (see retarget) when
+    // that brings the end effector closer. Each sweep turns the joints tip to root so the
+    // end effector points at the target; see ik::ChainStats for how a solve ends.
+    int solveCCD(float targetR, float targetZ, Angles &angles, const ik::ChainSolveParams &params,
+                 ik::ChainStats *stats = nullptr) const {
+        const float tol2 = params.tolerance * params.tolerance;
+        const float settle2 = tol2 * 0.01f;
+        staticFor<NumLinks>([&](auto j) { angles[j] = std::clamp(angles[j], minAngle[j], maxAngle[j]); });
+
+        Points pr, pz;
+        forward(angles, pr, pz);
+        float er = pr[NumLinks] - targetR, ez = pz[NumLinks] - targetZ;
+        if (er * er + ez * ez > tol2) {
+            Angles seeded = angles;
+            retarget(targetR, targetZ, seeded);
+            Points sr, sz;
+            forward(seeded, sr, sz);
+            const float ser = sr[NumLinks] - targetR, sez = sz[NumLinks] - targetZ;
+            if (ser * ser + sez * sez < er * er + ez * ez) {
+                angles = seeded;
+                pr = sr;
+                pz = sz;
+                er = ser;
+                ez = sez;
+            }
+        }
+        bool reached = (er * er + ez * ez) <= tol2;
+        bool settled = false;
+
+        int iter = 0;
+        while (!reached && !settled && iter < params.maxIterations) {
+            ++iter;
+            const float prevR = pr[NumLinks], prevZ = pz[NumLinks];
+            staticFor<NumLinks>([&](auto k) {
+                constexpr int j = NumLinks - 1 - decltype(k)::value;
+                const float toEndR = pr[NumLinks] - pr[j], toEndZ = pz[NumLinks] - pz[j];
+                const float toTgtR = targetR - pr[j], toTgtZ = targetZ - pz[j];
+                if (toEndR * toEndR + toEndZ * toEndZ < 1e-10f || toTgtR * toTgtR + toTgtZ * toTgtZ < 1e-10f) return;
+                float delta = fastmath::atan2(toTgtZ, toTgtR) - fastmath::atan2(toEndZ, toEndR);
+                const float PI = 3.14159265f;
+                if (delta > PI) delta -= 2.0f * PI;
+                if (delta < -PI) delta += 2.0f * PI;
+                const float before = angles[j];
+                angles[j] = std::clamp(before + delta, minAngle[j], maxAngle[j]);
+                if (angles[j] != before) forward(angles, pr, pz);
+            });
+            er = pr[NumLinks] - targetR;
+            ez = pz[NumLinks] - targetZ;
+            reached = (er * er + ez * ez) <= tol2;
+            const float mr = pr[NumLinks] - prevR, mz = pz[NumLinks] - prevZ;
+            settled = !reached && (mr * mr + mz * mz) <= settle2;
+        }
+
+        if (stats) {
+            stats->solves++;
+            stats->iterations += static_cast<size_t>(iter);
+            if (reached) stats->reached++;
+            else if (settled) stats->settled++;
+            else stats->hitCap++;
+            stats->maxIterations = std::max(stats->maxIterations, iter);
+        }
+        return iter;
+    }
+};
+
+// Leg placement on a segment with a compile-time number of legs per side. Legs are
+// stored left side first (side -1), then right side (+1); `slot` is the index along
+// the segment within one side.
+template <int LegsPerSide>
+struct SegmentLayout {
+    static_assert(LegsPerSide >= 1, "a segment needs at least one leg per side");
+    static constexpr int kLegsPerSide = LegsPerSide;
+    static constexpr int kLegs = 2 * LegsPerSide;
+
+    static constexpr int side(int leg) { return leg < LegsPerSide ? -1 : 1; }
+    static constexpr int slot(int leg) { return leg < LegsPerSide ? leg : leg - LegsPerSide; }
+    static constexpr int index(int side, int slot) { return (side < 0 ? 0 : LegsPerSide) + slot; }
+};
+
+} // namespace morph
@@ -0,0 +1,252 @@
+#include "Articulated.hpp"
+#include "../math/FastMath.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace physics {
+
+void ArticulatedChain::build(const float *xs, const float *ys, const float *lengths, size_t count, float linkMass) {
+    this->mass = linkMass;
+    length.assign(lengths, lengths + count);
+    inertia.resize(count);
+    for (size_t i = 0; i < count; ++i) inertia[i] = linkMass * length[i] * length[i] / 12.f;  // rod about its centre
+    for (auto *v : {&q, &qd, &fx, &fy, &ft, &dirX, &dirY, &cx, &cy, &rx, &ry, &ox, &oy, &vw, &vx, &vy, &bx, &by,
+                    &px, &py, &pw, &uw, &ux, &uy, &dInv, &uTau, &aw, &ax, &ay, &linkVx, &linkVy, &linkW}) {
+        v->assign(count, 0.f);
+    }
+    ia.assign(count * 6, 0.f);
+    if (count == 0) return;
+
+    // Link directions from consecutive centres (the last link continues its predecessor).
+    float prevAngle = 0.f;
+    for (size_t i = 0; i < count; ++i) {
+        float angle = prevAngle;
+        if (i + 1 < count) angle = std::atan2(ys[i] - ys[i + 1], xs[i] - xs[i + 1]);
+        if (i == 0) this->headAngle = angle;
+        else q[i] = fastmath::approx::reduceAngle(angle - prevAngle);
+        prevAngle = angle;
+    }
+    this->headX = xs[0]; this->headY = ys[0];
+    this->headVx = this->headVy = this->headW = 0.f;
+    this->targetX = this->lastTargetX = xs[0];
+    this->targetY = this->lastTargetY = ys[0];
+    this->targetVx = this->targetVy = 0.f;
+    kinematics();
+}
+
+void ArticulatedChain::addForce(size_t i, float x, float y, float forceX, float forceY) {
+    fx[i] += forceX;
+    fy[i] += forceY;
+    ft[i] += (x - posX(i)) * forceY - (y - posY(i)) * forceX;
+}
+
+// Directions and centres (relative to the head) for the current angles, and each link's
+// frame offsets: from its parent's frame origin (rx, ry) and to its own centre (ox, oy).
+void ArticulatedChain::kinematics() {
+    float angle = this->headAngle;
+    for (size_t i = 0; i < length.size(); ++i) {
+        if (i > 0) angle += q[i];
+        dirX[i] = fastmath::cos(angle);
+        dirY[i] = fastmath::sin(angle);
+        if (i == 0) {
+            cx[0] = cy[0] = 0.f;
+            rx[0] = ry[0] = ox[0] = oy[0] = 0.f;
+            continue;
+        }
+        // Joint i is the rear end of link i-1 (the head's frame sits at its centre, every
+        // other link's at its front joint).
+        const float back = i == 1 ? 0.5f * length[0] : length[i - 1];
+        rx[i] = -back * dirX[i - 1];
+        ry[i] = -back * dirY[i - 1];
+        ox[i] = -0.5f * length[i] * dirX[i];
+        oy[i] = -0.5f * length[i] * dirY[i];
+        cx[i] = cx[i - 1] - ox[i - 1] + rx[i] + ox[i];
+        cy[i] = cy[i - 1] - oy[i - 1] + ry[i] + oy[i];
+    }
+}
+
+// Spatial velocities outward from the head, each in its link's frame. A parent velocity
+// moves to the child frame as (w, vx - w ry, vy + w rx); the joint adds S qd with
+// S = (1, 0, 0), and the bias is v x S qd = (0, vy qd, -vx qd) (its angular part is
+// always zero, so only bx / by are kept).
+void ArticulatedChain::velocities() {
+    vw[0] = this->headW; vx[0] = this->headVx; vy[0] = this->headVy;
+    bx[0] = by[0] = 0.f;
+    for (size_t i = 1; i < length.size(); ++i) {
+        vw[i] = vw[i - 1] + qd[i];
+        vx[i] = vx[i - 1] - vw[i - 1] * ry[i];
+        vy[i] = vy[i - 1] + vw[i - 1] * rx[i];
+        bx[i] = vy[i] * qd[i];
+        by[i] = -vx[i] * qd[i];
+    }
+}
+
+void ArticulatedChain::step(const ChainParams &params) {
+    const size_t n = length.size();
+    if (n == 0) return;
+    const int substeps = std::max(params.substeps, 1);
+    const float h = params.dt / static_cast<float>(substeps);
+
+    // Moves arrive every other tick or so; smooth the target's velocity over them.
+    const float rawVx = (this->targetX - this->lastTargetX) / params.dt;
+    const float rawVy = (this->targetY - this->lastTargetY) / params.dt;
+    this->targetVx += (rawVx - this->targetVx) * 0.5f;
+    this->targetVy += (rawVy - this->targetVy) * 0.5f;
+    this->lastTargetX = this->targetX;
+    this->lastTargetY = this->targetY;
+
+    for (int s = 0; s < substeps; ++s) {
+        kinematics();
+        velocities();
+
+        // Link inertias in their own frames, and bias forces v x* (I v) - f_ext.
+        for (size_t i = 0; i < n; ++i) {
+            const float m = this->mass, o_x = ox[i], o_y = oy[i];
+            float *I = &ia[i * 6];
+            I[0] = inertia[i] + m * (o_x * o_x + o_y * o_y);
+            I[1] = -m * o_y; I[2] = m * o_x;
+            I[3] = m; I[4] = 0.f; I[5] = m;
+
+            // Linear momentum of I v (the angular part drops out of v x* (I v) in the plane).
+            const float hx = I[1] * vw[i] + I[3] * vx[i];
+            const float hy = I[2] * vw[i] + I[5] * vy[i];
+            // External: applied forces plus drag on the com velocity and the spin.
+            const float comVx = vx[i] - vw[i] * o_y, comVy = vy[i] + vw[i] * o_x;
+            float Fx = fx[i] - m * params.drag * comVx;
+            float Fy = fy[i] - m * params.drag * comVy;
+            float T = ft[i] - inertia[i] * params.drag * vw[i];
+            if (i == 0) {
+                // Steering: spring-damper toward the target, and turn toward its heading.
+                Fx += params.headStiffness * (this->targetX - this->headX) + params.headDamping * (this->targetVx - comVx);
+                Fy += params.headStiffness * (this->targetY - this->headY) + params.headDamping * (this->targetVy - comVy);
+                const float speed = targetSpeed();
+                if (speed > 1e-3f) {
+                    const float turn = (dirX[0] * this->targetVy - dirY[0] * this->targetVx) / speed;
+                    T += params.headTurnStiffness * turn;
+                }
+                T -= params.headTurnDamping * vw[0];
+            }
+            pw[i] = (vx[i] * hy - vy[i] * hx) - (T + o_x * Fy - o_y * Fx);
+            px[i] = -vw[i] * hy - Fx;
+            py[i] = vw[i] * hx - Fy;
+        }
+
+        // Inward pass: fold each link's articulated inertia into its parent. With S =
+        // (1, 0, 0), U = IA S is IA's first column and D its corner.
+        for (size_t i = n - 1; i > 0; --i) {
+            const float *I = &ia[i * 6];
+            const float tau = -params.jointStiffness * q[i] - params.jointDamping * qd[i];
+            const float k = 1.f / I[0];
+            const float u = tau - pw[i];
+            uw[i] = I[0]; ux[i] = I[1]; uy[i] = I[2];
+            dInv[i] = k;
+            uTau[i] = u;
+
+            // Ia = IA - U U^T / D; pa = pA + Ia c + U u / D. Ia's first row and column
+            // vanish (the joint passes no torque), leaving the translational block.
+            const float a3 = I[3] - I[1] * I[1] * k, a4 = I[4] - I[1] * I[2] * k, a5 = I[5] - I[2] * I[2] * k;
+            const float uk = u * k;
+            const float pa_w = pw[i] + I[0] * uk;
+            const float pa_x = px[i] + a3 * bx[i] + a4 * by[i] + I[1] * uk;
+            const float pa_y = py[i] + a4 * bx[i] + a5 * by[i] + I[2] * uk;
+
+            // Shift to the parent frame (child origin at r from the parent's):
+            // f_p = (t + r x F, F), I_p = X^T Ia X with X the motion shift.
+            const float r_x = rx[i], r_y = ry[i];
+            float *P = &ia[(i - 1) * 6];
+            P[0] += r_y * r_y * a3 - 2.f * r_x * r_y * a4 + r_x * r_x * a5;
+            P[1] += -r_y * a3 + r_x * a4;
+            P[2] += -r_y * a4 + r_x * a5;
+            P[3] += a3; P[4] += a4; P[5] += a5;
+            pw[i - 1] += pa_w + r_x * pa_y - r_y * pa_x;
+            px[i - 1] += pa_x;
+            py[i - 1] += pa_y;
+        }
+
+        // Free head: a0 = -IA^-1 pA (symmetric 3x3 by cofactors).
+        {
+            const float *I = &ia[0];
+            const float c00 = I[3] * I[5] - I[4] * I[4];
+            const float c01 = I[2] * I[4] - I[1] * I[5];
+            const float c02 = I[1] * I[4] - I[2] * I[3];
+            const float c11 = I[0] * I[5] - I[2] * I[2];
+            const float c12 = I[1] * I[2] - I[0] * I[4];
+            const float c22 = I[0] * I[3] - I[1] * I[1];
+            const float det = I[0] * c00 + I[1] * c01 + I[2] * c02;
+            const float inv = -1.f / det;
+            aw[0] = inv * (c00 * pw[0] + c01 * px[0] + c02 * py[0]);
+            ax[0] = inv * (c01 * pw[0] + c11 * px[0] + c12 * py[0]);
+            ay[0] = inv * (c02 * pw[0] + c12 * px[0] + c22 * py[0]);
+        }
+
+        // Outward pass: joint accelerations, integrated semi-implicitly.
+        for (size_t i = 1; i < n; ++i) {
+            const float inW = aw[i - 1];
+            const float inX = ax[i - 1] - aw[i - 1] * ry[i] + bx[i];
+            const float inY = ay[i - 1] + aw[i - 1] * rx[i] + by[i];
+            const float qdd = (uTau[i] - (uw[i] * inW + ux[i] * inX + uy[i] * inY)) * dInv[i];
+            aw[i] = inW + qdd;
+            ax[i] = inX;
+            ay[i] = inY;
+            qd[i] += qdd * h;
+            q[i] += qd[i] * h;
+        }
+        // The head's classical acceleration is the spatial one plus w x v at its centre.
+        const float accX = ax[0] - this->headW * this->headVy, accY = ay[0] + this->headW * this->headVx;
+        this->headVx += accX * h;
+        this->headVy += accY * h;
+        this->headW += aw[0] * h;
+        this->headX += this->headVx * h;
+        this->headY += this->headVy * h;
+        this->headAngle = fastmath::approx::reduceAngle(this->headAngle + this->headW * h);
+    }
+
+    kinematics();
+    velocities();
+    for (size_t i = 0; i < n; ++i) {
+        linkVx[i] = vx[i] - vw[i] * oy[i];
+        linkVy[i] = vy[i] + vw[i] * ox[i];
+        linkW[i] = vw[i];
+    }
+    std::fill(fx.begin(), fx.end(), 0.f);
+    std::fill(fy.begin(), fy.end(), 0.f);
+    std::fill(ft.begin(), ft.end(), 0.f);
+}
+
+void ArticulatedChain::halt() {
+    this->headVx = this->headVy = this->headW = 0.f;
+    this->targetVx = this->targetVy = 0.f;
+    std::fill(qd.begin(), qd.end(), 0.f);
+    std::fill(linkVx.begin(), linkVx.end(), 0.f);
+    std::fill(linkVy.begin(), linkVy.end(), 0.f);
+    std::fill(linkW.begin(), linkW.end(), 0.f);
+}
+
+void ArticulatedChain::translate(float dx, float dy) {
+    this->headX += dx; this->headY += dy;
+    this->targetX += dx; this->targetY += dy;
+    this->lastTargetX += dx; this->lastTargetY += dy;
+}
+
+void ArticulatedChain::pointVelocity(size_t i, float x, float y, float &outX, float &outY) const {
+    outX = linkVx[i] - linkW[i] * (y - posY(i));
+    outY = linkVy[i] + linkW[i] * (x - posX(i));
+}
+
+float ArticulatedChain::maxSpeed() const {
+    float m = 0.f;
+    for (size_t i = 0; i < length.size(); ++i) {
+        m = std::max(m, std::max(std::sqrt(linkVx[i] * linkVx[i] + linkVy[i] * linkVy[i]), std::abs(linkW[i])));
+    }
+    return m;
+}
+
+float ArticulatedChain::targetSpeed() const {
+    return std::sqrt(this->targetVx * this->targetVx + this->targetVy * this->targetVy);
+}
+
+float ArticulatedChain::headTargetDistance() const {
+    return std::hypot(this->targetX - this->headX, this->targetY - this->headY);
+}
+
+} // namespace physics
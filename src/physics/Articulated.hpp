@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace physics {
+
+// Settings of the articulated spine. Forces are in mass units per (grid unit / s^2).
+struct ChainParams {
+    int substeps = 2;
+    float dt = 1.f / 60.f;          // length of one sim tick (seconds)
+    float linkMass = 1.f;
+    float jointStiffness = 30.f;    // torque per radian pulling each joint straight
+    float jointDamping = 4.f;       // torque per radian/s
+    float headStiffness = 400.f;    // head pulled toward its target (force per grid unit)
+    float headDamping = 40.f;       // ... against its velocity relative to the target's
+    float headTurnStiffness = 60.f; // head turned toward the target's direction of travel
+    float headTurnDamping = 8.f;
+    float drag = 0.5f;              // linear and angular damping of every link (1/s)
+};
+
+// The spine as a planar articulated chain: link 0 (the head) is a free body, every
+// further link hangs off its predecessor by a revolute joint. Forward dynamics use
+// Featherstone's articulated-body algorithm, so a step is O(links): one outward pass
+// for velocities, one inward pass folding each subtree into an articulated inertia, and
+// one outward pass for the accelerations.
+//
+// Planar spatial vectors are (angular, x, y). Each link's are expressed in its own frame:
+// world-aligned axes at its front joint (the head's at its centre), so passing a vector
+// between parent and child is a translation by the joint-to-joint offset, and quantities
+// stay as well-conditioned on link 1000 as on link 1. Each link is a rod whose forward
+// direction points at its predecessor; joint i sits at the rear end of link i-1.
+class ArticulatedChain {
+private:
+    // Links (SoA). q / qd: joint angle and rate of link i relative to link i-1 (unused
+    // for the head). fx / fy / ft: external force at the link centre and torque.
+    std::vector<float> length, inertia, q, qd, fx, fy, ft;
+    // Head (link 0) state: centre, angle and velocities.
+    float headX = 0.f, headY = 0.f, headAngle = 0.f;
+    float headVx = 0.f, headVy = 0.f, headW = 0.f;
+    float mass = 1.f;
+    // Head target, its position at the last step and a smoothed estimate of its velocity.
+    float targetX = 0.f, targetY = 0.f, lastTargetX = 0.f, lastTargetY = 0.f;
+    float targetVx = 0.f, targetVy = 0.f;
+
+    // Per-link kinematics of the current substep: direction, centre (relative to the
+    // head), frame offsets (see kinematics), spatial velocity and velocity-product bias.
+    std::vector<float> dirX, dirY, cx, cy, rx, ry, ox, oy;
+    std::vector<float> vw, vx, vy, bx, by;
+    // Articulated inertia (symmetric 3x3: 00 01 02 11 12 22), bias force, U = IA S,
+    // 1 / D with D = S.U, u = tau - S.pA, and spatial acceleration.
+    std::vector<float> ia, pw, px, py, uw, ux, uy, dInv, uTau, aw, ax, ay;
+    // Com velocities of the last step (world frame).
+    std::vector<float> linkVx, linkVy, linkW;
+
+    void kinematics();
+    void velocities();
+
+public:
+    // Links centred on (xs[i], ys[i]) with the given lengths; joint angles follow from
+    // the directions between consecutive centres.
+    void build(const float *xs, const float *ys, const float *lengths, size_t count, float linkMass);
+    size_t size() const { return length.size(); }
+
+    void setHeadTarget(float x, float y) { targetX = x; targetY = y; }
+    float targetPosX() const { return targetX; }
+    float targetPosY() const { return targetY; }
+    // Smoothed speed of the target (grid units / s).
+    float targetSpeed() const;
+    // Force (fx, fy) applied at world point (x, y) of link i, for the next step only.
+    void addForce(size_t i, float x, float y, float forceX, float forceY);
+    void step(const ChainParams &params);
+    // Drop all velocities (the body comes to rest where it is).
+    void halt();
+    // Move the chain and its head target by (dx, dy) without touching its motion (the
+    // floating origin moved; link positions are stored relative to the head).
+    void translate(float dx, float dy);
+
+    float posX(size_t i) const { return cx[i] + headX; }
+    float posY(size_t i) const { return cy[i] + headY; }
+    // Forward direction (toward the predecessor) of link i.
+    float forwardX(size_t i) const { return dirX[i]; }
+    float forwardY(size_t i) const { return dirY[i]; }
+    // World velocity of the point (x, y) of link i.
+    void pointVelocity(size_t i, float x, float y, float &outX, float &outY) const;
+    // Largest com speed / angular speed over all links.
+    float maxSpeed() const;
+    float headTargetDistance() const;
+};
+
+} // namespace physics
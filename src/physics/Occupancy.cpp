@@ -0,0 +1,91 @@
+#include "Occupancy.hpp"
+
+namespace physics {
+
+const Occupancy::Tile *Occupancy::findTile(int gx, int gy) const {
+    const uint64_t key = tileKey(gx, gy);
+    if (key != lastKey || lastSlot == kNoOwner) {
+        auto it = index.find(key);
+        if (it == index.end()) return nullptr;
+        lastKey = key;
+        lastSlot = it->second;
+    }
+    return &tiles[lastSlot];
+}
+
+Occupancy::Tile &Occupancy::tileFor(int gx, int gy) {
+    const uint64_t key = tileKey(gx, gy);
+    if (key == lastKey && lastSlot != kNoOwner) return tiles[lastSlot];
+    auto [it, inserted] = index.try_emplace(key, static_cast<uint32_t>(tiles.size()));
+    if (inserted) tiles.emplace_back();
+    lastKey = key;
+    lastSlot = it->second;
+    return tiles[lastSlot];
+}
+
+void Occupancy::clear() {
+    index.clear();
+    tiles.clear();
+    lastSlot = kNoOwner;
+    voxels = 0;
+}
+
+void Occupancy::add(int gx, int gy, uint32_t owner) {
+    Tile &t = tileFor(gx, gy);
+    const int c = cellIndex(gx, gy);
+    t.cells[c]++;
+    t.owner[c] = owner;
+    t.count++;
+    voxels++;
+}
+
+void Occupancy::remove(int gx, int gy) {
+    const Tile *found = findTile(gx, gy);
+    if (!found) return;
+    Tile &t = tiles[lastSlot];
+    const int c = cellIndex(gx, gy);
+    if (t.cells[c] == 0) return;
+    t.cells[c]--;
+    t.count--;
+    voxels--;
+}
+
+uint32_t Occupancy::count(int gx, int gy) const {
+    const Tile *t = findTile(gx, gy);
+    return (t && t->count) ? t->cells[cellIndex(gx, gy)] : 0;
+}
+
+uint32_t Occupancy::owner(int gx, int gy) const {
+    const Tile *t = findTile(gx, gy);
+    if (!t || !t->count) return kNoOwner;
+    const int c = cellIndex(gx, gy);
+    return t->cells[c] ? t->owner[c] : kNoOwner;
+}
+
+uint32_t Occupancy::tileCount(int gx, int gy) const {
+    const Tile *t = findTile(gx, gy);
+    return t ? t->count : 0;
+}
+
+bool Occupancy::anyIn(int x0, int y0, int x1, int y1) const {
+    if (voxels == 0) return false;
+    for (int ty = y0 >> kOccupancyTileShift; ty <= y1 >> kOccupancyTileShift; ++ty) {
+        for (int tx = x0 >> kOccupancyTileShift; tx <= x1 >> kOccupancyTileShift; ++tx) {
+            const Tile *t = findTile(tx << kOccupancyTileShift, ty << kOccupancyTileShift);
+            if (!t || !t->count) continue;
+            // Clip the rectangle to this tile and test its cells.
+            const int cx0 = tx == x0 >> kOccupancyTileShift ? x0 & (kOccupancyTile - 1) : 0;
+            const int cx1 = tx == x1 >> kOccupancyTileShift ? x1 & (kOccupancyTile - 1) : kOccupancyTile - 1;
+            const int cy0 = ty == y0 >> kOccupancyTileShift ? y0 & (kOccupancyTile - 1) : 0;
+            const int cy1 = ty == y1 >> kOccupancyTileShift ? y1 & (kOccupancyTile - 1) : kOccupancyTile - 1;
+            for (int cy = cy0; cy <= cy1; ++cy) {
+                for (int cx = cx0; cx <= cx1; ++cx) {
+                    if (t->cells[(cy << kOccupancyTileShift) | cx]) return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace physics
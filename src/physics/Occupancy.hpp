@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace physics {
+
+// Occupancy tiles are kOccupancyTile x kOccupancyTile grid cells.
+inline constexpr int kOccupancyTileShift = 3;
+inline constexpr int kOccupancyTile = 1 << kOccupancyTileShift;
+
+// Two-level occupancy of the grid by voxels: coarse tiles that count the voxels inside
+// them, holding fine cells that count theirs and remember the last voxel that entered.
+//
+// Only tiles that have held a voxel since the last clear exist (found through a hash of
+// the tile, with the last tile looked up cached: voxels of one body are added and queried
+// in runs that stay inside a tile). A query first tests its tile, so empty regions are
+// rejected with one lookup and a count, however many cells they span, and a voxel costs a
+// hash lookup per tile rather than per cell.
+//
+// Owners are opaque ids (see `packOwner`). A cell keeps the id of the voxel added last;
+// after that voxel is removed while others remain, the cell still reports it.
+class Occupancy {
+public:
+    static constexpr uint32_t kNoOwner = 0xffffffffu;
+
+    // Owner id of voxel `voxel` of segment `segment` (up to 65536 voxels per segment).
+    static constexpr uint32_t packOwner(int segment, int voxel) {
+        return (static_cast<uint32_t>(segment) << 16) | static_cast<uint32_t>(voxel);
+    }
+    static constexpr int ownerSegment(uint32_t owner) { return static_cast<int>(owner >> 16); }
+    static constexpr int ownerVoxel(uint32_t owner) { return static_cast<int>(owner & 0xffffu); }
+
+private:
+    static constexpr int kCells = kOccupancyTile * kOccupancyTile;
+    struct Tile {
+        uint32_t count = 0;  // voxels in the tile
+        uint16_t cells[kCells] = {};
+        uint32_t owner[kCells];
+    };
+
+    std::unordered_map<uint64_t, uint32_t> index;  // tile key -> slot in `tiles`
+    std::vector<Tile> tiles;
+    // Last tile looked up (key and slot; slot kNoOwner = the tile does not exist).
+    mutable uint64_t lastKey = 0;
+    mutable uint32_t lastSlot = kNoOwner;
+    size_t voxels = 0;
+
+    static uint64_t tileKey(int gx, int gy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(gx >> kOccupancyTileShift)) << 32)
+               | static_cast<uint32_t>(gy >> kOccupancyTileShift);
+    }
+    static int cellIndex(int gx, int gy) {
+        return ((gy & (kOccupancyTile - 1)) << kOccupancyTileShift) | (gx & (kOccupancyTile - 1));
+    }
+    const Tile *findTile(int gx, int gy) const;
+    Tile &tileFor(int gx, int gy);
+
+public:
+    // Forget every voxel (keeps the storage for the next fill).
+    void clear();
+
+    // Voxel `owner` enters / leaves cell (gx, gy).
+    void add(int gx, int gy, uint32_t owner);
+    void remove(int gx, int gy);
+
+    // Voxels in cell (gx, gy), and the last one added there (kNoOwner if it is empty).
+    uint32_t count(int gx, int gy) const;
+    uint32_t owner(int gx, int gy) const;
+    bool occupied(int gx, int gy) const { return count(gx, gy) != 0; }
+    // Voxels in the tile holding cell (gx, gy).
+    uint32_t tileCount(int gx, int gy) const;
+    // Whether any voxel lies in cells [x0, x1] x [y0, y1]: tile counts first, cells only
+    // in the tiles that hold something.
+    bool anyIn(int x0, int y0, int x1, int y1) const;
+
+    size_t voxelCount() const { return voxels; }
+    size_t tilesUsed() const { return tiles.size(); }
+};
+
+} // namespace physics
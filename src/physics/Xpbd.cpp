@@ -0,0 +1,346 @@
+#include "Xpbd.hpp"
+#include "../math/Rot2.hpp"
+#include "../math/FastMath.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace physics {
+
+uint32_t XpbdSolver::addParticle(float px, float py, float inverseMass, uint32_t contactGroup) {
+    x.push_back(px); y.push_back(py);
+    prevX.push_back(px); prevY.push_back(py);
+    fromX.push_back(px); fromY.push_back(py);
+    vx.push_back(0.f); vy.push_back(0.f);
+    invMass.push_back(inverseMass);
+    group.push_back(contactGroup);
+    return static_cast<uint32_t>(x.size() - 1);
+}
+
+void XpbdSolver::addConstraint(const Constraint &c, size_t rows) {
+    constraints.push_back(c);
+    lambdaBegin.push_back(static_cast<uint32_t>(lambda.size()));
+    lambda.resize(lambda.size() + rows, 0.f);
+    colored = false;
+}
+
+void XpbdSolver::addDistance(uint32_t a, uint32_t b, float length, float compliance) {
+    Constraint c{Kind::Distance, static_cast<uint32_t>(ids.size()), 2, 0, length, compliance};
+    ids.push_back(a);
+    ids.push_back(b);
+    addConstraint(c, 1);
+}
+
+void XpbdSolver::addShape(const uint32_t *particles, size_t count, float compliance) {
+    Constraint c{Kind::Shape, static_cast<uint32_t>(ids.size()), static_cast<uint32_t>(count),
+                 static_cast<uint32_t>(restX.size()), 0.f, compliance};
+    float cx = 0.f, cy = 0.f;
+    for (size_t i = 0; i < count; ++i) { cx += x[particles[i]]; cy += y[particles[i]]; }
+    cx /= static_cast<float>(count);
+    cy /= static_cast<float>(count);
+    for (size_t i = 0; i < count; ++i) {
+        ids.push_back(particles[i]);
+        restX.push_back(x[particles[i]] - cx);
+        restY.push_back(y[particles[i]] - cy);
+    }
+    addConstraint(c, count);
+}
+
+void XpbdSolver::addAttachment(const uint32_t *particles, size_t count, uint32_t anchor,
+                               float offsetX, float offsetY, float compliance) {
+    Constraint c{Kind::Attach, static_cast<uint32_t>(ids.size()), static_cast<uint32_t>(count),
+                 static_cast<uint32_t>(restX.size()), 0.f, compliance};
+    ids.insert(ids.end(), particles, particles + count);
+    ids.push_back(anchor);
+    restX.push_back(offsetX);
+    restY.push_back(offsetY);
+    addConstraint(c, 1);
+}
+
+void XpbdSolver::clear() {
+    for (auto *v : {&x, &y, &prevX, &prevY, &vx, &vy, &invMass, &fromX, &fromY, &restX, &restY, &lambda}) v->clear();
+    group.clear();
+    constraints.clear();
+    ids.clear();
+    lambdaBegin.clear();
+    batched.clear();
+    batchBegin.clear();
+    colored = false;
+    stats = XpbdStats{};
+}
+
+void XpbdSolver::translate(float dx, float dy) {
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] += dx; prevX[i] += dx; fromX[i] += dx;
+        y[i] += dy; prevY[i] += dy; fromY[i] += dy;
+    }
+}
+
+// Greedy colouring: each constraint takes the lowest colour none of its particles has been
+// given yet (tracked as a 64-bit mask per particle). Batches are then a counting sort by
+// colour, with the overflow as the last batch.
+void XpbdSolver::colorBatches(const std::vector<Constraint> &list, const std::vector<uint32_t> &listIds,
+                              std::vector<uint32_t> &outBatched, std::vector<uint32_t> &outBegin, size_t &overflow) {
+    constexpr int kOverflow = 64;
+    colorMask.assign(x.size(), 0);
+    std::vector<uint8_t> colorOf(list.size());
+    int used = 0;
+    overflow = 0;
+    for (size_t k = 0; k < list.size(); ++k) {
+        const uint32_t *p = listIds.data() + list[k].first;
+        const uint32_t n = list[k].kind == Kind::Attach ? list[k].count + 1 : list[k].count;
+        uint64_t taken = 0;
+        for (uint32_t i = 0; i < n; ++i) taken |= colorMask[p[i]];
+        if (taken == ~uint64_t(0)) {
+            colorOf[k] = kOverflow;
+            overflow++;
+            continue;
+        }
+        const int color = std::countr_one(taken);
+        colorOf[k] = static_cast<uint8_t>(color);
+        used = std::max(used, color + 1);
+        for (uint32_t i = 0; i < n; ++i) colorMask[p[i]] |= uint64_t(1) << color;
+    }
+
+    // Batch b spans [outBegin[b], outBegin[b + 1]); batch `used` is the overflow.
+    outBegin.assign(static_cast<size_t>(used) + 2, 0);
+    for (uint8_t c : colorOf) outBegin[(c == kOverflow ? used : c) + 1]++;
+    for (size_t b = 1; b < outBegin.size(); ++b) outBegin[b] += outBegin[b - 1];
+    outBatched.resize(list.size());
+    std::vector<uint32_t> cursor(outBegin.begin(), outBegin.end() - 1);
+    for (size_t k = 0; k < list.size(); ++k) {
+        const int b = colorOf[k] == kOverflow ? used : colorOf[k];
+        outBatched[cursor[b]++] = static_cast<uint32_t>(k);
+    }
+}
+
+void XpbdSolver::color() {
+    colorBatches(constraints, ids, batched, batchBegin, stats.overflow);
+    stats.colors = batchBegin.size() - 2;
+    colored = true;
+}
+
+bool XpbdSolver::coloringValid() const {
+    auto check = [&](const std::vector<Constraint> &list, const std::vector<uint32_t> &listIds,
+                     const std::vector<uint32_t> &order, const std::vector<uint32_t> &begin) {
+        std::vector<uint32_t> stamp(x.size(), 0);
+        for (size_t b = 0; b + 2 < begin.size(); ++b) {  // every batch but the overflow
+            for (uint32_t k = begin[b]; k < begin[b + 1]; ++k) {
+                const Constraint &c = list[order[k]];
+                const uint32_t n = c.kind == Kind::Attach ? c.count + 1 : c.count;
+                for (uint32_t i = 0; i < n; ++i) {
+                    uint32_t &s = stamp[listIds[c.first + i]];
+                    if (s == b + 1) return false;
+                    s = static_cast<uint32_t>(b + 1);
+                }
+            }
+        }
+        return true;
+    };
+    return check(constraints, ids, batched, batchBegin) && check(contacts, contactIds, contactBatched, contactBatchBegin);
+}
+
+// Candidate pairs of particles in different groups closer than twice the radius plus a
+// margin, via a hashed grid of reach-sized cells. Found once per tick, so the margin
+// covers how far two particles can close on each other during the tick (each moving at
+// most the fastest particle's travel); each substep only pushes apart the ones actually
+// overlapping.
+void XpbdSolver::findContacts(const XpbdParams &params) {
+    contacts.clear();
+    contactIds.clear();
+    float travel2 = 0.f;
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (group[i] == kNoGroup) continue;
+        const float dx = invMass[i] > 0.f ? vx[i] * params.dt : x[i] - fromX[i];
+        const float dy = invMass[i] > 0.f ? vy[i] * params.dt : y[i] - fromY[i];
+        travel2 = std::max(travel2, dx * dx + dy * dy);
+    }
+    const float diameter = 2.f * params.voxelRadius;
+    const float reach = diameter * 1.5f + 2.f * fastmath::sqrt(travel2);
+    const float invCell = 1.f / reach;
+    size_t tableSize = 64;
+    while (tableSize < x.size() * 2) tableSize <<= 1;
+    const uint32_t mask = static_cast<uint32_t>(tableSize - 1);
+    constexpr uint32_t kEmpty = 0xffffffffu;
+    cellHead.assign(tableSize, kEmpty);
+    cellNext.assign(x.size(), kEmpty);
+    auto cellHash = [mask](int cx, int cy) {
+        return (static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u) & mask;
+    };
+    for (uint32_t i = 0; i < x.size(); ++i) {
+        if (group[i] == kNoGroup) continue;
+        const uint32_t h = cellHash(static_cast<int>(std::floor(x[i] * invCell)), static_cast<int>(std::floor(y[i] * invCell)));
+        cellNext[i] = cellHead[h];
+        cellHead[h] = i;
+    }
+    for (uint32_t i = 0; i < x.size(); ++i) {
+        if (group[i] == kNoGroup) continue;
+        const int cx = static_cast<int>(std::floor(x[i] * invCell)), cy = static_cast<int>(std::floor(y[i] * invCell));
+        for (int oy = -1; oy <= 1; ++oy) {
+            for (int ox = -1; ox <= 1; ++ox) {
+                for (uint32_t j = cellHead[cellHash(cx + ox, cy + oy)]; j != kEmpty; j = cellNext[j]) {
+                    // Each pair once; hash collisions are filtered by the distance test.
+                    if (j <= i || group[j] == group[i]) continue;
+                    const float dx = x[i] - x[j], dy = y[i] - y[j];
+                    if (dx * dx + dy * dy >= reach * reach) continue;
+                    contacts.push_back(Constraint{Kind::Contact, static_cast<uint32_t>(contactIds.size()), 2, 0, diameter, params.contactCompliance});
+                    contactIds.push_back(i);
+                    contactIds.push_back(j);
+                }
+            }
+        }
+    }
+    // A pair can be reported from two neighbouring cells when they hash together; that
+    // only repeats a projection, which is harmless.
+    size_t contactOverflow = 0;
+    colorBatches(contacts, contactIds, contactBatched, contactBatchBegin, contactOverflow);
+    contactLambda.assign(contacts.size(), 0.f);
+    stats.contacts = contacts.size();
+    stats.contactColors = contactBatchBegin.size() - 2;
+}
+
+void XpbdSolver::project(const Constraint &c, const uint32_t *p, float *rowLambda, float alphaScale) {
+    const float alpha = c.compliance * alphaScale;
+    switch (c.kind) {
+    case Kind::Distance:
+    case Kind::Contact: {
+        const uint32_t a = p[0], b = p[1];
+        const float dx = x[a] - x[b], dy = y[a] - y[b];
+        const float d = fastmath::sqrt(dx * dx + dy * dy);
+        if (d < 1e-6f) return;
+        const float C = d - c.length;
+        if (c.kind == Kind::Contact && C >= 0.f) return;  // only pushes, never pulls
+        const float w = invMass[a] + invMass[b];
+        if (w <= 0.f) return;
+        const float dl = (-C - alpha * rowLambda[0]) / (w + alpha);
+        rowLambda[0] += dl;
+        const float nx = dx / d * dl, ny = dy / d * dl;
+        x[a] += invMass[a] * nx; y[a] += invMass[a] * ny;
+        x[b] -= invMass[b] * nx; y[b] -= invMass[b] * ny;
+        break;
+    }
+    case Kind::Shape: {
+        // Best-fit rotation of the rest shape onto the current positions: the angle of
+        // sum((x_i - c) x q_i) over sum((x_i - c) . q_i), as a unit complex (no trig).
+        const float n = static_cast<float>(c.count);
+        float cx = 0.f, cy = 0.f;
+        for (uint32_t i = 0; i < c.count; ++i) { cx += x[p[i]]; cy += y[p[i]]; }
+        cx /= n; cy /= n;
+        float dotSum = 0.f, crossSum = 0.f;
+        for (uint32_t i = 0; i < c.count; ++i) {
+            const float dx = x[p[i]] - cx, dy = y[p[i]] - cy;
+            const float qx = restX[c.rest + i], qy = restY[c.rest + i];
+            dotSum += dx * qx + dy * qy;
+            crossSum += qx * dy - qy * dx;
+        }
+        const math::Rot2 r = math::Rot2::fromVector(dotSum, crossSum);
+        for (uint32_t i = 0; i < c.count; ++i) {
+            const uint32_t k = p[i];
+            if (invMass[k] <= 0.f) continue;
+            const float qx = restX[c.rest + i], qy = restY[c.rest + i];
+            const float ex = x[k] - (cx + r.c * qx - r.s * qy), ey = y[k] - (cy + r.s * qx + r.c * qy);
+            const float C = fastmath::sqrt(ex * ex + ey * ey);
+            if (C < 1e-7f) continue;
+            const float dl = (-C - alpha * rowLambda[i]) / (invMass[k] + alpha);
+            rowLambda[i] += dl;
+            x[k] += invMass[k] * dl * ex / C;
+            y[k] += invMass[k] * dl * ey / C;
+        }
+        break;
+    }
+    case Kind::Attach: {
+        const float n = static_cast<float>(c.count);
+        const uint32_t anchor = p[c.count];
+        float cx = 0.f, cy = 0.f, w = 0.f;
+        for (uint32_t i = 0; i < c.count; ++i) { cx += x[p[i]]; cy += y[p[i]]; w += invMass[p[i]]; }
+        cx /= n; cy /= n;
+        const float ex = cx - (x[anchor] + restX[c.rest]), ey = cy - (y[anchor] + restY[c.rest]);
+        const float C = fastmath::sqrt(ex * ex + ey * ey);
+        if (C < 1e-7f) return;
+        // Gradient: 1/n per blob particle, -1 for the anchor.
+        const float denom = w / (n * n) + invMass[anchor] + alpha;
+        if (denom <= 0.f) return;
+        const float dl = (-C - alpha * rowLambda[0]) / denom;
+        rowLambda[0] += dl;
+        const float nx = ex / C * dl, ny = ey / C * dl;
+        for (uint32_t i = 0; i < c.count; ++i) {
+            x[p[i]] += invMass[p[i]] / n * nx;
+            y[p[i]] += invMass[p[i]] / n * ny;
+        }
+        x[anchor] -= invMass[anchor] * nx;
+        y[anchor] -= invMass[anchor] * ny;
+        break;
+    }
+    }
+}
+
+void XpbdSolver::step(const XpbdParams &params) {
+    if (!colored) color();
+    findContacts(params);
+    stats.constraints = constraints.size();
+
+    const int substeps = std::max(1, params.substeps);
+    const int iterations = std::max(1, params.iterations);
+    const float h = params.dt / static_cast<float>(substeps);
+    const float alphaScale = 1.f / (h * h);
+    const float keep = std::max(0.f, 1.f - params.damping * h);
+    const size_t n = x.size();
+
+    // Kinematic targets for this tick; the particles restart from last tick's position.
+    kinTargetX.clear();
+    kinTargetY.clear();
+    for (size_t i = 0; i < n; ++i) {
+        if (invMass[i] > 0.f) continue;
+        kinTargetX.push_back(x[i]);
+        kinTargetY.push_back(y[i]);
+        x[i] = fromX[i];
+        y[i] = fromY[i];
+    }
+
+    for (int s = 0; s < substeps; ++s) {
+        const float t = static_cast<float>(s + 1) / static_cast<float>(substeps);
+        for (size_t i = 0, k = 0; i < n; ++i) {
+            prevX[i] = x[i];
+            prevY[i] = y[i];
+            if (invMass[i] <= 0.f) {
+                x[i] = fromX[i] + (kinTargetX[k] - fromX[i]) * t;
+                y[i] = fromY[i] + (kinTargetY[k] - fromY[i]) * t;
+                ++k;
+                continue;
+            }
+            vx[i] *= keep;
+            vy[i] *= keep;
+            x[i] += h * vx[i];
+            y[i] += h * vy[i];
+        }
+        // Multipliers restart every substep (small steps: one sweep is usually enough).
+        std::fill(lambda.begin(), lambda.end(), 0.f);
+        std::fill(contactLambda.begin(), contactLambda.end(), 0.f);
+        for (int it = 0; it < iterations; ++it) {
+            for (size_t b = 0; b + 1 < batchBegin.size(); ++b) {
+                for (uint32_t k = batchBegin[b]; k < batchBegin[b + 1]; ++k) {
+                    const uint32_t ci = batched[k];
+                    project(constraints[ci], ids.data() + constraints[ci].first, lambda.data() + lambdaBegin[ci], alphaScale);
+                }
+            }
+            for (size_t b = 0; b + 1 < contactBatchBegin.size(); ++b) {
+                for (uint32_t k = contactBatchBegin[b]; k < contactBatchBegin[b + 1]; ++k) {
+                    const uint32_t ci = contactBatched[k];
+                    project(contacts[ci], contactIds.data() + contacts[ci].first, contactLambda.data() + ci, alphaScale);
+                }
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (invMass[i] <= 0.f) { vx[i] = vy[i] = 0.f; continue; }
+            vx[i] = (x[i] - prevX[i]) / h;
+            vy[i] = (y[i] - prevY[i]) / h;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (invMass[i] > 0.f) continue;
+        fromX[i] = x[i];
+        fromY[i] = y[i];
+    }
+}
+
+} // namespace physics
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+// Solver settings. Compliance is the inverse stiffness (0 = rigid); because XPBD scales
+// it by the substep length, a given compliance gives the same stiffness for any substep
+// and iteration count, and the cost per tick is fixed by those counts alone.
+struct XpbdParams {
+    int substeps = 4;
+    int iterations = 1;            // constraint sweeps per substep
+    float dt = 1.f / 60.f;         // length of one sim tick (seconds)
+    float spineCompliance = 0.f;   // distance between consecutive segments
+    float shapeCompliance = 1e-4f; // voxel blob shape matching
+    float attachCompliance = 1e-3f;// blob centroid to its segment
+    float contactCompliance = 0.f; // voxel vs. voxel of another blob
+    float damping = 4.f;           // velocity damping (1/s)
+    float voxelRadius = 0.5f;      // contact radius of a voxel particle (grid units)
+};
+
+// Per-step counters.
+struct XpbdStats {
+    size_t constraints = 0;
+    size_t contacts = 0;
+    size_t colors = 0;             // batches of the static constraints
+    size_t contactColors = 0;      // batches of this step's contacts
+    size_t overflow = 0;           // constraints that found no free colour (solved serially)
+};
+
+// Extended position-based dynamics (XPBD) for 2D particles.
+//
+// Constraints: distance between two particles, shape matching of a blob to its rest
+// shape (best-fit rotation, no trig), attachment of a blob's centroid to an anchor
+// particle, and contacts between particles of different groups (found each step through
+// a spatial hash).
+//
+// Constraints are greedily graph-coloured so that no two constraints of one colour share
+// a particle: every constraint of a colour batch can be projected in parallel without
+// races, and solving the batches one after another gives the same result as a serial
+// Gauss-Seidel sweep in colour order. (The batches are walked on the calling thread here;
+// the colouring is what makes handing them to a parallel-for safe.)
+class XpbdSolver {
+public:
+    static constexpr uint32_t kNoGroup = 0xffffffffu;
+
+private:
+    enum class Kind : uint8_t { Distance, Shape, Attach, Contact };
+    struct Constraint {
+        Kind kind;
+        uint32_t first, count;  // particle ids in `ids` (Attach: blob, then the anchor)
+        uint32_t rest;          // Shape / Attach: first rest offset in restX / restY
+        float length;           // Distance / Contact: rest length
+        float compliance;
+    };
+
+    // Particles (SoA). `fromX/Y`: where each kinematic particle was at the end of the
+    // last step; it moves from there to its new position evenly over the substeps.
+    std::vector<float> x, y, prevX, prevY, vx, vy, invMass, fromX, fromY;
+    std::vector<uint32_t> group;  // contact group; kNoGroup = no contacts
+
+    std::vector<Constraint> constraints;
+    std::vector<uint32_t> ids;
+    std::vector<float> restX, restY;
+    // Lagrange multipliers, one per constraint row (a shape has one row per particle).
+    std::vector<float> lambda;
+    std::vector<uint32_t> lambdaBegin;
+
+    // Colour batches: constraint indices grouped by colour; the last batch holds the
+    // overflow (constraints that found no free colour).
+    std::vector<uint32_t> batched, batchBegin;
+    bool colored = false;
+
+    // Contacts rebuilt every step (also coloured), and the spatial hash used to find them.
+    std::vector<Constraint> contacts;
+    std::vector<uint32_t> contactIds;
+    std::vector<float> contactLambda;
+    std::vector<uint32_t> contactBatched, contactBatchBegin;
+    std::vector<uint32_t> cellHead, cellNext;
+    std::vector<uint64_t> colorMask;  // scratch: colours used per particle
+    std::vector<float> kinTargetX, kinTargetY;  // scratch: kinematic targets of a step
+
+    XpbdStats stats;
+
+    void addConstraint(const Constraint &c, size_t rows);
+    void colorBatches(const std::vector<Constraint> &list, const std::vector<uint32_t> &listIds,
+                      std::vector<uint32_t> &outBatched, std::vector<uint32_t> &outBegin, size_t &overflow);
+    void findContacts(const XpbdParams &params);
+    void project(const Constraint &c, const uint32_t *p, float *rowLambda, float alphaScale);
+
+public:
+    uint32_t addParticle(float px, float py, float inverseMass, uint32_t contactGroup = kNoGroup);
+    size_t particleCount() const { return x.size(); }
+
+    // Keep particles `a` and `b` at `length` apart.
+    void addDistance(uint32_t a, uint32_t b, float length, float compliance);
+    // Hold `count` particles in their current shape (rotation allowed).
+    void addShape(const uint32_t *particles, size_t count, float compliance);
+    // Hold the centroid of `count` particles at `anchor` + (offsetX, offsetY).
+    void addAttachment(const uint32_t *particles, size_t count, uint32_t anchor,
+                       float offsetX, float offsetY, float compliance);
+    void clear();
+
+    // Greedy colouring of the static constraints; called by `step` when stale.
+    void color();
+
+    // Advance one tick (`params.substeps` substeps). Particles with zero inverse mass are
+    // kinematic: move them with `setPosition` before the step, and the step sweeps them
+    // there over its substeps instead of teleporting them in the first.
+    void step(const XpbdParams &params);
+
+    void setPosition(uint32_t i, float px, float py) { x[i] = px; y[i] = py; }
+    // Teleport without velocity (re-sync after the body was moved by other code).
+    void resetPosition(uint32_t i, float px, float py) {
+        x[i] = prevX[i] = fromX[i] = px;
+        y[i] = prevY[i] = fromY[i] = py;
+        vx[i] = vy[i] = 0.f;
+    }
+    // Move every particle by (dx, dy), keeping velocities (the floating origin moved).
+    void translate(float dx, float dy);
+    float posX(uint32_t i) const { return x[i]; }
+    float posY(uint32_t i) const { return y[i]; }
+    float velX(uint32_t i) const { return vx[i]; }
+    float velY(uint32_t i) const { return vy[i]; }
+
+    const XpbdStats &lastStats() const { return stats; }
+    // True when no two constraints in any colour batch share a particle.
+    bool coloringValid() const;
+};
+
+} // namespace physics
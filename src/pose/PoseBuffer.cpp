@@ -0,0 +1,102 @@
+#include "PoseBuffer.hpp"
+#include "../../include/Centipede.hpp"
+#include "../morph/Morphology.hpp"
+#include "../math/FastMath.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace pose {
+
+void buildPose(const std::vector<Segment> &segments, PoseBuffer &pose) {
+    const size_t segCount = segments.size();
+    pose.spineX.resize(segCount);
+    pose.spineY.resize(segCount);
+    pose.spineZ.resize(segCount);
+    pose.legBegin.resize(segCount + 1);
+
+    uint32_t legCount = 0;
+    for (size_t i = 0; i < segCount; ++i) {
+        pose.legBegin[i] = legCount;
+        legCount += static_cast<uint32_t>(segments[i].legs.size());
+    }
+    pose.legBegin[segCount] = legCount;
+    for (int j = 0; j < JointCount; ++j) {
+        pose.x[j].resize(legCount);
+        pose.y[j].resize(legCount);
+        pose.z[j].resize(legCount);
+    }
+
+    for (size_t i = 0; i < segCount; ++i) {
+        const auto &seg = segments[i];
+        const float bodyZ = seg.bodyZ;
+        pose.spineX[i] = seg.x;
+        pose.spineY[i] = seg.y;
+        pose.spineZ[i] = bodyZ;
+
+        // Same attachment frame as the IK pass.
+        float spineX = 0.f, spineY = 0.f;
+        if (i < segCount - 1) {
+            spineX = segments[i + 1].x - seg.x;
+            spineY = segments[i + 1].y - seg.y;
+        } else if (i > 0) {
+            spineX = seg.x - segments[i - 1].x;
+            spineY = seg.y - segments[i - 1].y;
+        } else {
+            spineX = 1.f;
+            spineY = 0.f;
+        }
+        float spineLen = fastmath::sqrt(spineX * spineX + spineY * spineY);
+        if (spineLen < 0.001f) { spineX = 1.f; spineY = 0.f; spineLen = 1.f; }
+        spineX /= spineLen;
+        spineY /= spineLen;
+        const float perpX = -spineY;
+        const float perpY = spineX;
+
+        const float midX = (i < segCount - 1) ? (seg.x + segments[i + 1].x) * 0.5f : seg.x;
+        const float midY = (i < segCount - 1) ? (seg.y + segments[i + 1].y) * 0.5f : seg.y;
+
+        for (size_t k = 0; k < seg.legs.size(); ++k) {
+            const auto &leg = seg.legs[k];
+            const uint32_t l = pose.legBegin[i] + static_cast<uint32_t>(k);
+            const float side = static_cast<float>(leg.side);
+
+            const float attachX = midX + perpX * (kStanceWidth * side);
+            const float attachY = midY + perpY * (kStanceWidth * side);
+            const float coxaEndX = attachX + perpX * leg.coxaLength * side;
+            const float coxaEndY = attachY + perpY * leg.coxaLength * side;
+
+            // Hip yaw gives the horizontal leg direction; the pitch joints lift it out of plane.
+            morph::LegChain<3> chain;
+            chain.length = {leg.hipLength, leg.kneeLength, leg.footLength};
+            const morph::LegChain<3>::Angles angles = {leg.kneeAngle, leg.footAngle, leg.ankleAngle};
+            morph::LegChain<3>::Points px, py, pz;
+            chain.forwardWorld(angles, coxaEndX, coxaEndY, bodyZ, leg.hipYaw.c, leg.hipYaw.s, px, py, pz);
+
+            pose.x[HipAttach][l] = attachX; pose.y[HipAttach][l] = attachY; pose.z[HipAttach][l] = bodyZ;
+            pose.x[CoxaEnd][l] = px[0];     pose.y[CoxaEnd][l] = py[0];     pose.z[CoxaEnd][l] = pz[0];
+            pose.x[Knee][l] = px[1];        pose.y[Knee][l] = py[1];        pose.z[Knee][l] = pz[1];
+            pose.x[Ankle][l] = px[2];       pose.y[Ankle][l] = py[2];       pose.z[Ankle][l] = pz[2];
+            // Keep the foot from floating above the ground at its hold (z <= 0 on flat ground).
+            pose.x[Foot][l] = px[3];        pose.y[Foot][l] = py[3];        pose.z[Foot][l] = std::min(pz[3], leg.footHoldZ);
+        }
+    }
+}
+
+void offsetBody(PoseBuffer &pose, float dz) {
+    for (float &z : pose.spineZ) z += dz;
+    for (float &z : pose.z[HipAttach]) z += dz;
+    for (float &z : pose.z[CoxaEnd]) z += dz;
+    for (float &z : pose.z[Knee]) z += dz * 0.5f;
+    for (float &z : pose.z[Ankle]) z += dz * 0.25f;
+}
+
+void translate(PoseBuffer &pose, float dx, float dy) {
+    for (float &x : pose.spineX) x += dx;
+    for (float &y : pose.spineY) y += dy;
+    for (int j = 0; j < JointCount; ++j) {
+        for (float &x : pose.x[j]) x += dx;
+        for (float &y : pose.y[j]) y += dy;
+    }
+}
+
+} // namespace pose
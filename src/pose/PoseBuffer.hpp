@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Included from include/Centipede.hpp, so only a forward declaration here.
+struct Segment;
+
+namespace pose {
+
+// Leg joints stored per leg, from the body outward.
+enum Joint : int {
+    HipAttach = 0, // coxa start on the body
+    CoxaEnd,       // hip joint (end of the coxa)
+    Knee,
+    Ankle,
+    Foot,
+    JointCount
+};
+
+// World-space pose of a centipede, written once per tick by the sim after IK.
+// Structure-of-arrays: one float array per joint and axis, indexed by flat leg index;
+// segment `s` owns legs [legBegin[s], legBegin[s + 1]). The renderer, contact checks and
+// telemetry read this instead of re-running forward kinematics.
+struct PoseBuffer {
+    // Spine joints (one per segment) at body height.
+    std::vector<float> spineX, spineY, spineZ;
+
+    std::vector<uint32_t> legBegin;
+    std::array<std::vector<float>, JointCount> x, y, z;
+
+    size_t segmentCount() const { return spineX.size(); }
+    size_t legCount() const { return x[0].size(); }
+};
+
+// Forward kinematics for every leg from the solved joint angles. Foot z is clipped to
+// the ground height at the leg's hold (z <= 0 on flat ground) as the renderer always did,
+// so a foot at its hold's height is touching the ground.
+// Each segment's spine point and hips sit at its own body height (Segment::bodyZ).
+void buildPose(const std::vector<Segment> &segments, PoseBuffer &pose);
+
+// Raise the body by `dz` in place (spine, hip attach and coxa end; knees by half, ankles
+// by a quarter) with the feet left where they are. A cosmetic offset for poses that are
+// not rebuilt.
+void offsetBody(PoseBuffer &pose, float dz);
+
+// Move every joint by (dx, dy) in the ground plane (the floating origin moved).
+void translate(PoseBuffer &pose, float dx, float dy);
+
+} // namespace pose
@@ -1,118 +1,52 @@
 
 #include "DrawHelpers.hpp"
+#include "../math/FastMath.hpp"
 #include <cmath>
 #include <algorithm>
 
 namespace drawhelpers {
 
-void drawCentipede(sf::RenderWindow* window, const std::vector<Segment> &segments, float resf, float bodyZ) {
-    for (size_t i = 0; i < segments.size() - 1; ++i) {
-        float spineX = segments[i+1].x - segments[i].x;
-        float spineY = segments[i+1].y - segments[i].y;
-        float spineLen = std::sqrt(spineX*spineX + spineY*spineY);
-        if (spineLen < 0.001f) { spineX = 1.f; spineY = 0.f; spineLen = 1.f; }
-        spineX /= spineLen;
-        spineY /= spineLen;
-        float perpX = -spineY;
-        float perpY = spineX;
-
-        float midX = (segments[i].x + segments[i+1].x) * 0.5f;
-        float midY = (segments[i].y + segments[i+1].y) * 0.5f;
-
-        const float stanceWidth = kStanceWidth;
-
-        for (int side = -1; side <= 1; side += 2) {
-            // Draw one leg on each side of the segment pair (left/right)
-            const auto &leg = segments[i].legs[side == -1 ? 0 : 1];
-
-            // Hip attachment point on the spine (midpoint offset by perpendicular)
-            float hipAttachX = midX + perpX * (stanceWidth * static_cast<float>(side));
-            float hipAttachY = midY + perpY * (stanceWidth * static_cast<float>(side));
-
-            // Coxa end: short link from body to the hip joint. `coxaLength` is in
-            // grid units; the 'side' multiplier places it left/right of the spine.
-            float coxaEndX = hipAttachX + perpX * leg.coxaLength * static_cast<float>(side);
-            float coxaEndY = hipAttachY + perpY * leg.coxaLength * static_cast<float>(side);
-            float hipZ = bodyZ; // body elevation in grid units
-
-            // Current joint angles (radians) computed by IK/gait:
-            // - yaw: rotation around vertical axis, used to compute horizontal dir
-            // - hipPitch: angle of first leg link in pitch (up/down)
-            // - knee: additional pitch contributed by the knee joint
-            float yaw = leg.hipAngle;
-            float hipPitch = leg.kneeAngle;
-            float knee = leg.footAngle;
-
-            // Direction vector in the horizontal plane for the leg foot projection.
-            // We interpret `yaw` such that (cos(yaw), sin(yaw)) points along the
-            // leg's forward direction in grid-space.
-            float dirX = std::cos(yaw);
-            float dirY = std::sin(yaw);
-
-            // Hip joint position (end of the coxa)
-            float hipX = coxaEndX;
-            float hipY = coxaEndY;
-
-            // Compute knee position using standard forward kinematics for a planar
-            // chain where pitch controls vertical lift and cos(pitch) scales horizontal reach.
-            // Formulas:
-            //   knee_xy = hip_xy + dir * (hipLength * cos(hipPitch))
-            //   knee_z  = hip_z  +       (hipLength * sin(hipPitch))
-            float kneeX = hipX + dirX * (leg.hipLength * std::cos(hipPitch));
-            float kneeY = hipY + dirY * (leg.hipLength * std::cos(hipPitch));
-            float kneeZ = hipZ + (leg.hipLength * std::sin(hipPitch));
-
-            // Total pitch for the second link (knee + hipPitch)
-            float link2Pitch = hipPitch + knee;
-
-            // Ankle (end of second link)
-            //   ankle_xy = knee_xy + dir * (kneeLength * cos(link2Pitch))
-            //   ankle_z  = knee_z  +       (kneeLength * sin(link2Pitch))
-            float ankleX = kneeX + dirX * (leg.kneeLength * std::cos(link2Pitch));
-            float ankleY = kneeY + dirY * (leg.kneeLength * std::cos(link2Pitch));
-            float ankleZ = kneeZ + (leg.kneeLength * std::sin(link2Pitch));
-
-            // Foot (end of third link). We use the same pitch (link2Pitch) for the
-            // foot link in this visualization; the real model may have more DOF.
-            float footX = ankleX + dirX * (leg.footLength * std::cos(link2Pitch));
-            float footY = ankleY + dirY * (leg.footLength * std::cos(link2Pitch));
-            float footZ = ankleZ + (leg.footLength * std::sin(link2Pitch));
-            // Prevent foot from floating above the visible ground plane (clip to z<=0)
-            footZ = std::min(footZ, 0.0f);
-
+void drawCentipede(sf::RenderWindow* window, const pose::PoseBuffer &pose, float resf) {
+    using namespace pose;
+    // Joint positions come from the sim's per-tick pose buffer: no FK here, only projection
+    // and geometry. Legs of the tail segment are not drawn (there is no next segment to
+    // hang them from visually), matching the previous renderer.
+    const size_t segCount = pose.segmentCount();
+    for (size_t i = 0; i + 1 < segCount; ++i) {
+        for (uint32_t l = pose.legBegin[i]; l < pose.legBegin[i + 1]; ++l) {
             // Project 3D joint positions into screen space for drawing.
-            sf::Vector2f coxaEndS = gridToIsoZ(coxaEndX, coxaEndY, hipZ, resf, window);
-            sf::Vector2f kneeS = gridToIsoZ(kneeX, kneeY, kneeZ, resf, window);
-            sf::Vector2f ankleS = gridToIsoZ(ankleX, ankleY, ankleZ, resf, window);
-            sf::Vector2f footS = gridToIsoZ(footX, footY, footZ, resf, window);
+            sf::Vector2f coxaEndS = gridToIsoZ(pose.x[CoxaEnd][l], pose.y[CoxaEnd][l], pose.z[CoxaEnd][l], resf, window);
+            sf::Vector2f kneeS = gridToIsoZ(pose.x[Knee][l], pose.y[Knee][l], pose.z[Knee][l], resf, window);
+            sf::Vector2f ankleS = gridToIsoZ(pose.x[Ankle][l], pose.y[Ankle][l], pose.z[Ankle][l], resf, window);
+            sf::Vector2f footS = gridToIsoZ(pose.x[Foot][l], pose.y[Foot][l], pose.z[Foot][l], resf, window);
 
             // Draw each link as a rotated rectangle from joint A to joint B.
             // The visual length is computed in screen space to ensure consistent
             // thickness regardless of projection.
-            float hipKneeDist = std::sqrt((kneeS.x - coxaEndS.x)*(kneeS.x - coxaEndS.x) + (kneeS.y - coxaEndS.y)*(kneeS.y - coxaEndS.y));
+            float hipKneeDist = fastmath::sqrt((kneeS.x - coxaEndS.x)*(kneeS.x - coxaEndS.x) + (kneeS.y - coxaEndS.y)*(kneeS.y - coxaEndS.y));
             if (hipKneeDist > 0.1f) {
                 sf::RectangleShape seg0(sf::Vector2f(hipKneeDist, resf * 0.12f));
-                float seg0Angle = std::atan2(kneeS.y - coxaEndS.y, kneeS.x - coxaEndS.x) * 180.f / 3.14159f;
+                float seg0Angle = fastmath::atan2(kneeS.y - coxaEndS.y, kneeS.x - coxaEndS.x) * 180.f / 3.14159f;
                 seg0.setRotation(seg0Angle);
                 seg0.setPosition(coxaEndS.x, coxaEndS.y);
                 seg0.setFillColor(sf::Color::Yellow);
                 window->draw(seg0);
             }
 
-            float kneeAnkleDist = std::sqrt((ankleS.x - kneeS.x)*(ankleS.x - kneeS.x) + (ankleS.y - kneeS.y)*(ankleS.y - kneeS.y));
+            float kneeAnkleDist = fastmath::sqrt((ankleS.x - kneeS.x)*(ankleS.x - kneeS.x) + (ankleS.y - kneeS.y)*(ankleS.y - kneeS.y));
             if (kneeAnkleDist > 0.1f) {
                 sf::RectangleShape seg1(sf::Vector2f(kneeAnkleDist, resf * 0.12f));
-                float seg1Angle = std::atan2(ankleS.y - kneeS.y, ankleS.x - kneeS.x) * 180.f / 3.14159f;
+                float seg1Angle = fastmath::atan2(ankleS.y - kneeS.y, ankleS.x - kneeS.x) * 180.f / 3.14159f;
                 seg1.setRotation(seg1Angle);
                 seg1.setPosition(kneeS.x, kneeS.y);
                 seg1.setFillColor(sf::Color::Yellow);
                 window->draw(seg1);
             }
 
-            float ankleFootDist = std::sqrt((footS.x - ankleS.x)*(footS.x - ankleS.x) + (footS.y - ankleS.y)*(footS.y - ankleS.y));
+            float ankleFootDist = fastmath::sqrt((footS.x - ankleS.x)*(footS.x - ankleS.x) + (footS.y - ankleS.y)*(footS.y - ankleS.y));
             if (ankleFootDist > 0.1f) {
                 sf::RectangleShape seg2(sf::Vector2f(ankleFootDist, resf * 0.12f));
-                float seg2Angle = std::atan2(footS.y - ankleS.y, footS.x - ankleS.x) * 180.f / 3.14159f;
+                float seg2Angle = fastmath::atan2(footS.y - ankleS.y, footS.x - ankleS.x) * 180.f / 3.14159f;
                 seg2.setRotation(seg2Angle);
                 seg2.setPosition(ankleS.x, ankleS.y);
                 seg2.setFillColor(sf::Color::Yellow);
@@ -151,8 +85,8 @@ void drawCentipede(sf::RenderWindow* window, const std::vector<Segment> &segment
         }
     }
 
-    for (size_t i=0;i<segments.size();++i) {
-        sf::Vector2f pos = gridToIsoZ(segments[i].x, segments[i].y, bodyZ, resf, window);
+    for (size_t i=0;i<segCount;++i) {
+        sf::Vector2f pos = gridToIsoZ(pose.spineX[i], pose.spineY[i], pose.spineZ[i], resf, window);
         float radius = resf * 0.3f;
         sf::CircleShape joint(radius);
         joint.setFillColor(sf::Color::Blue);
@@ -1,10 +1,11 @@
 #pragma once
 
 #include "../../include/Centipede.hpp"
+#include "../pose/PoseBuffer.hpp"
 #include "Projection.hpp"
 #include <SFML/Graphics.hpp>
 
 namespace drawhelpers {
-    // Draw articulated legs and spine joints for the given segments.
-    void drawCentipede(sf::RenderWindow* window, const std::vector<Segment> &segments, float resf, float bodyZ);
+    // Draw articulated legs and spine joints from the sim's per-tick pose buffer.
+    void drawCentipede(sf::RenderWindow* window, const pose::PoseBuffer &pose, float resf);
 }
@@ -1,5 +1,7 @@
 #include "GridRenderer.hpp"
 #include "Projection.hpp"
+#include "../terrain/Heightfield.hpp"
+#include "../world/World.hpp"
 #include <cmath>
 
 void drawGrid(sf::RenderWindow* window, float resf) {
@@ -35,6 +37,41 @@ void drawGrid(sf::RenderWindow* window, float resf) {
         window->draw(line);
     };
 
+    // Obstacles of the active world: a dark diamond on each blocked cell.
+    if (world::World *w = world::active()) {
+        sf::Color rockColor(90, 80, 70);
+        terrain::Heightfield *field = terrain::active();
+        for (int gy = gy0; gy < gy1; ++gy) {
+            for (int gx = gx0; gx < gx1; ++gx) {
+                if (!(w->cellFlags(gx, gy) & world::kCellObstacle)) continue;
+                sf::ConvexShape cell(4);
+                const float x = static_cast<float>(gx), y = static_cast<float>(gy);
+                const float corners[4][2] = {{x, y}, {x + 1.f, y}, {x + 1.f, y + 1.f}, {x, y + 1.f}};
+                for (int c = 0; c < 4; ++c) {
+                    const float z = field ? field->height(corners[c][0], corners[c][1]) : 0.f;
+                    cell.setPoint(c, gridToIsoZ(corners[c][0], corners[c][1], z, resf, window));
+                }
+                cell.setFillColor(rockColor);
+                window->draw(cell);
+            }
+        }
+    }
+
+    // On terrain, each line follows the ground as a strip through the posts it crosses.
+    if (terrain::Heightfield *field = terrain::active()) {
+        auto drawGroundLine = [&](bool alongY, int fixed, int from, int to) {
+            sf::VertexArray strip(sf::LineStrip);
+            for (int t = from; t <= to; ++t) {
+                const float gx = static_cast<float>(alongY ? fixed : t), gy = static_cast<float>(alongY ? t : fixed);
+                strip.append(sf::Vertex(gridToIsoZ(gx, gy, field->height(gx, gy), resf, window), gridColor));
+            }
+            window->draw(strip);
+        };
+        for (int gx = gx0; gx <= gx1; gx += gridStep) drawGroundLine(true, gx, gy0, gy1);
+        for (int gy = gy0; gy <= gy1; gy += gridStep) drawGroundLine(false, gy, gx0, gx1);
+        return;
+    }
+
     // Constant gx lines.
     for (int gx = gx0; gx <= gx1; gx += gridStep) {
         sf::Vector2f p1 = gridToIso(static_cast<float>(gx), static_cast<float>(gy0), resf, window);
@@ -0,0 +1,76 @@
+#include "PathHistory.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace spine {
+
+void PathHistory::reset(float x, float y, float length, float sampleSpacing) {
+    this->spacing = sampleSpacing;
+    // Enough samples to cover `length`, plus the two a lookup interpolates between.
+    const size_t needed = static_cast<size_t>(std::ceil(length / sampleSpacing)) + 2;
+    size_t cap = 1;
+    while (cap < needed) cap <<= 1;
+    xs.assign(cap, 0.f);
+    ys.assign(cap, 0.f);
+    this->mask = static_cast<uint32_t>(cap - 1);
+    this->count = 0;
+    push(x, y);
+    this->headX = x; this->headY = y;
+    this->pending = 0.f;
+}
+
+void PathHistory::push(float x, float y) {
+    const uint32_t slot = static_cast<uint32_t>(this->count) & this->mask;
+    xs[slot] = x; ys[slot] = y;
+    this->count++;
+}
+
+void PathHistory::advance(float x, float y) {
+    if (xs.empty()) { reset(x, y, 0.f); return; }
+    const float dx = x - this->headX, dy = y - this->headY;
+    const float len = std::sqrt(dx*dx + dy*dy);
+    if (len <= 0.f) return;
+    // Emit a sample every time the path length since the newest one reaches the spacing.
+    float along = this->spacing - this->pending;
+    while (along <= len) {
+        const float t = along / len;
+        push(this->headX + dx * t, this->headY + dy * t);
+        along += this->spacing;
+    }
+    this->pending = len - (along - this->spacing);
+    this->headX = x; this->headY = y;
+}
+
+void PathHistory::sampleBehind(float distance, float &outX, float &outY) const {
+    const uint64_t newest = this->count - 1;
+    const uint32_t n = static_cast<uint32_t>(newest) & this->mask;
+    const float back = distance - this->pending;
+    if (back <= 0.f) {
+        // Between the newest sample and the head.
+        const float t = this->pending > 0.f ? distance / this->pending : 0.f;
+        outX = this->headX + (xs[n] - this->headX) * t;
+        outY = this->headY + (ys[n] - this->headY) * t;
+        return;
+    }
+    const float steps = back / this->spacing;
+    const uint64_t k = static_cast<uint64_t>(steps);
+    const uint64_t oldest = std::min<uint64_t>(newest, this->mask);
+    if (k >= oldest) {
+        const uint32_t o = static_cast<uint32_t>(newest - oldest) & this->mask;
+        outX = xs[o]; outY = ys[o];
+        return;
+    }
+    const float frac = steps - static_cast<float>(k);
+    const uint32_t a = static_cast<uint32_t>(newest - k) & this->mask;
+    const uint32_t b = static_cast<uint32_t>(newest - k - 1) & this->mask;
+    outX = xs[a] + (xs[b] - xs[a]) * frac;
+    outY = ys[a] + (ys[b] - ys[a]) * frac;
+}
+
+void PathHistory::translate(float dx, float dy) {
+    for (float &x : xs) x += dx;
+    for (float &y : ys) y += dy;
+    this->headX += dx; this->headY += dy;
+}
+
+} // namespace spine
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace spine {
+
+// Arc-length spacing of the recorded head path (grid units).
+inline constexpr float kPathSpacing = 0.25f;
+
+// The path the head has travelled, resampled at a fixed arc-length spacing into a ring
+// buffer. Followers look up their target by distance behind the head: sample index and
+// blend come straight from the distance, so a lookup is O(1) however long the body is,
+// and the spacing it gives does not depend on how many moves (or ticks) covered it.
+//
+// Samples are points on the head's polyline; between two samples the path is taken as
+// the straight chord, which cuts corners by at most a fraction of `kPathSpacing`.
+class PathHistory {
+private:
+    // Ring of samples, newest at `count - 1`; capacity is a power of two.
+    std::vector<float> xs, ys;
+    uint32_t mask = 0;
+    uint64_t count = 0;
+    float spacing = kPathSpacing;
+    // Current head position and the path length from the newest sample to it (< spacing).
+    float headX = 0.f, headY = 0.f;
+    float pending = 0.f;
+
+    void push(float x, float y);
+
+public:
+    // Start a new path at (x, y), keeping at least `length` grid units of history.
+    void reset(float x, float y, float length, float sampleSpacing = kPathSpacing);
+    // The head moved (in a straight line) to (x, y).
+    void advance(float x, float y);
+    // Point `distance` behind the head along the path; past the oldest sample, the
+    // oldest sample.
+    void sampleBehind(float distance, float &outX, float &outY) const;
+    // Move the whole path by (dx, dy) (the floating origin moved).
+    void translate(float dx, float dy);
+
+    size_t capacity() const { return xs.size(); }
+    size_t sampleCount() const { return count < xs.size() ? static_cast<size_t>(count) : xs.size(); }
+};
+
+} // namespace spine
@@ -0,0 +1,137 @@
+#include "Heightfield.hpp"
+#include "../math/FastMath.hpp"
+#include "../world/World.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace terrain {
+
+static Heightfield *s_active = nullptr;
+
+void setActive(Heightfield *field) { s_active = field; }
+Heightfield *active() { return s_active; }
+
+float groundHeight(float x, float y) { return s_active ? s_active->height(x, y) : 0.f; }
+
+static uint64_t chunkKey(int64_t cx, int64_t cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+// Lattice value in [-1, 1] for integer point (x, y) of noise layer `layer`.
+static float latticeValue(int64_t x, int64_t y, uint32_t seed, int layer) {
+    uint32_t h = static_cast<uint32_t>(x) * 0x8da6b343u ^ static_cast<uint32_t>(y) * 0xd8163841u
+                 ^ (seed + static_cast<uint32_t>(layer)) * 0xcb1ab31fu;
+    h ^= h >> 15; h *= 0x2c1b3c6du;
+    h ^= h >> 12; h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return static_cast<float>(h & 0xffffffu) * (2.f / 16777215.f) - 1.f;
+}
+
+Heightfield::Heightfield(const HeightfieldParams &p) : params(p) {
+    this->params.cellSize = std::max(p.cellSize, 1e-3f);
+    this->invCell = 1.f / this->params.cellSize;
+}
+
+void Heightfield::attach(world::World *world, int cells) {
+    this->owner = world;
+    this->chunkCells = world ? cells : kChunkCells;
+    this->chunks.clear();
+    this->lastChunk = nullptr;
+}
+
+// Value noise at post (px, py): octaves of smoothly interpolated lattice values, each
+// half the size and amplitude of the last.
+float Heightfield::generatedHeight(int64_t px, int64_t py) const {
+    float sum = 0.f, amp = 1.f, norm = 0.f;
+    float period = std::max(this->params.featureCells, 1.f);
+    for (int o = 0; o < std::max(this->params.octaves, 1); ++o) {
+        const float fx = static_cast<float>(px) / period, fy = static_cast<float>(py) / period;
+        const float x0 = std::floor(fx), y0 = std::floor(fy);
+        const int64_t ix = static_cast<int64_t>(x0), iy = static_cast<int64_t>(y0);
+        float tx = fx - x0, ty = fy - y0;
+        tx = tx * tx * (3.f - 2.f * tx);
+        ty = ty * ty * (3.f - 2.f * ty);
+        const float v00 = latticeValue(ix, iy, this->params.seed, o), v10 = latticeValue(ix + 1, iy, this->params.seed, o);
+        const float v01 = latticeValue(ix, iy + 1, this->params.seed, o), v11 = latticeValue(ix + 1, iy + 1, this->params.seed, o);
+        const float top = v00 + (v10 - v00) * tx, bottom = v01 + (v11 - v01) * tx;
+        sum += amp * (top + (bottom - top) * ty);
+        norm += amp;
+        amp *= 0.5f;
+        period = std::max(period * 0.5f, 1.f);
+    }
+    return this->params.amplitude * sum / norm;
+}
+
+const float *Heightfield::chunkPosts(int64_t cx, int64_t cy) {
+    if (this->owner) return this->owner->posts(cx, cy);
+    if (this->lastChunk && cx == this->lastCx && cy == this->lastCy) return this->lastChunk->posts.data();
+    auto [it, inserted] = this->chunks.try_emplace(chunkKey(cx, cy));
+    if (inserted) {
+        constexpr int side = kChunkCells + 1;
+        it->second.posts.resize(static_cast<size_t>(side) * side);
+        for (int j = 0; j < side; ++j) {
+            for (int i = 0; i < side; ++i) {
+                it->second.posts[static_cast<size_t>(j) * side + i] = generatedHeight(cx * kChunkCells + i, cy * kChunkCells + j);
+            }
+        }
+        this->stats.chunksBuilt++;
+    }
+    // Map nodes are stable, so the pointer survives later insertions.
+    this->lastCx = cx;
+    this->lastCy = cy;
+    this->lastChunk = &it->second;
+    return it->second.posts.data();
+}
+
+void Heightfield::loadCell(int64_t px, int64_t py, SampleCache &cell) {
+    this->stats.samples++;
+    // Floor division into chunk and cell within it.
+    const int cells = this->chunkCells;
+    const int64_t cx = px >= 0 ? px / cells : (px - (cells - 1)) / cells;
+    const int64_t cy = py >= 0 ? py / cells : (py - (cells - 1)) / cells;
+    const int i = static_cast<int>(px - cx * cells), j = static_cast<int>(py - cy * cells);
+
+    const int side = cells + 1;
+    const float *row = chunkPosts(cx, cy) + static_cast<size_t>(j) * side + i;
+    cell.px = px;
+    cell.py = py;
+    cell.h00 = row[0];
+    cell.h10 = row[1];
+    cell.h01 = row[side];
+    cell.h11 = row[side + 1];
+    cell.valid = true;
+}
+
+GroundSample Heightfield::patch(const SampleCache &cell, float tx, float ty) const {
+    GroundSample s;
+    const float top = cell.h00 + (cell.h10 - cell.h00) * tx, bottom = cell.h01 + (cell.h11 - cell.h01) * tx;
+    s.z = top + (bottom - top) * ty;
+    // Gradient of the bilinear patch; the normal is (-dz/dx, -dz/dy, 1) normalized.
+    const float dzdx = ((cell.h10 - cell.h00) * (1.f - ty) + (cell.h11 - cell.h01) * ty) * this->invCell;
+    const float dzdy = (bottom - top) * this->invCell;
+    const float inv = 1.f / fastmath::sqrt(dzdx * dzdx + dzdy * dzdy + 1.f);
+    s.nx = -dzdx * inv;
+    s.ny = -dzdy * inv;
+    s.nz = inv;
+    return s;
+}
+
+GroundSample Heightfield::sample(float x, float y) {
+    const float gx = x * this->invCell, gy = y * this->invCell;
+    const float fx0 = std::floor(gx), fy0 = std::floor(gy);
+    SampleCache cell;
+    loadCell(static_cast<int64_t>(fx0) + this->originPx, static_cast<int64_t>(fy0) + this->originPy, cell);
+    return patch(cell, gx - fx0, gy - fy0);
+}
+
+GroundSample Heightfield::sampleCached(SampleCache &cache, float x, float y) {
+    this->stats.queries++;
+    const float gx = x * this->invCell, gy = y * this->invCell;
+    const float fx0 = std::floor(gx), fy0 = std::floor(gy);
+    const int64_t px = static_cast<int64_t>(fx0) + this->originPx, py = static_cast<int64_t>(fy0) + this->originPy;
+    if (cache.valid && cache.px == px && cache.py == py) this->stats.cacheHits++;
+    else loadCell(px, py, cache);
+    return patch(cache, gx - fx0, gy - fy0);
+}
+
+} // namespace terrain
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace world { class World; }
+
+namespace terrain {
+
+// Cells along each side of a chunk (of a heightfield that stores its own posts).
+inline constexpr int kChunkCells = 32;
+
+struct HeightfieldParams {
+    float cellSize = 1.f;       // grid units per cell
+    float amplitude = 0.6f;     // peak height of the generated relief (grid units)
+    float featureCells = 12.f;  // size of the largest bumps, in cells
+    int octaves = 3;
+    uint32_t seed = 1;
+};
+
+// Height and unit surface normal at a point.
+struct GroundSample {
+    float z = 0.f;
+    float nx = 0.f, ny = 0.f, nz = 1.f;
+};
+
+// Cell of the last query of one foot: its low corner post (absolute, so a rebase leaves
+// it valid) and its four post heights. See `sampleCached`.
+struct SampleCache {
+    int64_t px = 0, py = 0;
+    float h00 = 0.f, h10 = 0.f, h01 = 0.f, h11 = 0.f;
+    bool valid = false;
+};
+
+// Query counters since the last reset.
+struct SampleStats {
+    size_t queries = 0;      // sampleCached calls
+    size_t cacheHits = 0;    // ... answered from the cache
+    size_t samples = 0;      // bilinear samples taken (misses and direct `sample` calls)
+    size_t chunksBuilt = 0;
+};
+
+// Ground heights on a regular grid of posts, stored in square chunks of kChunkCells
+// cells that are generated (value noise) the first time a query touches them. Each chunk
+// keeps its far border row and column of posts as well, so a cell's four posts are always
+// in one chunk and a sample is a single chunk lookup plus four loads.
+//
+// Height is bilinear within a cell, and the normal is that of the bilinear patch at the
+// query point (its gradient), so both are continuous in position.
+//
+// Attached to a world::World, the posts come from the world's chunks instead (same
+// layout, the world's chunk size), which stream in and out of memory with the rest of
+// the world; the heightfield then only generates posts for the world to store.
+class Heightfield {
+private:
+    struct Chunk {
+        std::vector<float> posts;  // (kChunkCells + 1)^2, row-major
+    };
+
+    HeightfieldParams params;
+    float invCell = 1.f;
+    std::unordered_map<uint64_t, Chunk> chunks;
+    // Chunk of the last sample: consecutive queries mostly land in the same one.
+    int64_t lastCx = 0, lastCy = 0;
+    const Chunk *lastChunk = nullptr;
+    SampleStats stats;
+    world::World *owner = nullptr;
+    int chunkCells = kChunkCells;
+    // Floating origin: post of the local point (0, 0). Queries take local coordinates.
+    int64_t originPx = 0, originPy = 0;
+
+    const float *chunkPosts(int64_t cx, int64_t cy);
+    // Load the four posts of the cell whose low corner is post (px, py).
+    void loadCell(int64_t px, int64_t py, SampleCache &cell);
+    // Height and normal of a cell's bilinear patch at (tx, ty) in [0, 1]^2.
+    GroundSample patch(const SampleCache &cell, float tx, float ty) const;
+
+public:
+    explicit Heightfield(const HeightfieldParams &params = HeightfieldParams{});
+
+    // Serve posts from `world` (chunks of `cells` cells) instead of own chunks; nullptr
+    // detaches.
+    void attach(world::World *world, int cells);
+    // Generated height of post (px, py) (value noise; the same for every query).
+    float generatedHeight(int64_t px, int64_t py) const;
+    // Put local (0, 0) at post (px, py) (see world::World::rebaseToward).
+    void setOrigin(int64_t px, int64_t py) { originPx = px; originPy = py; }
+
+
+    // Height and normal at local grid point (x, y).
+    GroundSample sample(float x, float y);
+    float height(float x, float y) { return sample(x, y).z; }
+
+    // As `sample`, but keeps the posts of the queried cell in `cache`: a query in the same
+    // cell skips the chunk lookup and the loads. The result is exactly `sample`'s either
+    // way, so it does not depend on what the cache held.
+    GroundSample sampleCached(SampleCache &cache, float x, float y);
+
+    float cellSize() const { return params.cellSize; }
+    size_t chunkCount() const { return chunks.size(); }
+    const SampleStats &sampleStats() const { return stats; }
+    void resetStats() { stats = SampleStats{}; }
+};
+
+// Terrain the gait plants feet on; nullptr (the default) is the flat plane z = 0.
+void setActive(Heightfield *field);
+Heightfield *active();
+
+// Ground height at (x, y) on the active terrain (0 without one).
+float groundHeight(float x, float y);
+
+} // namespace terrain
@@ -0,0 +1,162 @@
+#include "ChunkStore.hpp"
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace world {
+
+static constexpr uint32_t kStoreMagic = 0x4b484357u; // "WCHK"
+static constexpr uint32_t kStoreVersion = 1;
+static constexpr uint64_t kInitialSlots = 64;
+
+#ifdef _WIN32
+
+bool ChunkStore::map(size_t bytes) {
+    if (this->maxFileBytes != 0 && bytes > this->maxFileBytes) return false;
+    // A mapping larger than the file extends it (SetEndOfFile is refused while a view is mapped).
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(bytes);
+    void *m = CreateFileMappingA(this->file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    if (!m) return false;
+    void *view = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!view) { CloseHandle(m); return false; }
+    unmap();
+    this->mapping = m;
+    this->base = static_cast<uint8_t *>(view);
+    this->mappedBytes = bytes;
+    return true;
+}
+
+void ChunkStore::unmap() {
+    if (this->base) UnmapViewOfFile(this->base);
+    if (this->mapping) CloseHandle(this->mapping);
+    this->base = nullptr;
+    this->mapping = nullptr;
+    this->mappedBytes = 0;
+}
+
+#else
+
+bool ChunkStore::map(size_t bytes) {
+    if (this->maxFileBytes != 0 && bytes > this->maxFileBytes) return false;
+    // Only ever grows the file, so the current mapping stays valid if this fails.
+    if (bytes > this->mappedBytes && ftruncate(this->fd, static_cast<off_t>(bytes)) != 0) return false;
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (p == MAP_FAILED) return false;
+    unmap();
+    this->base = static_cast<uint8_t *>(p);
+    this->mappedBytes = bytes;
+    return true;
+}
+
+void ChunkStore::unmap() {
+    if (this->base) munmap(this->base, this->mappedBytes);
+    this->base = nullptr;
+    this->mappedBytes = 0;
+}
+
+#endif
+
+bool ChunkStore::open(const std::string &filePath, size_t bytes, size_t maxBytes) {
+    close();
+    this->path = filePath;
+    this->recordBytes = bytes;
+    this->maxFileBytes = maxBytes;
+
+    size_t existing = 0;
+#ifdef _WIN32
+    this->file = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) { this->file = nullptr; return false; }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(this->file, &size)) existing = static_cast<size_t>(size.QuadPart);
+#else
+    this->fd = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (this->fd < 0) return false;
+    struct stat st;
+    if (fstat(this->fd, &st) == 0) existing = static_cast<size_t>(st.st_size);
+#endif
+
+    if (existing < sizeof(Header)) {
+        // New store: header and the first block of empty slots.
+        if (!map(sizeof(Header) + kInitialSlots * slotBytes())) { close(); return false; }
+        std::memset(this->base, 0, this->mappedBytes);
+        header() = Header{kStoreMagic, kStoreVersion, bytes, kInitialSlots, 0};
+        return true;
+    }
+
+    if (!map(existing)) { close(); return false; }
+    const Header &h = header();
+    if (h.magic != kStoreMagic || h.version != kStoreVersion || h.recordBytes != bytes
+        || sizeof(Header) + h.slotCount * slotBytes() > existing || h.slotsUsed > h.slotCount) {
+        close();
+        return false;
+    }
+    for (uint64_t i = 0; i < h.slotsUsed; ++i) {
+        const SlotHeader *s = reinterpret_cast<const SlotHeader *>(slot(i));
+        if (s->used) this->index[s->key] = i;
+    }
+    return true;
+}
+
+void ChunkStore::close() {
+    unmap();
+#ifdef _WIN32
+    if (this->file) CloseHandle(this->file);
+    this->file = nullptr;
+#else
+    if (this->fd >= 0) ::close(this->fd);
+    this->fd = -1;
+#endif
+    this->index.clear();
+}
+
+bool ChunkStore::grow() {
+    const uint64_t slots = header().slotCount * 2;
+    const size_t bytes = sizeof(Header) + slots * slotBytes();
+    // The current mapping is only released once the larger one is in place, so a failed
+    // grow leaves every stored record where it was.
+    if (!map(bytes)) return false;
+    header().slotCount = slots;
+    return true;
+}
+
+bool ChunkStore::read(uint64_t key, void *out) const {
+    if (!this->base) return false;
+    auto it = this->index.find(key);
+    if (it == this->index.end()) return false;
+    const uint8_t *s = this->base + sizeof(Header) + it->second * slotBytes();
+    std::memcpy(out, s + sizeof(SlotHeader), this->recordBytes);
+    return true;
+}
+
+bool ChunkStore::write(uint64_t key, const void *record) {
+    if (!this->base) return false;
+    uint64_t i;
+    auto it = this->index.find(key);
+    if (it != this->index.end()) {
+        i = it->second;
+    } else {
+        if (header().slotsUsed == header().slotCount && !grow()) return false;
+        i = header().slotsUsed++;
+        this->index[key] = i;
+    }
+    uint8_t *s = slot(i);
+    *reinterpret_cast<SlotHeader *>(s) = SlotHeader{key, 1};
+    std::memcpy(s + sizeof(SlotHeader), record, this->recordBytes);
+    return true;
+}
+
+} // namespace world
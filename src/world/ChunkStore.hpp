@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace world {
+
+// Fixed-size chunk records in one memory-mapped file, keyed by a 64-bit chunk key.
+//
+// Layout: a header, then slots of (key, used flag, record bytes). Slots are handed out in
+// order and never move, so a record keeps its slot for good; the key -> slot index is
+// rebuilt by scanning the used slots when the file is opened. When the slots run out
+// the file doubles and is mapped again (the old mapping is kept until the new one is in
+// place, so a store that cannot grow stays open with its records). Reads and writes are
+// plain copies through the mapping; the OS pages records in and out, so the store is
+// bounded by disk (or an optional cap on the file size), not RAM.
+class ChunkStore {
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t recordBytes;
+        uint64_t slotCount;  // slots the file has room for
+        uint64_t slotsUsed;
+    };
+    struct SlotHeader {
+        uint64_t key;
+        uint64_t used;
+    };
+
+    std::string path;
+    size_t recordBytes = 0;
+    uint8_t *base = nullptr;
+    size_t mappedBytes = 0;
+    size_t maxFileBytes = 0;  // 0 = no cap
+    std::unordered_map<uint64_t, uint64_t> index;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    size_t slotBytes() const { return sizeof(SlotHeader) + recordBytes; }
+    Header &header() { return *reinterpret_cast<Header *>(base); }
+    uint8_t *slot(uint64_t i) { return base + sizeof(Header) + i * slotBytes(); }
+    // Map the file at `bytes` (extending it), replacing the current mapping only on success.
+    bool map(size_t bytes);
+    void unmap();
+    bool grow();
+
+public:
+    ChunkStore() = default;
+    ChunkStore(const ChunkStore &) = delete;
+    ChunkStore &operator=(const ChunkStore &) = delete;
+    ~ChunkStore() { close(); }
+
+    // Open (or create) the store at `path` for records of `bytes` bytes, never growing the
+    // file past `maxBytes` (0 = no cap). Fails if the file holds records of another size
+    // or cannot be mapped within the cap.
+    bool open(const std::string &filePath, size_t bytes, size_t maxBytes = 0);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    bool contains(uint64_t key) const { return index.count(key) != 0; }
+    // Copy the record of `key` into `out`; false if the store has none.
+    bool read(uint64_t key, void *out) const;
+    // Store `record` under `key` (replacing an earlier one). False if the file could not grow
+    // (the store stays open and keeps its records).
+    bool write(uint64_t key, const void *record);
+
+    size_t recordCount() const { return index.size(); }
+    size_t fileBytes() const { return mappedBytes; }
+};
+
+} // namespace world
@@ -0,0 +1,182 @@
+#include "World.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace world {
+
+static World *s_active = nullptr;
+
+void setActive(World *world) { s_active = world; }
+World *active() { return s_active; }
+
+static uint64_t chunkKey(int64_t cx, int64_t cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+static int64_t floorDiv(int64_t v, int64_t d) {
+    return v >= 0 ? v / d : (v - (d - 1)) / d;
+}
+
+// Whether cell (gx, gy) seeds a rock (hash below the density threshold).
+static bool rockSeed(int64_t gx, int64_t gy, uint32_t seed, float density) {
+    uint32_t h = static_cast<uint32_t>(gx) * 0x9e3779b1u ^ static_cast<uint32_t>(gy) * 0x85ebca77u ^ seed * 0xc2b2ae3du;
+    h ^= h >> 16; h *= 0x7feb352du;
+    h ^= h >> 15; h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return static_cast<float>(h & 0xffffffu) < density * 16777216.f;
+}
+
+World::World(const WorldParams &p) : params(p), heights(p.ground) {
+    this->params.maxResident = std::max<size_t>(p.maxResident, 1);
+    this->heights.attach(this, kChunkCells);
+    if (!p.storePath.empty()) this->store.open(p.storePath, sizeof(ChunkData), p.storeMaxBytes);
+}
+
+World::~World() {
+    flush();
+    if (s_active == this) s_active = nullptr;
+}
+
+// Terrain posts from the heightfield's generator; a rock covers its seed cell and the
+// four cells next to it (seeds are looked up globally, so rocks cross chunk borders).
+void World::generate(Chunk &chunk) {
+    constexpr int side = kChunkCells + 1;
+    const int64_t x0 = chunk.cx * kChunkCells, y0 = chunk.cy * kChunkCells;
+    for (int j = 0; j < side; ++j) {
+        for (int i = 0; i < side; ++i) chunk.data.posts[j * side + i] = this->heights.generatedHeight(x0 + i, y0 + j);
+    }
+    const uint32_t seed = this->params.seed;
+    const float density = this->params.obstacleDensity;
+    for (int j = 0; j < kChunkCells; ++j) {
+        for (int i = 0; i < kChunkCells; ++i) {
+            const int64_t gx = x0 + i, gy = y0 + j;
+            const bool rock = rockSeed(gx, gy, seed, density) || rockSeed(gx - 1, gy, seed, density) || rockSeed(gx + 1, gy, seed, density)
+                              || rockSeed(gx, gy - 1, seed, density) || rockSeed(gx, gy + 1, seed, density);
+            chunk.data.cells[j * kChunkCells + i] = rock ? kCellObstacle : 0;
+        }
+    }
+}
+
+bool World::evictOne() {
+    const uint64_t key = this->lru.back();
+    auto it = this->resident.find(key);
+    Chunk &chunk = *it->second;
+    if (chunk.dirty && this->store.isOpen()) {
+        if (!this->store.write(key, &chunk.data)) {
+            // Dropping it would lose its changes: keep it, as most recently used.
+            this->lru.splice(this->lru.begin(), this->lru, chunk.lru);
+            this->stats.writeFailed++;
+            return false;
+        }
+        this->stats.written++;
+    }
+    if (this->last == &chunk) this->last = nullptr;
+    this->lru.pop_back();
+    this->resident.erase(it);
+    this->stats.evicted++;
+    return true;
+}
+
+World::Chunk &World::acquire(int64_t cx, int64_t cy) {
+    if (this->last && this->last->cx == cx && this->last->cy == cy) return *this->last;
+    const uint64_t key = chunkKey(cx, cy);
+    auto it = this->resident.find(key);
+    if (it != this->resident.end()) {
+        Chunk &chunk = *it->second;
+        this->lru.splice(this->lru.begin(), this->lru, chunk.lru);
+        this->last = &chunk;
+        return chunk;
+    }
+
+    // Each chunk is tried once: ones the store cannot take stay, past the limit.
+    for (size_t tries = this->resident.size(); tries && this->resident.size() >= this->params.maxResident; --tries) {
+        evictOne();
+    }
+    auto owned = std::make_unique<Chunk>();
+    Chunk &chunk = *owned;
+    chunk.cx = cx;
+    chunk.cy = cy;
+    if (this->store.isOpen() && this->store.read(key, &chunk.data)) {
+        chunk.dirty = false;
+        this->stats.loaded++;
+    } else {
+        generate(chunk);
+        chunk.dirty = true;
+        this->stats.generated++;
+    }
+    this->lru.push_front(key);
+    chunk.lru = this->lru.begin();
+    this->resident.emplace(key, std::move(owned));
+    this->last = &chunk;
+    return chunk;
+}
+
+void World::streamAround(float x, float y, float radius) {
+    const float cellSize = this->heights.cellSize();
+    const float span = static_cast<float>(kChunkCells) * cellSize;
+    const int64_t cx0 = static_cast<int64_t>(std::floor((x - radius) / span)) + this->originCx;
+    const int64_t cx1 = static_cast<int64_t>(std::floor((x + radius) / span)) + this->originCx;
+    const int64_t cy0 = static_cast<int64_t>(std::floor((y - radius) / span)) + this->originCy;
+    const int64_t cy1 = static_cast<int64_t>(std::floor((y + radius) / span)) + this->originCy;
+    for (int64_t cy = cy0; cy <= cy1; ++cy) {
+        for (int64_t cx = cx0; cx <= cx1; ++cx) acquire(cx, cy);
+    }
+}
+
+const float *World::posts(int64_t cx, int64_t cy) {
+    return acquire(cx, cy).data.posts;
+}
+
+uint8_t World::cellFlags(int64_t gx, int64_t gy) {
+    gx += this->originCx * kChunkCells;
+    gy += this->originCy * kChunkCells;
+    const int64_t cx = floorDiv(gx, kChunkCells), cy = floorDiv(gy, kChunkCells);
+    const Chunk &chunk = acquire(cx, cy);
+    return chunk.data.cells[(gy - cy * kChunkCells) * kChunkCells + (gx - cx * kChunkCells)];
+}
+
+void World::setCellFlags(int64_t gx, int64_t gy, uint8_t flags) {
+    gx += this->originCx * kChunkCells;
+    gy += this->originCy * kChunkCells;
+    const int64_t cx = floorDiv(gx, kChunkCells), cy = floorDiv(gy, kChunkCells);
+    Chunk &chunk = acquire(cx, cy);
+    uint8_t &cell = chunk.data.cells[(gy - cy * kChunkCells) * kChunkCells + (gx - cx * kChunkCells)];
+    if (cell != flags) {
+        cell = flags;
+        chunk.dirty = true;
+    }
+}
+
+bool World::blocked(float x, float y) {
+    const float inv = 1.f / this->heights.cellSize();
+    const int64_t gx = static_cast<int64_t>(std::floor(x * inv)), gy = static_cast<int64_t>(std::floor(y * inv));
+    return (cellFlags(gx, gy) & kCellObstacle) != 0;
+}
+
+bool World::rebaseToward(float x, float y, float &shiftX, float &shiftY) {
+    const float span = static_cast<float>(kChunkCells) * this->heights.cellSize();
+    const float limit = static_cast<float>(kRebaseChunks) * span;
+    if (std::fabs(x) <= limit && std::fabs(y) <= limit) return false;
+    const int64_t dcx = static_cast<int64_t>(std::floor(x / span)), dcy = static_cast<int64_t>(std::floor(y / span));
+    this->originCx += dcx;
+    this->originCy += dcy;
+    this->heights.setOrigin(this->originCx * kChunkCells, this->originCy * kChunkCells);
+    shiftX = static_cast<float>(dcx) * span;
+    shiftY = static_cast<float>(dcy) * span;
+    return true;
+}
+
+void World::flush() {
+    if (!this->store.isOpen()) return;
+    for (auto &[key, chunk] : this->resident) {
+        if (!chunk->dirty) continue;
+        if (this->store.write(key, &chunk->data)) {
+            chunk->dirty = false;
+            this->stats.written++;
+        } else {
+            this->stats.writeFailed++;
+        }
+    }
+}
+
+} // namespace world
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "ChunkStore.hpp"
+#include "../terrain/Heightfield.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace world {
+
+// Cells along each side of a world chunk.
+inline constexpr int kChunkCells = 64;
+
+// Floating origin: the origin moves once a body is this many chunks from it.
+inline constexpr int kRebaseChunks = 2;
+
+// Per-cell occupancy flags.
+enum CellFlags : uint8_t {
+    kCellObstacle = 1,  // rock: bodies cannot enter the cell
+};
+
+struct WorldParams {
+    terrain::HeightfieldParams ground;
+    float obstacleDensity = 0.004f;  // fraction of cells that seed a rock
+    uint32_t seed = 1;
+    size_t maxResident = 64;         // chunks kept in memory (LRU beyond that)
+    std::string storePath;           // on-disk chunk store; empty = regenerate evicted chunks
+    size_t storeMaxBytes = 0;        // cap on the store file (0 = disk space only)
+};
+
+// Streaming counters since the last reset.
+struct WorldStats {
+    size_t generated = 0;  // chunks built from the generator
+    size_t loaded = 0;     // ... read back from the store
+    size_t evicted = 0;
+    size_t written = 0;    // evictions (and flushes) that wrote to the store
+    size_t writeFailed = 0;  // writes the store refused (the chunk stayed resident and dirty)
+};
+
+// An unbounded world in square chunks of kChunkCells cells, each holding the terrain
+// posts of its cells (with the far border, as terrain::Heightfield lays them out) and a
+// flag byte per cell (occupancy / obstacles).
+//
+// Only up to `maxResident` chunks live in memory. Touching a chunk (any query, or
+// `streamAround`) makes it most recently used; a chunk that is not resident is read back
+// from the store, or generated the first time. Past the limit the least recently used
+// chunk is evicted: written to the memory-mapped store if it changed since it was last
+// stored, then dropped. A changed chunk the store cannot take (disk full, or the store at
+// its cap) stays resident, past the limit if need be, and is counted in `writeFailed`.
+// World size is bounded by the store's disk space, not by RAM.
+//
+// Positions and cells passed in and out are local: relative to an integer origin chunk,
+// so floats stay small (and precise) however far the world extends. `rebaseToward` moves
+// the origin; chunk coordinates (`posts`) and the store's keys are absolute.
+class World {
+public:
+    struct ChunkData {
+        float posts[(kChunkCells + 1) * (kChunkCells + 1)];
+        uint8_t cells[kChunkCells * kChunkCells];
+    };
+
+private:
+    struct Chunk {
+        int64_t cx = 0, cy = 0;
+        bool dirty = false;  // differs from the store's copy (or the store has none)
+        std::list<uint64_t>::iterator lru;
+        ChunkData data;
+    };
+
+    WorldParams params;
+    terrain::Heightfield heights;
+    ChunkStore store;
+    std::unordered_map<uint64_t, std::unique_ptr<Chunk>> resident;
+    std::list<uint64_t> lru;  // most recently used first
+    // Chunk of the last query: repeated queries skip the map and the LRU splice.
+    Chunk *last = nullptr;
+    WorldStats stats;
+    int64_t originCx = 0, originCy = 0;
+
+    Chunk &acquire(int64_t cx, int64_t cy);
+    void generate(Chunk &chunk);
+    bool evictOne();
+
+public:
+    explicit World(const WorldParams &params = WorldParams{});
+    World(const World &) = delete;
+    World &operator=(const World &) = delete;
+    ~World();
+
+    // Terrain of the world (samples through the resident chunks).
+    terrain::Heightfield &ground() { return heights; }
+
+    // Make every chunk within `radius` grid units of (x, y) resident and recently used.
+    // Call for each active body and the camera before the tick's queries.
+    void streamAround(float x, float y, float radius);
+
+    // Posts of absolute chunk (cx, cy) in terrain::Heightfield layout (valid until the
+    // next query).
+    const float *posts(int64_t cx, int64_t cy);
+    // Flags of local cell (gx, gy).
+    uint8_t cellFlags(int64_t gx, int64_t gy);
+    void setCellFlags(int64_t gx, int64_t gy, uint8_t flags);
+    // True if the cell under local grid point (x, y) holds an obstacle.
+    bool blocked(float x, float y);
+
+    // If local point (x, y) is more than kRebaseChunks chunks from the origin, move the
+    // origin to the chunk holding it and return true with the move in grid units: every
+    // local position kept outside the world must then have (shiftX, shiftY) subtracted
+    // (see Centipede::rebase). The shift is whole chunks, so cells keep their indices
+    // modulo the chunk size and positions near the new origin shift exactly.
+    bool rebaseToward(float x, float y, float &shiftX, float &shiftY);
+    int64_t originChunkX() const { return originCx; }
+    int64_t originChunkY() const { return originCy; }
+
+    // Write every changed resident chunk to the store.
+    void flush();
+
+    size_t residentCount() const { return resident.size(); }
+    bool hasStore() const { return store.isOpen(); }
+    size_t storedCount() const { return store.recordCount(); }
+    size_t storeBytes() const { return store.fileBytes(); }
+    const WorldStats &worldStats() const { return stats; }
+    void resetStats() { stats = WorldStats{}; }
+};
+
+// World the bodies walk in; nullptr (the default) is an empty, unbounded plane.
+void setActive(World *world);
+World *active();
+
+} // namespace world